@@ -0,0 +1,311 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Collector benchmarks on synthetic /proc trees
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Collector.hpp>
+#include <Process.hpp>
+#include <ProcessCache.hpp>
+#include <Writer.hpp>
+#include <array>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace {
+/*
+ * Trees are generated once and left in the temp directory, so only the
+ * first run pays for them. Bump this whenever their contents change.
+ */
+constexpr int tree_version = 1;
+
+constexpr std::array<const char*, 8> names { "systemd", "bash",
+    "Web Content", "firefox", "kworker/3:1-events", "surfaceflinger",
+    "com.android.systemui", "(sd-pam)" };
+
+constexpr std::array<const char*, 20> smaps_keys { "Rss", "Pss", "Pss_Anon",
+    "Pss_File", "Pss_Shmem", "Shared_Clean", "Shared_Dirty", "Private_Clean",
+    "Private_Dirty", "Referenced", "Anonymous", "LazyFree", "AnonHugePages",
+    "ShmemPmdMapped", "FilePmdMapped", "Shared_Hugetlb", "Private_Hugetlb",
+    "Swap", "SwapPss", "Locked" };
+
+/* Stands in for the output files, so formatting still gets measured */
+class Discard : public std::streambuf {
+protected:
+    auto overflow(int_type c) -> int_type override
+    {
+        return traits_type::not_eof(c);
+    }
+
+    auto xsputn(const char*, std::streamsize n) -> std::streamsize override
+    {
+        return n;
+    }
+};
+
+auto write_file(const std::filesystem::path& path, std::string_view text)
+    -> void
+{
+    std::ofstream { path, std::ios::binary }.write(text.data(), text.size());
+}
+
+auto write_system(const std::filesystem::path& root) -> void
+{
+    constexpr int num_cpus = 8;
+    std::string stat = "cpu  4705 356 584 3699176 23060 0 277 0 0 0\n";
+    std::string cpuinfo;
+
+    for (int cpu = 0; cpu < num_cpus; cpu++) {
+        stat += "cpu" + std::to_string(cpu)
+            + " 588 44 73 462397 2882 0 34 0 0 0\n";
+        cpuinfo += "processor\t: " + std::to_string(cpu) + "\n\n";
+    }
+
+    stat += "intr 1462898 0 0 0\nctxt 2793402\nbtime 1650000000\n";
+
+    write_file(root / "stat", stat);
+    write_file(root / "cpuinfo", cpuinfo);
+    write_file(root / "loadavg", "0.52 0.58 0.59 3/1209 274811\n");
+    write_file(root / "meminfo",
+        "MemTotal:       16303424 kB\n"
+        "MemFree:         6812248 kB\n"
+        "MemAvailable:   11120148 kB\n"
+        "Buffers:          338092 kB\n"
+        "Cached:          4303888 kB\n"
+        "SwapCached:            0 kB\n"
+        "SwapTotal:       8388604 kB\n"
+        "SwapFree:        8388604 kB\n"
+        "AnonPages:       4418768 kB\n"
+        "Mapped:          1036452 kB\n"
+        "Shmem:            350140 kB\n"
+        "Slab:             560920 kB\n");
+}
+
+/*
+ * A /proc with `count' processes, one in ten a kernel thread: an empty
+ * cmdline and smaps_rollup, and PF_KTHREAD set in its stat flags.
+ */
+auto synthetic_tree(int count) -> std::filesystem::path
+{
+    auto root = std::filesystem::temp_directory_path()
+        / ("gossip-bench-" + std::to_string(count));
+    auto marker = root / ".complete";
+
+    if (std::ifstream version { marker }; version) {
+        int found = 0;
+
+        if (version >> found && found == tree_version)
+            return root;
+    }
+
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+
+    write_system(root);
+
+    std::mt19937_64 random { static_cast<std::uint64_t>(count) };
+    char line[256];
+
+    for (int i = 0; i < count; i++) {
+        int pid = 1 + i * 3;
+        bool kthread = i % 10 == 1;
+        auto name = kthread ? "kworker/0:1" : names[random() % names.size()];
+        auto dir = root / std::to_string(pid);
+
+        std::filesystem::create_directory(dir);
+
+        std::string smaps;
+        std::string cmdline;
+
+        if (!kthread) {
+            auto rss = 1000 + random() % 400000;
+
+            smaps = "556022e84000-7ffd4edcd000 ---p 00000000 00:00 0"
+                    "                          [rollup]\n";
+
+            for (std::size_t k = 0; k < smaps_keys.size(); k++) {
+                auto value = k < 11 ? rss >> (k % 4) : random() % 4 ? 0 : rss;
+
+                std::snprintf(line, sizeof(line), "%-16s %9llu kB\n",
+                    (std::string { smaps_keys[k] } + ":").c_str(),
+                    static_cast<unsigned long long>(value));
+                smaps += line;
+            }
+
+            cmdline = std::string { "/usr/bin/" } + name;
+            cmdline += '\0';
+            cmdline += "--type=renderer";
+            cmdline += '\0';
+        }
+
+        std::snprintf(line, sizeof(line),
+            "%d (%s) S 1 %d %d 0 -1 %u %llu 0 12 0 %llu %llu 0 0 20 0 %llu 0 "
+            "%llu 3510657024 %llu 18446744073709551615 1 1 0 0 0 0 0 "
+            "16781312 1082201340 0 0 0 17 3 0 0 0 0 0 0 0 0 0 0 0 0\n",
+            pid, name, pid, pid, kthread ? 0x00208040u : 0x00400100u,
+            static_cast<unsigned long long>(random() % 1000000),
+            static_cast<unsigned long long>(random() % 100000),
+            static_cast<unsigned long long>(random() % 10000),
+            static_cast<unsigned long long>(1 + random() % 64),
+            static_cast<unsigned long long>(random() % 100000000),
+            static_cast<unsigned long long>(random() % 100000));
+
+        write_file(dir / "smaps_rollup", smaps);
+        write_file(dir / "cmdline", cmdline);
+        write_file(dir / "stat", line);
+    }
+
+    std::ofstream { marker } << tree_version << std::endl;
+
+    return root;
+}
+
+auto process_entries(const std::filesystem::path& root)
+    -> std::vector<std::filesystem::directory_entry>
+{
+    std::vector<std::filesystem::directory_entry> entries;
+
+    for (auto& entry : std::filesystem::directory_iterator { root }) {
+        if (entry.is_directory())
+            entries.push_back(entry);
+    }
+
+    return entries;
+}
+
+/*
+ * ru_maxrss only ever grows, so after the largest case every other one
+ * would report the same. Start each from what is resident right now.
+ */
+auto reset_peak_rss() -> void
+{
+    std::ofstream { "/proc/self/clear_refs" } << "5" << std::endl;
+}
+
+/* VmHWM, which clear_refs resets, in kB */
+auto peak_rss() -> std::uint64_t
+{
+    std::ifstream status { "/proc/self/status" };
+    std::string line;
+
+    while (std::getline(status, line)) {
+        if (line.starts_with("VmHWM:"))
+            return std::stoull(line.substr(6));
+    }
+
+    return 0;
+}
+
+auto report(benchmark::State& state, std::size_t processes) -> void
+{
+    state.SetItemsProcessed(state.iterations() * processes);
+    state.counters["per_process"] = benchmark::Counter(
+        static_cast<double>(processes),
+        benchmark::Counter::kIsIterationInvariantRate
+            | benchmark::Counter::kInvert);
+
+    /* Since reset_peak_rss(), at the start of the case */
+    state.counters["peak_rss_kB"] = static_cast<double>(peak_rss());
+}
+};
+
+static void BM_process_extract(benchmark::State& state)
+{
+    reset_peak_rss();
+
+    auto entries = process_entries(synthetic_tree(state.range(0)));
+
+    for (auto _ : state) {
+        for (auto& entry : entries) {
+            Gossip::Process process { entry };
+
+            try {
+                process.extract();
+            } catch (const std::runtime_error& err) {
+                /* Kernel threads */
+            }
+
+            benchmark::DoNotOptimize(process.sample());
+        }
+    }
+
+    report(state, entries.size());
+}
+BENCHMARK(BM_process_extract)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_process_extract_cached(benchmark::State& state)
+{
+    reset_peak_rss();
+
+    auto root = synthetic_tree(state.range(0));
+    auto entries = process_entries(root);
+    Gossip::ProcessCache cache { root };
+
+    for (auto _ : state) {
+        cache.begin_tick();
+
+        for (auto& entry : entries) {
+            Gossip::Process process { entry, cache };
+
+            try {
+                process.extract();
+            } catch (const std::runtime_error& err) {
+                /* Kernel threads */
+            }
+
+            benchmark::DoNotOptimize(process.sample());
+        }
+
+        cache.end_tick();
+    }
+
+    report(state, entries.size());
+}
+BENCHMARK(BM_process_extract_cached)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_collector_tick(benchmark::State& state)
+{
+    reset_peak_rss();
+
+    Gossip::Collector::Options options;
+
+    options.procfs = synthetic_tree(state.range(0));
+    options.jobs = static_cast<int>(state.range(1));
+    options.io_uring = state.range(2);
+
+    Discard discard;
+    std::ostream null(&discard);
+
+    Gossip::CsvWriter writer { null };
+    Gossip::Collector collector { options, writer, null };
+
+    /* The first tick opens every file, leave it out */
+    collector.collect_tick();
+
+    for (auto _ : state)
+        collector.collect_tick();
+
+    report(state, state.range(0));
+}
+BENCHMARK(BM_collector_tick)
+    ->ArgNames({ "pids", "jobs", "io_uring" })
+    ->ArgsProduct({ { 1000, 10000, 100000 }, { 1, 4 }, { 0, 1 } })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,315 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Parser microbenchmarks
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Parser.hpp>
+#include <Smaps.hpp>
+#include <array>
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+
+/*
+ * The legacy_* functions are the stream and regex based parsers gossip
+ * used before Parser existed, kept here as the baseline to beat.
+ */
+namespace {
+const std::string smaps_rollup
+    = "556022e84000-7ffd4edcd000 ---p 00000000 00:00 0 [rollup]\n"
+      "Rss:              400352 kB\n"
+      "Pss:              361496 kB\n"
+      "Pss_Anon:         290092 kB\n"
+      "Pss_File:          71216 kB\n"
+      "Pss_Shmem:           188 kB\n"
+      "Shared_Clean:      44348 kB\n"
+      "Shared_Dirty:        384 kB\n"
+      "Private_Clean:     65528 kB\n"
+      "Private_Dirty:    290092 kB\n"
+      "Referenced:       385692 kB\n"
+      "Anonymous:        290092 kB\n"
+      "LazyFree:              0 kB\n"
+      "AnonHugePages:         0 kB\n"
+      "ShmemPmdMapped:        0 kB\n"
+      "FilePmdMapped:         0 kB\n"
+      "Shared_Hugetlb:        0 kB\n"
+      "Private_Hugetlb:       0 kB\n"
+      "Swap:                  0 kB\n"
+      "SwapPss:               0 kB\n"
+      "Locked:                0 kB\n";
+
+const std::string stat
+    = "4242 (firefox) S 4100 4100 4100 0 -1 4194560 3265434 0 1022 0 "
+      "184243 23211 0 0 20 0 31 0 8329441 3510657024 102443 "
+      "18446744073709551615 1 1 0 0 0 0 0 16781312 1082201340 0 0 0 17 3 0 "
+      "0 0 0 0 0 0 0 0 0 0 0 0\n";
+
+/* The legacy parser gets this one wrong, comm contains a space */
+const std::string stat_spaces
+    = "4242 (Web Content) S 4100 4100 4100 0 -1 4194560 3265434 0 1022 0 "
+      "184243 23211 0 0 20 0 31 0 8329441 3510657024 102443 "
+      "18446744073709551615 1 1 0 0 0 0 0 16781312 1082201340 0 0 0 17 3 0 "
+      "0 0 0 0 0 0 0 0 0 0 0 0\n";
+
+const std::string statm = "857094 102443 24515 1 0 183620 0\n";
+
+const std::string cmdline
+    = "/usr/lib/firefox/firefox\0-contentproc\0-childID\0"
+      "7\0-isForBrowser\0tab\0"s;
+
+const std::string cpu_stat
+    = "cpu  6348225 17498 1883461 101879402 78316 0 56235 0 0 0\n"
+      "cpu0 792374 2226 236611 12731187 10122 0 30104 0 0 0\n";
+
+auto legacy_smaps_rollup(std::istream& in) -> std::vector<int>
+{
+    std::string contents;
+    std::vector<int> values;
+
+    constexpr auto read_size = std::size_t(1024);
+    auto buf = std::string(read_size, '\0');
+
+    in.getline(buf.data(), read_size, '\n');
+
+    while (in.read(buf.data(), read_size)) {
+        contents.append(buf, 0, in.gcount());
+    }
+
+    contents.append(buf, 0, in.gcount());
+
+    std::regex values_regex("[0-9]+");
+    auto values_begin
+        = std::sregex_iterator(contents.begin(), contents.end(), values_regex);
+    auto values_end = std::sregex_iterator();
+
+    for (std::sregex_iterator i = values_begin; i != values_end; ++i) {
+        values.push_back(std::stoi(i->str()));
+    }
+
+    return values;
+}
+
+auto legacy_stat(std::istream& in) -> int
+{
+    std::string line;
+
+    for (int i = 0; i < 13; i++)
+        std::getline(in, line, ' ');
+
+    std::getline(in, line, ' ');
+    int utime = std::stoi(line);
+
+    std::getline(in, line, ' ');
+    int stime = std::stoi(line);
+
+    return utime + stime;
+}
+
+auto legacy_cmdline(std::istream& in) -> std::string
+{
+    std::string cmdline;
+    std::string comm;
+
+    getline(in, cmdline, '\0');
+
+    std::istringstream iss(cmdline);
+    getline(iss, comm, ' ');
+
+    return comm;
+}
+
+auto legacy_cpu_stat(std::istream& in) -> int
+{
+    std::string first_line;
+    std::string line;
+    std::vector<int> values;
+
+    std::getline(in, first_line);
+
+    std::istringstream ss { first_line };
+
+    std::getline(ss, line, ' ');
+    std::getline(ss, line, ' ');
+
+    while (std::getline(ss, line, ' ')) {
+        values.push_back(std::stoi(line));
+    }
+
+    return std::accumulate(values.begin(), values.end(), 0);
+}
+}
+
+static void BM_legacy_smaps_rollup(benchmark::State& state)
+{
+    for (auto _ : state) {
+        std::istringstream in { smaps_rollup };
+        benchmark::DoNotOptimize(legacy_smaps_rollup(in));
+    }
+}
+BENCHMARK(BM_legacy_smaps_rollup);
+
+static void BM_smaps_rollup(benchmark::State& state)
+{
+    std::array<std::uint64_t, 32> values;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            Gossip::Parser::parse_smaps_rollup(smaps_rollup, values));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_smaps_rollup);
+
+static void BM_legacy_stat(benchmark::State& state)
+{
+    for (auto _ : state) {
+        std::istringstream in { stat };
+        benchmark::DoNotOptimize(legacy_stat(in));
+    }
+}
+BENCHMARK(BM_legacy_stat);
+
+static void BM_stat(benchmark::State& state)
+{
+    Gossip::Parser::Stat parsed;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Gossip::Parser::parse_stat(stat, parsed));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_stat);
+
+static void BM_stat_spaces(benchmark::State& state)
+{
+    Gossip::Parser::Stat parsed;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            Gossip::Parser::parse_stat(stat_spaces, parsed));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_stat_spaces);
+
+static void BM_statm(benchmark::State& state)
+{
+    Gossip::Parser::Statm parsed;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Gossip::Parser::parse_statm(statm, parsed));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_statm);
+
+static void BM_legacy_cmdline(benchmark::State& state)
+{
+    for (auto _ : state) {
+        std::istringstream in { cmdline };
+        benchmark::DoNotOptimize(legacy_cmdline(in));
+    }
+}
+BENCHMARK(BM_legacy_cmdline);
+
+static void BM_cmdline(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Gossip::Parser::parse_cmdline(cmdline));
+    }
+}
+BENCHMARK(BM_cmdline);
+
+static void BM_legacy_cpu_stat(benchmark::State& state)
+{
+    for (auto _ : state) {
+        std::istringstream in { cpu_stat };
+        benchmark::DoNotOptimize(legacy_cpu_stat(in));
+    }
+}
+BENCHMARK(BM_legacy_cpu_stat);
+
+static void BM_cpu_stat(benchmark::State& state)
+{
+    std::array<std::uint64_t, 16> values;
+
+    for (auto _ : state) {
+        std::string_view text { cpu_stat };
+        auto line = Gossip::Parser::next_line(text);
+
+        benchmark::DoNotOptimize(Gossip::Parser::parse_cpu_line(line, values));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_cpu_stat);
+
+/* End to end, including the syscalls, against our own /proc entries */
+static void BM_legacy_read_smaps_rollup(benchmark::State& state)
+{
+    for (auto _ : state) {
+        std::ifstream in { "/proc/self/smaps_rollup" };
+        benchmark::DoNotOptimize(legacy_smaps_rollup(in));
+    }
+}
+BENCHMARK(BM_legacy_read_smaps_rollup);
+
+static void BM_read_smaps_rollup(benchmark::State& state)
+{
+    std::array<std::uint64_t, 32> values;
+
+    for (auto _ : state) {
+        auto text = Gossip::Parser::read_file(
+            "/proc/self/smaps_rollup", Gossip::Parser::scratch());
+
+        benchmark::DoNotOptimize(
+            Gossip::Parser::parse_smaps_rollup(text, values));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_read_smaps_rollup);
+
+static void BM_legacy_read_stat(benchmark::State& state)
+{
+    for (auto _ : state) {
+        std::ifstream in { "/proc/self/stat" };
+        benchmark::DoNotOptimize(legacy_stat(in));
+    }
+}
+BENCHMARK(BM_legacy_read_stat);
+
+static void BM_read_stat(benchmark::State& state)
+{
+    Gossip::Parser::Stat parsed;
+
+    for (auto _ : state) {
+        auto text = Gossip::Parser::read_file(
+            "/proc/self/stat", Gossip::Parser::scratch());
+
+        benchmark::DoNotOptimize(Gossip::Parser::parse_stat(text, parsed));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_read_stat);
+
+static void BM_read_smaps(benchmark::State& state)
+{
+    Gossip::Smaps smaps;
+
+    for (auto _ : state) {
+        auto* file = std::fopen("/proc/self/smaps", "r");
+
+        benchmark::DoNotOptimize(smaps.read(fileno(file)));
+        std::fclose(file);
+    }
+}
+BENCHMARK(BM_read_smaps);
+
+BENCHMARK_MAIN();
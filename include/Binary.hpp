@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Binary - Compact columnar output format
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __BINARY_HPP
+#define __BINARY_HPP
+
+#include <Sample.hpp>
+#include <Writer.hpp>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Gossip {
+/*
+ * All integers are fixed width and little-endian, whatever the host.
+ *
+ * The file starts with a header describing the columns:
+ *
+ *   char     magic[8]          "GOSSIPBN"
+ *   u32      version
+ *   u32      num_fields
+ *   num_fields times:
+ *     u16    length
+ *     char   name[length]
+ *
+ * followed by one block per tick, with each column stored contiguously:
+ *
+ *   char     tag[4]            "TICK"
+ *   i64      time              seconds since the epoch
+ *   i32      utc_offset        seconds east of UTC
+ *   i64      start             CLOCK_MONOTONIC nanoseconds, since version 2
+ *   i64      end               likewise
+ *   u32      skipped           likewise
+ *   u32      rows
+ *   u32      columns           smaps_rollup values per row
+ *   i32      pid[rows]
+ *   u64      total_time[rows]
+ *   u8       num_values[rows]
+ *   u8       freshness[rows]   Sample::Freshness, since version 3
+ *   u64      value[columns][rows]
+ *   u32      comm_length[rows]
+ *   char     comm[]            all names, back to back
+ */
+namespace Binary {
+    constexpr std::string_view magic { "GOSSIPBN" };
+    constexpr std::string_view tick_tag { "TICK" };
+    constexpr std::uint32_t version = 3;
+};
+
+class BinaryWriter : public Writer {
+public:
+    /* Writes the file header for `fields' right away */
+    explicit BinaryWriter(std::ostream& output,
+        std::span<const std::string_view> fields = Sample::fields);
+
+    auto write(const Tick& tick) -> void override;
+
+private:
+    std::ostream& output;
+
+    /* Each tick is assembled here and written out in one go */
+    std::vector<char> block;
+};
+
+class BinaryReader : public Reader {
+public:
+    /*
+     * Reads the file header. Throws std::runtime_error if `input' doesn't
+     * hold a file we know how to read.
+     */
+    explicit BinaryReader(std::istream& input);
+
+    auto fields() const -> std::span<const std::string_view> override
+    {
+        return names;
+    }
+
+    auto next(Tick& tick) -> bool override;
+
+private:
+    auto fill(std::size_t length, const char*& in) -> bool;
+
+    std::istream& input;
+
+    std::vector<std::string> storage;
+    std::vector<std::string_view> names;
+
+    std::uint32_t version;
+
+    std::vector<char> block;
+    std::vector<Sample> samples;
+};
+};
+
+#endif /* __BINARY_HPP */
@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Capture - Raw /proc files, archived for parsing elsewhere
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __CAPTURE_HPP
+#define __CAPTURE_HPP
+
+#include <Writer.hpp>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Gossip {
+/*
+ * All integers are fixed width and little-endian, whatever the host.
+ *
+ * The file starts with a header naming the columns it was captured for:
+ *
+ *   char     magic[8]          "GOSSIPRC"
+ *   u32      version
+ *   u32      num_fields
+ *   num_fields times:
+ *     u16    length
+ *     char   name[length]
+ *   u8       bursts            whether ticks name their burst, from
+ *                              version 2 on
+ *
+ * followed by one record per file read, exactly as read:
+ *
+ *   i32      pid               0 for files right under /proc
+ *   u8       file              Capture::File
+ *   u32      tick              counting from 0, with gaps where ticks
+ *                              were dropped
+ *   u32      length
+ *   char     bytes[length]
+ *
+ * A tick's files come in no particular order, followed by a record of
+ * file `tick' closing it, whose bytes are its timestamps:
+ *
+ *   i64      time              seconds since the epoch
+ *   i32      utc_offset        seconds east of UTC
+ *   i64      start             CLOCK_MONOTONIC nanoseconds
+ *   i64      end               likewise
+ *   u32      skipped
+ *   u16      length            from version 2 on
+ *   char     burst[length]     the trigger that set the tick's burst
+ *                              off, empty if none
+ */
+namespace Capture {
+    constexpr std::string_view magic { "GOSSIPRC" };
+    constexpr std::uint32_t version = 2;
+
+    enum class File : std::uint8_t {
+        tick,
+        stat,
+        cmdline,
+        smaps_rollup,
+        loadavg,
+        meminfo,
+        cpuinfo,
+    };
+
+    /* Names under /proc, or /proc/$PID, indexed by File */
+    constexpr std::array<std::string_view, 7> file_names { "", "stat",
+        "cmdline", "smaps_rollup", "loadavg", "meminfo", "cpuinfo" };
+};
+
+class CaptureWriter {
+public:
+    /*
+     * Writes the file header for `fields' right away, and whether
+     * `bursts' are marked in the output.
+     */
+    CaptureWriter(std::ostream& output,
+        std::span<const std::string_view> fields, bool bursts = false);
+
+    /*
+     * Add `bytes' of `file' to `block', for write() to flush out. Each
+     * thread may fill a block of its own at the same time.
+     */
+    auto append(std::vector<char>& block, int pid, Capture::File file,
+        std::string_view bytes) const -> void;
+
+    /*
+     * Write out and empty every one of `blocks', then close `tick', part
+     * of the burst `burst' set off
+     */
+    auto write(std::span<std::vector<char>> blocks, const Tick& tick,
+        std::string_view burst = {}) -> void;
+
+private:
+    std::ostream& output;
+
+    std::uint32_t ticks;
+    std::vector<char> block;
+};
+
+class CaptureReader {
+public:
+    struct Record {
+        int pid;
+        Capture::File file;
+        std::string_view bytes;
+    };
+
+    /*
+     * Reads the file header. Throws std::runtime_error if `input' doesn't
+     * hold a capture we know how to read.
+     */
+    explicit CaptureReader(std::istream& input);
+
+    auto fields() const -> std::span<const std::string_view> { return names; }
+
+    /* Whether the run that captured it marked bursts */
+    auto bursts() const -> bool { return marked; }
+
+    /* What set off the burst the last tick read was in, empty if none */
+    auto burst() const -> std::string_view { return bursting; }
+
+    /*
+     * Read the next tick, and every file captured for it into `records'.
+     * Both stay valid until the following call. Returns false at the end
+     * of the input, including in the middle of a tick cut short when the
+     * capture was, and throws std::runtime_error if it is corrupt.
+     */
+    auto next(Tick& tick, std::vector<Record>& records) -> bool;
+
+private:
+    std::istream& input;
+
+    std::vector<std::string> storage;
+    std::vector<std::string_view> names;
+
+    std::uint32_t version;
+    std::uint32_t ticks;
+
+    bool marked;
+    std::string_view bursting;
+
+    /* Every record of a tick, back to back, and where each one lies */
+    std::vector<char> data;
+    std::vector<std::pair<std::size_t, std::size_t>> extents;
+};
+};
+
+#endif /* __CAPTURE_HPP */
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Cgroups - Memory and CPU of every cgroup in a cgroup v2 hierarchy
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __CGROUPS_HPP
+#define __CGROUPS_HPP
+
+#include <Parser.hpp>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Gossip {
+/*
+ * A handful of small files per cgroup instead of smaps_rollup of every
+ * process in it: memory.current, memory.stat, cpu.stat and
+ * memory.pressure. Controllers that aren't enabled for a cgroup leave
+ * their files out, and their columns zero.
+ */
+class Cgroups {
+public:
+    /* Keys picked from memory.stat, and the columns they are written as */
+    static constexpr std::array<std::string_view, 9> memory_keys { "anon",
+        "file", "kernel", "shmem", "sock", "file_mapped", "file_dirty",
+        "pgfault", "pgmajfault" };
+    static constexpr std::array<std::string_view, 9> memory_columns { "Anon",
+        "File", "Kernel", "Shmem", "Sock", "File_Mapped", "File_Dirty",
+        "Pgfault", "Pgmajfault" };
+
+    /* The first ones are in bytes, written in kB; the rest are counts */
+    static constexpr std::size_t memory_sizes = 7;
+
+    /* Keys picked from cpu.stat, all in microseconds but nr_throttled */
+    static constexpr std::array<std::string_view, 5> cpu_keys { "usage_usec",
+        "user_usec", "system_usec", "nr_throttled", "throttled_usec" };
+    static constexpr std::array<std::string_view, 5> cpu_columns {
+        "Usage_Usec", "User_Usec", "System_Usec", "Nr_Throttled",
+        "Throttled_Usec"
+    };
+
+    struct Cgroup {
+        /* From the root of the hierarchy, "/" for the root itself */
+        std::string path;
+
+        /* memory.current, in kB */
+        std::uint64_t current = 0;
+
+        std::array<std::uint64_t, memory_keys.size()> memory {};
+        std::array<std::uint64_t, cpu_keys.size()> cpu {};
+        Parser::Pressure pressure;
+    };
+
+    /* `root' is where cgroup2 is mounted, or a fake tree for tests */
+    explicit Cgroups(const std::filesystem::path& root);
+
+    /* Walk the hierarchy again, picking up new cgroups, and read them all */
+    auto extract() -> void;
+
+    /* By path, so parents come before their children */
+    auto cgroups() const -> std::span<const Cgroup> { return { list }; }
+
+    /*
+     * PIDs in cgroup.procs of `path', relative to the root, in ascending
+     * order. Returns false if there is no such cgroup.
+     */
+    auto processes(std::string_view path, std::vector<int>& pids) const
+        -> bool;
+
+    static auto write_header(std::ostream& os) -> void;
+
+    /* One line per cgroup, ending in `timestamp' */
+    auto write(std::ostream& os, std::string_view timestamp) const -> void;
+
+private:
+    auto read(const std::filesystem::path& directory, Cgroup& cgroup) -> void;
+
+    std::filesystem::path root;
+
+    /* Reused from tick to tick, along with the strings in them */
+    std::vector<Cgroup> list;
+};
+};
+
+#endif /* __CGROUPS_HPP */
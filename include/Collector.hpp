@@ -8,27 +8,311 @@
 #ifndef __COLLECTOR_HPP
 #define __COLLECTOR_HPP
 
+#include <Capture.hpp>
+#include <Cgroups.hpp>
+#include <Fields.hpp>
+#include <Governor.hpp>
+#include <Pool.hpp>
+#include <Process.hpp>
+#include <ProcessCache.hpp>
+#include <Rates.hpp>
+#include <Sample.hpp>
+#include <SampleTable.hpp>
+#include <Scanner.hpp>
+#include <Smaps.hpp>
+#include <System.hpp>
+#include <Threads.hpp>
+#include <Top.hpp>
+#include <Trigger.hpp>
+#include <Uring.hpp>
+#include <Writer.hpp>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <filesystem>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <poll.h>
 #include <set>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace Gossip {
 class Collector {
 public:
-    Collector(std::string& pids_str, std::chrono::seconds& seconds,
-        int num_samples, std::ostream& output);
+    struct Options {
+        /* Comma separated PIDs to track, empty for every process */
+        std::string pids;
+
+        /* Where procfs is mounted, or a fake tree for tests and benchmarks */
+        std::filesystem::path procfs { "/proc" };
+
+        std::chrono::milliseconds interval { 1000 };
+
+        /* Zero or less to keep going until stop() */
+        int num_samples = 10;
+
+        int jobs = 1;
+        bool io_uring = false;
+
+        /*
+         * Read smaps_rollup only when a process's resident set or CPU
+         * time moved by a threshold since it was last read, or after
+         * `max_age' ticks. Other ticks carry its values over.
+         */
+        bool adaptive = false;
+        std::uint64_t rss_threshold_kb = 256;
+        std::chrono::milliseconds cpu_threshold { 100 };
+        unsigned max_age = 10;
+
+        /* Columns to collect; only the files they need are read */
+        Fields::Selection fields = Fields::Selection::all();
+
+        /* Read /proc/stat, loadavg and meminfo for the system output */
+        bool system = true;
+
+        /*
+         * Only write the `top' heaviest processes of each tick by
+         * `by', one of Top::metric_names. Zero for all of them.
+         */
+        std::size_t top = 0;
+        std::string by = "pss";
+
+        /* Where cgroup2 is mounted, or a fake tree for tests */
+        std::filesystem::path cgroup_root { "/sys/fs/cgroup" };
+
+        /*
+         * Only collect the processes in this cgroup, relative to
+         * `cgroup_root', rather than everything in procfs
+         */
+        std::string cgroup;
+
+        /* False to leave processes out altogether */
+        bool processes = true;
+
+        /* Back off when gossip itself uses more than this */
+        Governor::Budget budget;
+
+        /*
+         * Sample every `burst_interval' instead, zero for never, until
+         * `burst_window' after a trigger last fired.
+         */
+        std::chrono::milliseconds burst_interval { 0 };
+        std::chrono::milliseconds burst_window { 10000 };
+
+        /*
+         * No burst lasts longer than `burst_limit', however long triggers
+         * keep firing, and one cut short is followed by as long at the
+         * usual pace before another may start.
+         */
+        std::chrono::milliseconds burst_limit { 60000 };
+
+        /*
+         * Built-in triggers, each left out when empty or zero: a PSI
+         * trigger for pressure/memory, MemAvailable below `free_kb',
+         * and any process's Rss growing by `growth_kb' in a tick.
+         */
+        std::string pressure;
+        std::uint64_t free_kb = 0;
+        std::uint64_t growth_kb = 0;
+    };
+
+    /* Everything written besides the output, each left out when null */
+    struct Outputs {
+        /* A line of --self-stats per tick */
+        std::ostream* stats = nullptr;
+
+        /*
+         * The memory of every PID in `Options::pids' broken down per
+         * mapping, and the CPU time of each of their threads
+         */
+        std::ostream* mapping = nullptr;
+        std::ostream* thread = nullptr;
+
+        /*
+         * The CPU usage and memory growth of every process, and the
+         * processes that started or exited
+         */
+        std::ostream* rate = nullptr;
+        std::ostream* event = nullptr;
+
+        /* The memory and CPU of every cgroup under `Options::cgroup_root' */
+        std::ostream* cgroup = nullptr;
+
+        /* Every change of pace `Options::budget' called for */
+        std::ostream* governor = nullptr;
+
+        /*
+         * Files are archived here as read rather than parsed, and
+         * neither the writer nor the system-wide output get anything
+         */
+        std::ostream* capture = nullptr;
+    };
+
+    Collector(const Options& options, Writer& writer,
+        std::ostream& system_output);
+    Collector(const Options& options, Writer& writer,
+        std::ostream& system_output, const Outputs& outputs);
+    ~Collector();
+
+    Collector(const Collector&) = delete;
+    Collector& operator=(const Collector&) = delete;
 
     auto collect_data() -> void;
 
+    /*
+     * Make collect_data() return once the tick in progress, or the wait
+     * for the next one, is over. May be called from any thread.
+     */
+    auto stop() -> void { stopping = true; }
+
+    /* Collect one tick right away, outside of the schedule */
+    auto collect_tick() -> void { process_directories(0); }
+
+    /* One more reason for a burst, e.g. a stand-in for tests */
+    auto add_trigger(std::unique_ptr<Trigger> trigger) -> void;
+
+    /* What set off the burst the last tick was in, empty if none */
+    auto burst() const -> std::string_view { return bursting; }
+
 private:
-    auto process_directories() -> void;
+    /*
+     * With io_uring, processes are handled in batches: the reads for a
+     * whole batch are submitted at once into fixed per-worker buffers
+     * sized for stat and smaps_rollup.
+     */
+    static constexpr std::size_t batch_size = 32;
+    static constexpr std::size_t stat_size = 1024;
+    static constexpr std::size_t smaps_rollup_size = 4096;
+
+    auto scan_processes() -> void;
+    auto process_directories(std::uint32_t skipped) -> void;
+    auto collect_processes() -> void;
+    auto collect_top() -> void;
+    auto collect_process(std::size_t index, Process& process) -> void;
+    auto collect_batch(int worker, std::size_t batch) -> void;
+    auto collect_threads() -> void;
+    auto trim() -> void;
+    auto capture_system() -> void;
+    auto read_system(Capture::File file) -> std::string_view;
+    auto capture_processes() -> void;
 
-    std::chrono::seconds& seconds;
+    std::chrono::milliseconds interval;
+    std::chrono::milliseconds burst_interval;
+    std::chrono::milliseconds burst_window;
+    std::chrono::milliseconds burst_limit;
     std::set<int> pids;
-    std::ostream& output;
+    Writer& writer;
+    std::ostream& system_output;
+    std::ostream* stats_output;
+    std::ostream* mapping_output;
+    std::ostream* thread_output;
+    std::ostream* cgroup_output;
+    std::ostream* governor_output;
 
     int num_samples;
+    std::atomic<bool> stopping;
+
+    const std::filesystem::directory_entry procdir;
+
+    Scanner scanner;
+
+    /* Snapshot of /proc/stat, loadavg and meminfo, once per tick */
+    System system;
+
+    /* Open descriptors for every process seen in the previous tick */
+    ProcessCache cache;
+
+    Pool pool;
+
+    /* Only when adaptive */
+    std::optional<Process::Staleness> staleness;
+
+    /* Only with a budget */
+    std::optional<Governor> governor;
+
+    /* Deadlines left to sit out before the next tick */
+    unsigned resting;
+
+    /* What this tick carries values over with, if anything */
+    const Process::Staleness* limits;
+
+    /* Only with a cgroup output, or processes from a cgroup */
+    std::optional<Cgroups> cgroups;
+    std::string cgroup;
+    bool processes_enabled;
+
+    /* PIDs listed in cgroup.procs of `cgroup' */
+    std::vector<int> members;
+
+    /* Only when capturing, with a block of records per worker */
+    std::optional<CaptureWriter> capture;
+    std::vector<std::vector<char>> captured;
+
+    /*
+     * Files right under procfs, indexed by Capture::File, and kept open
+     * across ticks once read like ProcessCache keeps those of processes
+     */
+    std::array<std::filesystem::path, Capture::file_names.size()> system_files;
+    std::array<int, Capture::file_names.size()> system_fds;
+
+    /* Grown to fit the largest of them, /proc/stat on large machines */
+    std::vector<char> system_buffer;
+
+    /* cpuinfo went into the capture already */
+    bool captured_cpuinfo;
+
+    /* Only with bursts, and what they poll for between ticks */
+    std::vector<std::unique_ptr<Trigger>> triggers;
+    std::vector<pollfd> polls;
+    std::vector<Trigger*> polled;
+
+    /* Name of the trigger, and when the burst ends unless it fires again */
+    std::string_view bursting;
+    std::int64_t burst_end;
+
+    /* When the burst began, and when the next one may after a cut short */
+    std::int64_t burst_start;
+    std::int64_t rested;
+
+    /* Only with a rate or event output */
+    std::optional<Rates> rates;
+
+    /* Only when writing the heaviest processes alone */
+    std::optional<Top> top;
+    std::vector<Top::Candidate> candidates;
+
+    Fields::Selection fields;
+    bool system_enabled;
+
+    /*
+     * One per PID broken down per mapping. Only ever looked up once
+     * built, so workers may each use their own at the same time.
+     */
+    std::map<int, Smaps> breakdowns;
+
+    /* One per PID whose threads are sampled */
+    std::vector<std::unique_ptr<Threads>> threads;
+
+    /* Every thread of those, to spread over the pool */
+    std::vector<std::pair<Threads*, std::size_t>> tasks;
+
+    /*
+     * One row per PID, filled in by whichever worker got to it. Those
+     * left with a negative PID are dropped before writing the tick out.
+     */
+    SampleTable samples;
+
+    /* One ring per worker, empty when not using io_uring */
+    std::vector<std::unique_ptr<Uring>> rings;
+    std::vector<std::vector<char>> batch_buffers;
+
+    /* PIDs to collect this tick, in ascending order */
+    std::vector<int> processes;
 };
 };
 
@@ -8,24 +8,50 @@
 #ifndef __CPU_HPP
 #define __CPU_HPP
 
+#include <array>
+#include <cstdint>
 #include <filesystem>
 #include <iostream>
 #include <limits>
+#include <span>
 #include <string>
 #include <vector>
 
 namespace Gossip {
 class Cpu {
 public:
+    /* user, nice, system, idle, iowait, irq, softirq, steal, guest... */
+    static constexpr std::size_t max_values = 16;
+
+    /* Times for one of the `cpuN' lines in /proc/stat */
+    struct Online {
+        int id;
+        std::uint64_t total_time;
+        std::uint64_t idle_time;
+    };
+
     Cpu(const std::filesystem::directory_entry& directory)
         : directory(directory)
+        , stat_path(directory.path() / "stat")
     {
         total_time = 0;
         num_cpus = 0;
+        num_values = 0;
+        hotplug = false;
     }
 
+    /*
+     * A Cpu is meant to live across samples: /proc/cpuinfo is only scanned
+     * on the first extract() and whenever the set of CPUs listed in
+     * /proc/stat changes.
+     */
     auto extract() -> void;
 
+    /* Whether the last extract() saw CPUs come or go */
+    auto changed() const -> bool { return hotplug; }
+
+    auto online() const -> std::span<const Online> { return cpus; }
+
     friend std::ostream& operator<<(std::ostream& os, const Cpu& cpu)
     {
         os << cpu.total_time << "," << cpu.num_cpus << ",";
@@ -37,12 +63,22 @@ private:
     auto get_stat() -> void;
     auto get_num_cpus() -> void;
 
-    int total_time;
+    std::uint64_t total_time;
     int num_cpus;
+    bool hotplug;
 
-    std::vector<int> values;
+    std::array<std::uint64_t, max_values> values;
+    std::size_t num_values;
+
+    std::vector<Online> cpus;
+
+    /* /proc/stat grows by a line per CPU, size the buffer accordingly */
+    std::vector<char> buffer;
 
     const std::filesystem::directory_entry& directory;
+
+    /* Built once, rather than every tick */
+    const std::filesystem::path stat_path;
 };
 };
 
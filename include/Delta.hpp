@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Delta - Output format storing only what changed between ticks
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __DELTA_HPP
+#define __DELTA_HPP
+
+#include <Sample.hpp>
+#include <Writer.hpp>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Gossip {
+/*
+ * Most smaps_rollup values of a process don't change from one tick to
+ * the next, so each tick is written relative to the one before it. All
+ * integers are LEB128 varints, signed ones zigzag encoded first.
+ *
+ * The file starts with a header describing the columns:
+ *
+ *   char     magic[8]          "GOSSIPDL"
+ *   varint   version
+ *   varint   num_fields
+ *   num_fields times:
+ *     varint length
+ *     char   name[length]
+ *
+ * followed by one record per tick:
+ *
+ *   char     kind              'K' for keyframes, 'D' for deltas
+ *   varint   length            of the rest of the record
+ *   svarint  time              keyframes: since the epoch,
+ *                              deltas: since the previous tick
+ *   svarint  utc_offset
+ *   svarint  start             CLOCK_MONOTONIC nanoseconds, relative
+ *                              like time, since version 2
+ *   varint   duration          end - start, likewise
+ *   varint   skipped           likewise
+ *   varint   rows
+ *   rows times:
+ *     svarint pid              since the previous row
+ *     varint  mask
+ *
+ * A row with bit 0 of `mask' clear is complete:
+ *
+ *     varint  comm_length
+ *     char    comm[comm_length]
+ *     varint  num_values
+ *     varint  value[num_values]
+ *     varint  total_time
+ *     varint  freshness        Sample::Freshness, since version 3
+ *
+ * Otherwise the process was in the previous tick with the same comm and
+ * number of values, and bit 1 + i of `mask' says value i changed
+ * (i == max_values stands for total_time). One svarint difference
+ * follows for every bit set, so a process that didn't change at all
+ * costs a couple of bytes. Since version 3, bit 2 + max_values says
+ * freshness changed and is followed by its new value as a varint.
+ *
+ * Keyframes only hold complete rows. Decoding may start at any of them,
+ * and the length of each record lets a reader skip to the next one
+ * without decoding anything in between.
+ */
+namespace Delta {
+    constexpr std::string_view magic { "GOSSIPDL" };
+    constexpr std::uint32_t version = 3;
+    constexpr char keyframe = 'K';
+    constexpr char delta = 'D';
+};
+
+class DeltaWriter : public Writer {
+public:
+    /*
+     * Writes the file header for `fields' right away. Every
+     * `keyframe_interval' ticks a keyframe is written.
+     */
+    explicit DeltaWriter(std::ostream& output,
+        std::span<const std::string_view> fields = Sample::fields,
+        unsigned keyframe_interval = 60);
+
+    auto write(const Tick& tick) -> void override;
+
+    /* Makes the next tick a keyframe */
+    auto restart() -> void override { ticks = 0; }
+
+private:
+    auto write_row(const Sample& sample) -> void;
+
+    std::ostream& output;
+    unsigned keyframe_interval;
+    std::uint64_t ticks;
+
+    /* Samples of the previous tick, in PID order */
+    std::vector<Sample> previous;
+    std::int64_t previous_time;
+    std::int64_t previous_start;
+
+    std::vector<char> record;
+    std::vector<char> prefix;
+};
+
+class DeltaReader : public Reader {
+public:
+    /*
+     * Reads the file header. Throws std::runtime_error if `input' doesn't
+     * hold a file we know how to read.
+     */
+    explicit DeltaReader(std::istream& input);
+
+    auto fields() const -> std::span<const std::string_view> override
+    {
+        return names;
+    }
+
+    auto next(Tick& tick) -> bool override;
+
+    /*
+     * Skip ahead to the first keyframe taken at or after `time', without
+     * decoding the ticks in between. The following next() returns it.
+     * Returns false if there is no such keyframe.
+     */
+    auto seek(std::int64_t time) -> bool;
+
+private:
+    auto read_record(char& kind, bool skip_deltas = false) -> bool;
+
+    std::istream& input;
+    std::uint64_t version;
+
+    std::vector<std::string> storage;
+    std::vector<std::string_view> names;
+
+    std::vector<char> record;
+
+    /* Set by seek() when it already read the record next() should use */
+    bool pending;
+    char pending_kind;
+
+    std::vector<Sample> samples;
+    std::vector<Sample> previous;
+    std::int64_t previous_time;
+    std::int64_t previous_start;
+};
+};
+
+#endif /* __DELTA_HPP */
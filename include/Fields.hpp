@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Fields - Output columns and the files they come from
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __FIELDS_HPP
+#define __FIELDS_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Gossip {
+namespace Fields {
+    /* Where in /proc/$PID a column is read from */
+    enum class Source : std::uint8_t {
+        none,
+        stat,
+        cmdline,
+        smaps_rollup,
+    };
+
+    struct Field {
+        std::string_view name;
+        Source source;
+    };
+
+    /*
+     * Every column we know how to write, in their default order. The
+     * smaps_rollup ones are named after the keys in that file.
+     */
+    constexpr std::array<Field, 25> table { {
+        { "PID", Source::none },
+        { "Comm", Source::cmdline },
+        { "Rss", Source::smaps_rollup },
+        { "Pss", Source::smaps_rollup },
+        { "Pss_Anon", Source::smaps_rollup },
+        { "Pss_File", Source::smaps_rollup },
+        { "Pss_Shmem", Source::smaps_rollup },
+        { "Shared_Clean", Source::smaps_rollup },
+        { "Shared_Dirty", Source::smaps_rollup },
+        { "Private_Clean", Source::smaps_rollup },
+        { "Private_Dirty", Source::smaps_rollup },
+        { "Referenced", Source::smaps_rollup },
+        { "Anonymous", Source::smaps_rollup },
+        { "LazyFree", Source::smaps_rollup },
+        { "AnonHugePages", Source::smaps_rollup },
+        { "ShmemPmdMapped", Source::smaps_rollup },
+        { "FilePmdMapped", Source::smaps_rollup },
+        { "Shared_Hugetlb", Source::smaps_rollup },
+        { "Private_Hugetlb", Source::smaps_rollup },
+        { "Swap", Source::smaps_rollup },
+        { "SwapPss", Source::smaps_rollup },
+        { "Locked", Source::smaps_rollup },
+        { "Total_Process_Time", Source::stat },
+        { "Fresh", Source::smaps_rollup },
+        { "Timestamp", Source::none },
+    } };
+
+    constexpr auto find(std::string_view name) -> const Field*
+    {
+        for (auto& field : table) {
+            if (field.name == name)
+                return &field;
+        }
+
+        return nullptr;
+    }
+
+    /* Whether `name' is one of the values parsed out of smaps_rollup */
+    constexpr auto is_value(std::string_view name) -> bool
+    {
+        auto* field = find(name);
+
+        return field && field->source == Source::smaps_rollup
+            && field->name != "Fresh";
+    }
+
+    /*
+     * Where the value of smaps_rollup `key' is stored in Sample::values,
+     * for rows written with `columns': values are kept in the order of
+     * their columns. Empty if `key' isn't among them.
+     */
+    inline auto value_index(std::span<const std::string_view> columns,
+        std::string_view key) -> std::optional<std::size_t>
+    {
+        std::size_t index = 0;
+
+        for (auto name : columns) {
+            if (!is_value(name))
+                continue;
+
+            if (name == key)
+                return index;
+
+            index++;
+        }
+
+        return std::nullopt;
+    }
+
+    /* Names of every field in the table except `except', in order */
+    template <std::size_t N>
+    constexpr auto names(std::string_view except = {})
+        -> std::array<std::string_view, N>
+    {
+        std::array<std::string_view, N> result {};
+        std::size_t count = 0;
+
+        for (auto& field : table) {
+            if (field.name != except)
+                result.at(count++) = field.name;
+        }
+
+        return result;
+    }
+
+    /*
+     * The columns a run writes, and with them the files it has to read.
+     * stat is read no matter what: it tells kernel threads and reused
+     * PIDs apart before anything else is looked at.
+     */
+    class Selection {
+    public:
+        /* Every field, Fresh only in adaptive mode */
+        static auto all(bool adaptive = false) -> Selection;
+
+        /*
+         * Comma separated names from the table, written in the order
+         * given. Throws std::invalid_argument for unknown or repeated
+         * names.
+         */
+        static auto parse(const std::string& list) -> Selection;
+
+        auto names() const -> std::span<const std::string_view>
+        {
+            return columns;
+        }
+
+        auto needs(Source source) const -> bool
+        {
+            return sources[static_cast<std::size_t>(source)];
+        }
+
+        /* smaps_rollup keys to look up, in the order their values are stored */
+        auto keys() const -> std::span<const std::string_view>
+        {
+            return values;
+        }
+
+        /* Where the value of `key' is stored, empty if it isn't selected */
+        auto index_of(std::string_view key) const -> std::optional<std::size_t>
+        {
+            return value_index(columns, key);
+        }
+
+    private:
+        auto add(const Field& field) -> void;
+
+        std::vector<std::string_view> columns;
+        std::vector<std::string_view> values;
+        std::array<bool, 4> sources {};
+    };
+};
+};
+
+#endif /* __FIELDS_HPP */
@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Governor - Keeps gossip's own overhead within a budget
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __GOVERNOR_HPP
+#define __GOVERNOR_HPP
+
+#include <Process.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+
+namespace Gossip {
+/*
+ * Measures the CPU time and resident set of gossip itself after every
+ * tick, from /proc/self/stat. While over the CPU budget it backs off one
+ * level at a time: first smaps_rollup values are carried over, as with
+ * --adaptive but looser, then ticks are spread two, four and eight
+ * intervals apart. Over the memory budget, none of that helps; it turns
+ * lean instead, giving memory back after every tick. Either only comes
+ * back once usage is well below the budget, so that it doesn't bounce.
+ */
+class Governor {
+public:
+    struct Budget {
+        /* Percent of one CPU, zero for no limit */
+        double cpu = 0;
+
+        /* Resident set in kB, zero for no limit */
+        std::uint64_t rss_kb = 0;
+    };
+
+    static constexpr unsigned max_level = 4;
+
+    /*
+     * `staleness' is what --adaptive carries values over with, the
+     * governor loosens it further.
+     */
+    Governor(const std::filesystem::path& procfs, const Budget& budget,
+        const Process::Staleness& staleness);
+
+    /*
+     * Run at SCHED_IDLE, and on `cpu' alone unless it's negative. Both
+     * are per thread, so this must be called before any other thread
+     * is created. Throws std::runtime_error if either fails.
+     */
+    static auto confine(bool idle, int cpu) -> void;
+
+    /*
+     * Once after every tick, `now' on the monotonic clock. Returns true
+     * if the level changed.
+     */
+    auto update(std::int64_t now) -> bool;
+
+    auto level() const -> unsigned { return current; }
+
+    /* Intervals between ticks */
+    auto stretch() const -> unsigned
+    {
+        return current > 1 ? 1u << (current - 1) : 1;
+    }
+
+    /* Whether to give what a tick allocated back after it */
+    auto lean() const -> bool { return trimming; }
+
+    /* Null unless smaps_rollup values are being carried over */
+    auto staleness() const -> const Process::Staleness*
+    {
+        return current ? &loose : nullptr;
+    }
+
+    static auto write_header(std::ostream& os) -> void;
+
+    /* The last decision, ending in `timestamp' */
+    auto write(std::ostream& os, std::string_view timestamp) const -> void;
+
+private:
+    /* Ticks to let the usage settle in after a change */
+    static constexpr unsigned settle = 5;
+
+    /* Weight of the latest tick in the usage average */
+    static constexpr double weight = 0.25;
+
+    std::filesystem::path stat_path;
+    Budget budget;
+    Process::Staleness loose;
+
+    double clock_ticks;
+    std::uint64_t page_kb;
+
+    /* As of the previous update, none before the first */
+    std::int64_t time;
+    std::uint64_t total_time;
+
+    /* Percent of one CPU, averaged over the last few ticks */
+    double usage;
+    std::uint64_t rss_kb;
+
+    unsigned current;
+    unsigned since_change;
+    bool trimming;
+
+    /* What the last change was about: "cpu", "rss" or "relax" */
+    std::string_view reason;
+};
+};
+
+#endif /* __GOVERNOR_HPP */
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * History - The last few ticks, kept in memory
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __HISTORY_HPP
+#define __HISTORY_HPP
+
+#include <Sample.hpp>
+#include <Writer.hpp>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Gossip {
+/*
+ * A Writer keeping the last `capacity' ticks in a ring, for a daemon to
+ * answer queries from. Like the binary format, each tick is stored one
+ * column after another rather than as Samples, and the columns of the
+ * slot it overwrites are reused, so memory only grows with the largest
+ * number of processes seen in any tick.
+ *
+ * Ticks are numbered from zero in the order they are written. Writing
+ * and querying may happen from different threads.
+ */
+class History : public Writer {
+public:
+    explicit History(std::size_t capacity);
+
+    auto write(const Tick& tick) -> void override;
+
+    /* How many ticks were ever written */
+    auto written() const -> std::uint64_t;
+
+    /*
+     * Hand tick `number' over to `writer'. Returns false if it was never
+     * written or is no longer kept.
+     */
+    auto replay(std::uint64_t number, Writer& writer) -> bool;
+
+    /*
+     * Hand every kept tick from the last `seconds' over to `writer',
+     * with only the row of `pid' in it; ticks it isn't in are skipped.
+     * Seconds are counted back from the newest tick, zero means every
+     * tick kept. Returns how many rows were written.
+     */
+    auto replay(int pid, std::int64_t seconds, Writer& writer) -> std::size_t;
+
+    /* "# Tick,Processes,Timestamp" and a line per tick kept */
+    auto list(std::ostream& os) const -> void;
+
+private:
+    struct Slot {
+        std::uint64_t number = 0;
+
+        std::int64_t time = 0;
+        std::int32_t utc_offset = 0;
+        std::int64_t start = 0;
+        std::int64_t end = 0;
+        std::uint32_t skipped = 0;
+
+        /* smaps_rollup values per row, the most any row has */
+        std::size_t columns = 0;
+
+        std::vector<int> pids;
+        std::vector<std::uint64_t> total_times;
+        std::vector<std::uint8_t> num_values;
+        std::vector<Sample::Freshness> freshness;
+
+        /* values[column * rows + row] */
+        std::vector<std::uint64_t> values;
+
+        /* Every name back to back, each ending where `name_ends' says */
+        std::string names;
+        std::vector<std::uint32_t> name_ends;
+    };
+
+    auto slot(std::uint64_t number) const -> const Slot*;
+    auto unpack(const Slot& slot, std::size_t row, Sample& sample) const
+        -> void;
+    auto header(const Slot& slot) const -> Tick;
+
+    mutable std::mutex lock;
+    std::vector<Slot> slots;
+    std::uint64_t count;
+
+    /* Rows of the tick being replayed */
+    std::vector<Sample> samples;
+};
+};
+
+#endif /* __HISTORY_HPP */
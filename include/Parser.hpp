@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Parser - Allocation-free parsers for /proc files
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __PARSER_HPP
+#define __PARSER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+namespace Gossip {
+namespace Parser {
+    /*
+     * Every file we care about fits comfortably in this many bytes. Larger
+     * files are simply truncated, which only ever loses trailing data we
+     * don't look at (e.g. the tail of a very long command line).
+     */
+    constexpr std::size_t buffer_size = 16384;
+
+    using Buffer = std::array<char, buffer_size>;
+
+    /*
+     * Fields from /proc/$PID/stat. `comm' points into the buffer the file
+     * was read into and is only valid until that buffer is reused.
+     */
+    struct Stat {
+        int pid = -1;
+        std::string_view comm;
+        char state = '?';
+        int ppid = 0;
+        std::uint64_t flags = 0;
+        std::uint64_t utime = 0;
+        std::uint64_t stime = 0;
+        std::int64_t num_threads = 0;
+        std::uint64_t starttime = 0;
+
+        /* In bytes, unlike rss which is in pages */
+        std::uint64_t vsize = 0;
+        std::int64_t rss = 0;
+    };
+
+    /* Fields from /proc/$PID/statm, all in pages */
+    struct Statm {
+        std::uint64_t size = 0;
+        std::uint64_t resident = 0;
+        std::uint64_t shared = 0;
+        std::uint64_t text = 0;
+        std::uint64_t data = 0;
+    };
+
+    /* Fields from /proc/loadavg */
+    struct Loadavg {
+        double load_1 = 0;
+        double load_5 = 0;
+        double load_15 = 0;
+        std::uint64_t runnable = 0;
+        std::uint64_t threads = 0;
+    };
+
+    /* Pressure stall information, e.g. a cgroup's memory.pressure */
+    struct Pressure {
+        /* Percent of the last 10 seconds, and microseconds in total */
+        double some_avg10 = 0;
+        std::uint64_t some_total = 0;
+        double full_avg10 = 0;
+        std::uint64_t full_total = 0;
+    };
+
+    /*
+     * Per-thread scratch buffer. Everything returned by read_file() is a
+     * view into this buffer, so it's only valid until the next read.
+     */
+    auto scratch() -> Buffer&;
+
+    /*
+     * Read `path' into `buffer' with a single read(). Returns an empty view
+     * if the file can't be opened or read, which is what happens when a
+     * process exits while we're looking at it.
+     */
+    auto read_file(const std::filesystem::path& path,
+        std::span<char> buffer) -> std::string_view;
+
+    /*
+     * Same as above, for a descriptor we keep open across samples. procfs
+     * regenerates the contents on every read from offset zero.
+     */
+    auto read_fd(int fd, std::span<char> buffer) -> std::string_view;
+
+    /* Split off the first line of `text', without its trailing newline */
+    auto next_line(std::string_view& text) -> std::string_view;
+
+    /*
+     * Extract every decimal number after the first line of smaps_rollup
+     * into `values'. Returns how many were stored; numbers that don't fit
+     * in `values' are dropped.
+     */
+    auto parse_smaps_rollup(std::string_view text,
+        std::span<std::uint64_t> values) -> std::size_t;
+
+    /*
+     * Only look up `keys' in smaps_rollup, storing each value at the same
+     * index of `values'. Returns how many keys were found.
+     */
+    auto parse_smaps_rollup(std::string_view text,
+        std::span<const std::string_view> keys,
+        std::span<std::uint64_t> values) -> std::size_t;
+
+    /*
+     * Parse /proc/$PID/stat. `comm' may itself contain spaces and
+     * parentheses, so it's delimited by the first '(' and the last ')'.
+     */
+    auto parse_stat(std::string_view text, Stat& stat) -> bool;
+
+    auto parse_statm(std::string_view text, Statm& statm) -> bool;
+
+    /* First word of the first argument in /proc/$PID/cmdline */
+    auto parse_cmdline(std::string_view text) -> std::string_view;
+
+    /*
+     * Parse one `cpu' line from /proc/stat, skipping its label. Returns how
+     * many values were stored.
+     */
+    auto parse_cpu_line(std::string_view line,
+        std::span<std::uint64_t> values) -> std::size_t;
+
+    auto parse_loadavg(std::string_view text, Loadavg& loadavg) -> bool;
+
+    /*
+     * Look up `keys' in /proc/meminfo and store their values, in kB, at
+     * the same index of `values'. Returns how many keys were found.
+     */
+    auto parse_meminfo(std::string_view text,
+        std::span<const std::string_view> keys,
+        std::span<std::uint64_t> values) -> std::size_t;
+
+    /*
+     * Same as above for cgroup "flat keyed" files such as memory.stat or
+     * cpu.stat, with a space rather than a colon after each key.
+     */
+    auto parse_flat_keyed(std::string_view text,
+        std::span<const std::string_view> keys,
+        std::span<std::uint64_t> values) -> std::size_t;
+
+    /* Returns false unless there was a `some' line at least */
+    auto parse_pressure(std::string_view text, Pressure& pressure) -> bool;
+}
+};
+
+#endif /* __PARSER_HPP */
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Pool - Work-stealing pool of collector threads
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __POOL_HPP
+#define __POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Gossip {
+class Pool {
+public:
+    using Work = std::function<void(int worker, std::size_t index)>;
+
+    /*
+     * A pool of `jobs' workers. The thread calling run() is worker zero, so
+     * only `jobs - 1' threads are created; with a single job everything
+     * runs inline.
+     */
+    explicit Pool(int jobs);
+    ~Pool();
+
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    /*
+     * Call `work' once for every index in [0, count) and wait for all of
+     * them to finish. Each worker starts on its own contiguous slice of the
+     * indices and, once done, steals from the far end of the others.
+     * `work' must not throw.
+     */
+    auto run(std::size_t count, const Work& work) -> void;
+
+    auto size() const -> int { return jobs; }
+
+private:
+    /*
+     * [begin, end) of the indices still owned by a worker, packed so both
+     * ends can be claimed with a single compare-and-swap.
+     */
+    struct alignas(64) Range {
+        std::atomic<std::uint64_t> bounds { 0 };
+    };
+
+    auto worker_main(int worker) -> void;
+    auto drain(int worker) -> void;
+    auto take(int worker, std::size_t& index) -> bool;
+    auto steal(int victim, std::size_t& index) -> bool;
+
+    int jobs;
+
+    std::unique_ptr<Range[]> ranges;
+    std::vector<std::thread> threads;
+
+    std::mutex lock;
+    std::condition_variable start;
+    std::condition_variable finish;
+
+    const Work* work;
+    std::uint64_t generation;
+    int running;
+    bool stopping;
+};
+};
+
+#endif /* __POOL_HPP */
@@ -8,50 +8,182 @@
 #ifndef __PROCESS_HPP
 #define __PROCESS_HPP
 
+#include <Fields.hpp>
+#include <ProcessCache.hpp>
+#include <Sample.hpp>
+#include <Smaps.hpp>
+#include <array>
+#include <cstdint>
 #include <filesystem>
 #include <iostream>
 #include <limits>
 #include <string>
-#include <vector>
+#include <string_view>
 
 namespace Gossip {
 class Process {
 public:
+    static constexpr std::size_t max_values = Sample::max_values;
+
+    /*
+     * How far stat may move before smaps_rollup is read again. Reading
+     * it walks every page table of the process under its mmap lock;
+     * stat is cheap.
+     */
+    struct Staleness {
+        /* Resident set, in pages */
+        std::int64_t rss = 0;
+
+        /* utime + stime, in clock ticks */
+        std::uint64_t cpu = 0;
+
+        /* Ticks values may be carried over, however idle the process */
+        unsigned max_age = 0;
+    };
+
     Process(const std::filesystem::directory_entry& directory)
-        : directory(directory)
+        : data(own)
+        , directory(&directory)
     {
-        pid = -1;
-        total_time = 0;
+        cache = nullptr;
+        entry = nullptr;
     }
 
-    auto extract() -> void;
+    /*
+     * Resample through descriptors kept open in `cache' rather than
+     * opening every file again.
+     */
+    Process(const std::filesystem::directory_entry& directory,
+        ProcessCache& cache)
+        : Process(directory)
+    {
+        this->cache = &cache;
+    }
 
-    friend std::ostream& operator<<(std::ostream& os, const Process& process)
+    /*
+     * Known by PID alone, as listed by a Scanner. Every file is read
+     * through `cache'.
+     */
+    Process(int pid, ProcessCache& cache)
+        : data(own)
+        , directory(nullptr)
     {
-        os << process.pid << "," << process.comm << ",";
+        this->cache = &cache;
+        entry = nullptr;
+        data.pid = pid;
+    }
 
-        for (int value : process.values) {
-            os << value << ",";
-        }
+    /*
+     * Filling in `row' rather than a Sample of its own, e.g. one kept
+     * from tick to tick so that its name needs no new allocation.
+     */
+    Process(int pid, ProcessCache& cache, Sample& row)
+        : data(row)
+        , directory(nullptr)
+    {
+        this->cache = &cache;
+        entry = nullptr;
+        data.pid = pid;
+        data.starttime = 0;
+        data.comm.clear();
+        data.num_values = 0;
+        data.total_time = 0;
+        data.freshness = Sample::Freshness::always;
+    }
+
+    /*
+     * Returns false for kernel threads, which have no memory of their
+     * own to report. They are told apart by their stat flags, before
+     * cmdline or smaps_rollup are ever read.
+     */
+    auto extract() -> bool;
+
+    /*
+     * Read stat alone, for a cheap look at the process before deciding
+     * whether the rest is worth reading. Returns false for kernel
+     * threads; extract() afterwards won't read stat again.
+     */
+    auto peek() -> bool;
 
-        os << process.total_time << ",";
+    /* From stat, once peeked at: resident pages and virtual bytes */
+    auto resident() const -> std::int64_t { return rss; }
+    auto virtual_size() const -> std::uint64_t { return vsize; }
 
-        return os;
+    /*
+     * Hand over the contents of stat or smaps_rollup when the caller
+     * already read them, e.g. batched through io_uring. extract() parses
+     * those instead of reading the files again.
+     */
+    auto prefetch(ProcessCache::File file, std::string_view text) -> void
+    {
+        prefetched[static_cast<std::size_t>(file)] = text;
+    }
+
+    /*
+     * Carry smaps_rollup values over from the last tick that read them,
+     * unless stat moved past `limits'. Needs a ProcessCache to remember
+     * them in, without one every tick reads smaps_rollup.
+     */
+    auto carry_over(const Staleness& limits) -> void { staleness = &limits; }
+
+    /*
+     * Only read the files `fields' needs, and only parse the smaps_rollup
+     * values it asks for. Without a selection, everything is read.
+     */
+    auto select(const Fields::Selection& fields) -> void
+    {
+        selection = &fields;
+    }
+
+    /*
+     * Also break its memory down per mapping into `smaps', from the much
+     * larger /proc/$PID/smaps. Left empty if that can't be read.
+     */
+    auto break_down(Smaps& smaps) -> void { mappings = &smaps; }
+
+    /* Everything extract() found out about this process */
+    auto sample() const -> const Sample& { return data; }
+
+    friend std::ostream& operator<<(std::ostream& os, const Process& process)
+    {
+        return os << process.data;
     }
 
 private:
     auto get_pid() -> void;
     auto get_cmdline() -> void;
     auto get_smaps_rollup() -> void;
+    auto get_smaps() -> void;
     auto get_stat() -> void;
+    auto stale() const -> bool;
+    auto parse_keys(std::string_view text) -> std::size_t;
+
+    auto read(ProcessCache::File file, std::string_view name)
+        -> std::string_view;
+
+    Sample own;
+    Sample& data;
+
+    /* PF_KTHREAD was set in its stat flags */
+    bool kernel_thread = false;
+
+    /* stat was read already */
+    bool peeked = false;
+
+    /* Resident pages and virtual bytes, from stat */
+    std::int64_t rss = 0;
+    std::uint64_t vsize = 0;
+
+    const Staleness* staleness = nullptr;
+    const Fields::Selection* selection = nullptr;
+    Smaps* mappings = nullptr;
 
-    int total_time;
-    int pid;
+    ProcessCache* cache;
+    ProcessCache::Entry* entry;
 
-    std::string comm;
-    std::vector<int> values;
+    std::array<std::string_view, 2> prefetched;
 
-    const std::filesystem::directory_entry& directory;
+    const std::filesystem::directory_entry* directory;
 };
 };
 
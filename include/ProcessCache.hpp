@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * ProcessCache - Per-PID file descriptors kept open across samples
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __PROCESS_CACHE_HPP
+#define __PROCESS_CACHE_HPP
+
+#include <Parser.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Gossip {
+class ProcessCache {
+public:
+    enum class File { stat, smaps_rollup, cmdline };
+
+    struct Entry {
+        int pid = -1;
+
+        /* Indexed by File; cmdline is never kept open */
+        std::array<int, 2> fds { -1, -1 };
+
+        /* Identifies this particular process behind `pid' */
+        std::uint64_t starttime = 0;
+
+        /* Resolved from cmdline once per process lifetime */
+        std::string comm;
+
+        /*
+         * In adaptive mode, smaps_rollup values as last read, with the
+         * resident pages and CPU time stat reported at that point and how
+         * many ticks they have been carried over since.
+         */
+        std::vector<std::uint64_t> values;
+        std::int64_t rss = 0;
+        std::uint64_t total_time = 0;
+        unsigned age = 0;
+
+        std::uint64_t last_seen = 0;
+    };
+
+    /*
+     * stat is always kept open, smaps_rollup only if `smaps_rollup' is
+     * set; otherwise it's never opened unless read() asks for it.
+     */
+    explicit ProcessCache(
+        const std::filesystem::path& procfs, bool smaps_rollup = true);
+    ~ProcessCache();
+
+    ProcessCache(const ProcessCache&) = delete;
+    ProcessCache& operator=(const ProcessCache&) = delete;
+
+    /*
+     * Start a new tick. Entries not acquired again before end_tick() belong
+     * to processes that exited and are evicted.
+     */
+    auto begin_tick() -> void;
+    auto end_tick() -> void;
+
+    /*
+     * Look up `pid', opening its files on first use. acquire(), read() and
+     * renew() may be called from several threads at once, as long as each
+     * entry is only used by one thread per tick.
+     */
+    auto acquire(int pid) -> Entry&;
+
+    /*
+     * Read one of the entry's files. If the cached descriptor went stale,
+     * because the process exited and its PID may have been reused, the
+     * files are opened again and the read retried once.
+     */
+    auto read(Entry& entry, File file, Parser::Buffer& buffer)
+        -> std::string_view;
+
+    /*
+     * A different process now lives behind `entry.pid'. Forget what we
+     * knew about the previous one.
+     */
+    auto renew(Entry& entry, std::uint64_t starttime) -> void;
+
+    /*
+     * Close one of the entry's descriptors for good; reading that file
+     * later on opens it every time.
+     */
+    auto release(Entry& entry, File file) -> void;
+
+    auto size() const -> std::size_t { return entries.size(); }
+
+    /* Descriptors any cache may still keep open */
+    static auto available() -> long;
+
+    /*
+     * Open `name' in the directory of `pid', for files that are never
+     * kept open. The caller closes the descriptor.
+     */
+    auto openat(int pid, std::string_view name) -> int;
+
+private:
+    auto open(Entry& entry) -> void;
+    auto close(Entry& entry) -> void;
+
+    std::mutex lock;
+    std::unordered_map<int, Entry> entries;
+    std::uint64_t generation;
+
+    /* How many more descriptors all caches together may keep open */
+    std::atomic<long>& budget;
+
+    /* How many of Entry::fds, from the first, are kept open */
+    std::size_t kept;
+
+    int procfs_fd;
+};
+};
+
+#endif /* __PROCESS_CACHE_HPP */
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * ProcessTable - What was last seen of each process, by PID and starttime
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __PROCESS_TABLE_HPP
+#define __PROCESS_TABLE_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Gossip {
+/*
+ * Open addressing with linear probing. Keys are kept apart from the
+ * state they map to, so a probe runs through four of them per cache
+ * line. A reused PID has a different starttime, and so is a different
+ * process altogether.
+ *
+ * Entries live from tick to tick: those not inserted again by the end
+ * of a tick are gone. Nothing is allocated once the table has grown to
+ * the number of processes.
+ */
+class ProcessTable {
+public:
+    /* Whatever its users need to remember */
+    struct State {
+        std::uint64_t total_time = 0;
+        std::uint64_t rss = 0;
+        std::uint64_t pss = 0;
+
+        /* CLOCK_MONOTONIC nanoseconds of the tick it was seen in */
+        std::int64_t time = 0;
+
+        std::string comm;
+    };
+
+    ProcessTable();
+
+    auto begin_tick() -> void { tick++; }
+
+    /* Null if it wasn't seen, valid until the next insert() */
+    auto find(int pid, std::uint64_t starttime) const -> const State*;
+
+    /*
+     * Mark it seen this tick. Returns its state, valid until the next
+     * insert(), and whether it was already there.
+     */
+    auto insert(int pid, std::uint64_t starttime) -> std::pair<State*, bool>;
+
+    /*
+     * Drop every entry that wasn't inserted since begin_tick(), after
+     * handing it to `exited(pid, starttime, state)'.
+     */
+    template <typename Exited> auto end_tick(Exited&& exited) -> void
+    {
+        if (seen == count) {
+            seen = 0;
+            return;
+        }
+
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            if (keys[i].pid >= 0 && keys[i].tick != tick)
+                exited(keys[i].pid, keys[i].starttime, states[i]);
+        }
+
+        rebuild(keys.size(), true);
+    }
+
+    auto size() const -> std::size_t { return count; }
+
+private:
+    struct Key {
+        /* Negative when the slot is empty */
+        int pid = -1;
+
+        /* Last tick it was inserted in */
+        std::uint32_t tick = 0;
+
+        std::uint64_t starttime = 0;
+    };
+
+    auto slot(int pid, std::uint64_t starttime) const -> std::size_t;
+    auto rebuild(std::size_t capacity, bool seen_only) -> void;
+
+    std::vector<Key> keys;
+    std::vector<State> states;
+
+    /* Rebuilt into these, then swapped, to reuse their memory */
+    std::vector<Key> spare_keys;
+    std::vector<State> spare_states;
+
+    std::size_t count;
+    std::size_t seen;
+    std::uint32_t tick;
+};
+};
+
+#endif /* __PROCESS_TABLE_HPP */
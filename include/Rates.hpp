@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Rates - How each process changed since the last tick
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __RATES_HPP
+#define __RATES_HPP
+
+#include <ProcessTable.hpp>
+#include <Sample.hpp>
+#include <Writer.hpp>
+#include <iostream>
+#include <span>
+#include <string_view>
+
+namespace Gossip {
+/*
+ * Joins each tick with the previous one by PID and starttime, so that
+ * consumers don't have to: CPU usage in percent of one CPU, and how fast
+ * Rss and Pss grow, in kB per second. Processes showing up and going
+ * away are written as start and exit events.
+ */
+class Rates {
+public:
+    /*
+     * `fields' are the columns collected; Rss and Pss rates are left
+     * empty unless among them. Either output may be null.
+     */
+    Rates(std::span<const std::string_view> fields,
+        std::ostream* rate_output, std::ostream* event_output);
+
+    /* Every tick, in order, with every process it found */
+    auto write(const Tick& tick) -> void;
+
+private:
+    std::ostream* rate_output;
+    std::ostream* event_output;
+
+    /* Index into Sample::values, negative if not collected */
+    int rss_column;
+    int pss_column;
+
+    double clock_ticks;
+
+    /* Nobody started during the first tick, they were all there */
+    bool first;
+
+    ProcessTable table;
+};
+};
+
+#endif /* __RATES_HPP */
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Replay - Plays a capture back through the usual extractors
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __REPLAY_HPP
+#define __REPLAY_HPP
+
+#include <Capture.hpp>
+#include <Fields.hpp>
+#include <Sample.hpp>
+#include <System.hpp>
+#include <Writer.hpp>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace Gossip {
+/*
+ * Lays the files of each captured tick out under a scratch directory,
+ * the way procfs has them, and reads them back with Process and System
+ * like a live run would. Whatever they parse differently from one
+ * version to the next, a capture taken once can be decoded again.
+ */
+class Replay : public Reader {
+public:
+    /*
+     * A fresh directory of its own is made in `parent', and removed along
+     * with everything in it once done; nothing else in `parent' is
+     * touched. Throws std::runtime_error if it can't be made, and
+     * std::invalid_argument if the columns `reader' was captured for are
+     * unknown.
+     */
+    Replay(CaptureReader& reader,
+        const std::filesystem::path& parent
+        = std::filesystem::temp_directory_path());
+    ~Replay();
+
+    Replay(const Replay&) = delete;
+    Replay& operator=(const Replay&) = delete;
+
+    auto fields() const -> std::span<const std::string_view> override
+    {
+        return reader.fields();
+    }
+
+    auto next(Tick& tick) -> bool override;
+
+    /* Where each tick's files are laid out */
+    auto path() const -> const std::filesystem::path& { return scratch; }
+
+    /* The system-wide files of the last tick, if they were captured */
+    auto system() const -> const System*
+    {
+        return captured_system ? &*system_snapshot : nullptr;
+    }
+
+private:
+    CaptureReader& reader;
+    std::filesystem::path scratch;
+    std::filesystem::directory_entry directory;
+
+    Fields::Selection selection;
+
+    std::vector<CaptureReader::Record> records;
+    std::vector<int> pids;
+    std::vector<Sample> samples;
+
+    /* Lives across ticks, like it does in a live run */
+    std::optional<System> system_snapshot;
+    bool captured_system;
+};
+};
+
+#endif /* __REPLAY_HPP */
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Sample - What we record about one process in one tick
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __SAMPLE_HPP
+#define __SAMPLE_HPP
+
+#include <Fields.hpp>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace Gossip {
+struct Sample {
+    /* Current kernels report 22 fields in smaps_rollup */
+    static constexpr std::size_t max_values = 32;
+
+    /* Output columns, in order, when all of them are written */
+    static constexpr auto fields
+        = Fields::names<Fields::table.size() - 1>("Fresh");
+
+    /* With Collector::Options::adaptive, Fresh tells the two apart */
+    static constexpr auto adaptive_fields
+        = Fields::names<Fields::table.size()>();
+
+    /* Where the smaps_rollup values came from */
+    enum class Freshness : std::uint8_t {
+        /* Read every tick, the only choice outside of adaptive mode */
+        always,
+
+        /* Read this tick */
+        fresh,
+
+        /* Copied from the last tick that read them */
+        carried,
+    };
+
+    int pid = -1;
+
+    /* From stat; with `pid', tells a process apart from one reusing it */
+    std::uint64_t starttime = 0;
+
+    std::string comm;
+
+    std::array<std::uint64_t, max_values> values;
+    std::size_t num_values = 0;
+
+    std::uint64_t total_time = 0;
+
+    Freshness freshness = Freshness::always;
+
+    friend std::ostream& operator<<(std::ostream& os, const Sample& sample)
+    {
+        os << sample.pid << "," << sample.comm << ",";
+
+        for (std::size_t i = 0; i < sample.num_values; i++) {
+            os << sample.values[i] << ",";
+        }
+
+        os << sample.total_time << ",";
+
+        if (sample.freshness != Freshness::always)
+            os << (sample.freshness == Freshness::fresh) << ",";
+
+        return os;
+    }
+};
+};
+
+#endif /* __SAMPLE_HPP */
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * SampleTable - Rows of samples, reused from tick to tick
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __SAMPLE_TABLE_HPP
+#define __SAMPLE_TABLE_HPP
+
+#include <Sample.hpp>
+#include <span>
+#include <vector>
+
+namespace Gossip {
+/*
+ * One row per process of a tick. Rows are never destroyed, only reused,
+ * names and all: once the table has grown to the number of processes
+ * and the rows to their names, a tick allocates nothing.
+ */
+class SampleTable {
+public:
+    /* `count' rows, none of them used yet */
+    auto reset(std::size_t count) -> void;
+
+    /* Fill in a row, and mark it used by giving it a PID */
+    auto operator[](std::size_t index) -> Sample& { return table[index]; }
+
+    /*
+     * Leave out the rows that weren't used, keeping the others in
+     * order. Those left out are swapped to the back rather than erased.
+     */
+    auto compact() -> void;
+
+    /* Let go of the rows past those used, for the next tick to grow */
+    auto trim() -> void;
+
+    auto rows() const -> std::span<const Sample>
+    {
+        return { table.data(), used };
+    }
+
+    auto size() const -> std::size_t { return used; }
+
+private:
+    std::vector<Sample> table;
+    std::size_t used = 0;
+};
+};
+
+#endif /* __SAMPLE_TABLE_HPP */
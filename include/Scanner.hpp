@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Scanner - Lists the PIDs in procfs
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __SCANNER_HPP
+#define __SCANNER_HPP
+
+#include <filesystem>
+#include <vector>
+
+namespace Gossip {
+/*
+ * Reads the procfs root with getdents64() into a buffer reused across
+ * scans. Anything that isn't a directory named by a number is skipped
+ * without ever building a path or a string for it.
+ */
+class Scanner {
+public:
+    explicit Scanner(const std::filesystem::path& procfs);
+    ~Scanner();
+
+    Scanner(const Scanner&) = delete;
+    Scanner& operator=(const Scanner&) = delete;
+
+    /*
+     * Every PID in procfs right now, in ascending order. Valid until the
+     * next call, which moves it to previous().
+     */
+    auto scan() -> const std::vector<int>&;
+
+    /*
+     * What the scan before the last one found, also sorted, so the two
+     * can be compared with std::set_difference() and friends.
+     */
+    auto previous() const -> const std::vector<int>& { return last; }
+
+private:
+    int fd;
+    std::vector<char> buffer;
+    std::vector<int> current;
+    std::vector<int> last;
+};
+};
+
+#endif /* __SCANNER_HPP */
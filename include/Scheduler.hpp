@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Scheduler - Fixed-rate tick deadlines on the monotonic clock
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __SCHEDULER_HPP
+#define __SCHEDULER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <poll.h>
+#include <span>
+#include <string>
+
+namespace Gossip {
+/*
+ * Ticks start at fixed multiples of the period after the first one, no
+ * matter how long each of them takes, so the sampling rate doesn't
+ * drift. A tick running past the start of the next one makes us skip
+ * ahead to the first deadline still in the future.
+ */
+class Scheduler {
+public:
+    explicit Scheduler(std::chrono::nanoseconds period);
+
+    /* CLOCK_MONOTONIC, in nanoseconds */
+    static auto now() -> std::int64_t;
+
+    /*
+     * "250ms", "2s" or plain seconds such as "1.5". Throws
+     * std::invalid_argument for anything else, or below a millisecond.
+     */
+    static auto parse_interval(const std::string& text)
+        -> std::chrono::milliseconds;
+
+    /*
+     * Sleep until the next deadline; the first call returns right away.
+     * Returns how many deadlines were skipped because the previous tick
+     * overran them.
+     */
+    auto wait() -> std::uint32_t;
+
+    /*
+     * Same as above, but also wake up as soon as one of `fds' has an
+     * event, which leaves it in their `revents'. The grid then starts
+     * over from that moment, and the tick right away.
+     */
+    auto wait(std::span<pollfd> fds) -> std::uint32_t;
+
+    /* Ticks are `period' apart from the last one on */
+    auto retime(std::chrono::nanoseconds period) -> void;
+
+    /* Ticks that took longer than the period */
+    auto overruns() const -> std::uint64_t { return num_overruns; }
+
+    /* Deadlines skipped because of them */
+    auto skipped() const -> std::uint64_t { return num_skipped; }
+
+private:
+    /* Move on to the next deadline still ahead, counting those missed */
+    auto advance(std::int64_t current) -> std::uint32_t;
+
+    std::int64_t period;
+    std::int64_t deadline;
+    bool started;
+
+    std::uint64_t num_overruns;
+    std::uint64_t num_skipped;
+};
+};
+
+#endif /* __SCHEDULER_HPP */
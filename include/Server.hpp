@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Server - Answers queries about the History over a Unix socket
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __SERVER_HPP
+#define __SERVER_HPP
+
+#include <History.hpp>
+#include <filesystem>
+#include <iostream>
+#include <span>
+#include <string_view>
+#include <thread>
+
+namespace Gossip {
+/*
+ * One request per connection, a single line of text, answered with CSV
+ * in the same columns as the output file:
+ *
+ *   ticks              Number, process count and timestamp of every
+ *                      tick kept
+ *   tick N             Every process at tick N
+ *   pid P [SECONDS]    Process P in every tick kept, or only the ticks
+ *                      from the last SECONDS
+ *
+ * Anything else gets a line starting with "error: ". Requests are
+ * answered one at a time, from a thread of its own.
+ */
+class Server {
+public:
+    /*
+     * Listen at `path', taking over a socket left behind by a previous
+     * run, but never one another daemon still listens on. Throws
+     * std::runtime_error if that can't be done.
+     */
+    Server(const std::filesystem::path& path, History& history,
+        std::span<const std::string_view> fields);
+
+    /* Stops answering and removes the socket */
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    auto answer(std::string_view request, std::ostream& reply) -> void;
+
+private:
+    auto serve() -> void;
+    auto handle(int fd) -> void;
+
+    std::filesystem::path path;
+    History& history;
+    std::span<const std::string_view> fields;
+
+    int listen_fd;
+
+    /* Written to by the destructor to wake serve() up */
+    int wake[2];
+
+    std::thread thread;
+};
+};
+
+#endif /* __SERVER_HPP */
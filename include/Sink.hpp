@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Sink - Output file written from a thread of its own
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __SINK_HPP
+#define __SINK_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace Gossip {
+/*
+ * A stream buffer handing whatever was written between two flushes over
+ * to a writer thread, so a slow disk or flash never holds up sampling.
+ * Writers flush once per tick, so every buffer holds whole ticks.
+ *
+ * At most `depth' buffers wait to be written. When the collector gets
+ * that far ahead, the policy decides whether it waits for storage to
+ * catch up or throws the tick away.
+ */
+class Sink : public std::streambuf {
+public:
+    enum class Policy { block, drop };
+
+    Sink(const std::filesystem::path& path, Policy policy,
+        std::size_t depth = 2);
+
+    /* Takes ownership of `fd' */
+    Sink(int fd, Policy policy, std::size_t depth = 2);
+
+    ~Sink();
+
+    Sink(const Sink&) = delete;
+    Sink& operator=(const Sink&) = delete;
+
+    /*
+     * Called, from the thread flushing, whenever a tick is dropped.
+     * Writers that encode a tick relative to the previous one need to
+     * know.
+     */
+    auto on_drop(std::function<void()> hook) -> void
+    {
+        dropped_hook = std::move(hook);
+    }
+
+    /* How many flushes were thrown away under Policy::drop */
+    auto dropped() const -> std::uint64_t { return num_dropped; }
+
+    /*
+     * Write out everything still queued, and whatever was written since
+     * the last flush, and stop the writer thread. Waits for storage under
+     * either policy. Throws std::runtime_error if any write failed.
+     */
+    auto close() -> void;
+
+protected:
+    auto overflow(int_type c) -> int_type override;
+    auto sync() -> int override;
+
+private:
+    static constexpr std::size_t buffer_size = 64 * 1024;
+
+    auto enqueue(bool may_drop) -> void;
+    auto writer_main() -> void;
+    auto write_all(std::vector<std::vector<char>>& batch) -> bool;
+    auto reset_put_area() -> void;
+
+    int fd;
+    Policy policy;
+    std::size_t depth;
+
+    /* Being filled by the collector */
+    std::vector<char> current;
+
+    std::mutex lock;
+    std::condition_variable ready;
+    std::condition_variable space;
+
+    std::deque<std::vector<char>> queued;
+    std::vector<std::vector<char>> spare;
+
+    bool stopping;
+    bool closed;
+    int error;
+
+    std::uint64_t num_dropped;
+    std::function<void()> dropped_hook;
+
+    std::thread writer;
+};
+};
+
+#endif /* __SINK_HPP */
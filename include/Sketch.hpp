@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Sketch - Online statistics in bounded memory
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __SKETCH_HPP
+#define __SKETCH_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace Gossip {
+/* Count, extremes, mean and variance, updated with Welford's method */
+class Moments {
+public:
+    auto add(double value) -> void;
+
+    /* As if every value added to `other' had been added here too */
+    auto merge(const Moments& other) -> void;
+
+    auto count() const -> std::uint64_t { return n; }
+    auto min() const -> double { return low; }
+    auto max() const -> double { return high; }
+    auto mean() const -> double { return average; }
+
+    /* Sample variance, zero below two values */
+    auto variance() const -> double;
+
+private:
+    std::uint64_t n = 0;
+    double low = 0;
+    double high = 0;
+    double average = 0;
+
+    /* Sum of squared differences from the mean */
+    double m2 = 0;
+};
+
+/*
+ * Quantiles within `accuracy' of the true value, relative to it, from
+ * logarithmically sized buckets as in DDSketch. Sketches of the same
+ * accuracy merge exactly. No more than `max_buckets' are kept: past
+ * that, the lowest ones are folded together, which only costs accuracy
+ * at quantiles too low to matter here.
+ */
+class Sketch {
+public:
+    static constexpr double accuracy = 0.01;
+    static constexpr std::size_t max_buckets = 512;
+
+    /* Values below one, in whatever unit, all count as zero */
+    auto add(double value) -> void;
+
+    auto merge(const Sketch& other) -> void;
+
+    auto count() const -> std::uint64_t { return total; }
+
+    /* The `q'th quantile, `q' in [0, 1]; zero if nothing was added */
+    auto quantile(double q) const -> double;
+
+private:
+    auto grow(int index) -> void;
+    auto collapse() -> void;
+
+    std::uint64_t total = 0;
+    std::uint64_t zeros = 0;
+
+    /*
+     * buckets[i] counts values in (r^(first+i-1), r^(first+i)], where r
+     * is (1 + accuracy) / (1 - accuracy)
+     */
+    int first = 0;
+    std::vector<std::uint64_t> buckets;
+};
+};
+
+#endif /* __SKETCH_HPP */
@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Smaps - Per-mapping memory usage from /proc/$PID/smaps
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __SMAPS_HPP
+#define __SMAPS_HPP
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Gossip {
+/*
+ * smaps has one block of "Key: value kB" lines per mapping, and easily
+ * runs into megabytes for large processes. It's streamed through a fixed
+ * buffer, a chunk at a time, adding each mapping's values to those of
+ * every other mapping of the same file. Anonymous mappings are added up
+ * together as `[anon]'.
+ */
+class Smaps {
+public:
+    /* Values added up per mapping, in the order the kernel lists them */
+    static constexpr std::array<std::string_view, 12> keys { "Size", "Rss",
+        "Pss", "Shared_Clean", "Shared_Dirty", "Private_Clean",
+        "Private_Dirty", "Referenced", "Anonymous", "Swap", "SwapPss",
+        "Locked" };
+
+    static constexpr std::size_t default_chunk_size = 64 * 1024;
+
+    struct Mapping {
+        /* How many mappings of this file were added up */
+        std::uint64_t count = 0;
+
+        /* In kB, indexed like `keys' */
+        std::array<std::uint64_t, keys.size()> values {};
+    };
+
+    /* By path, or the kernel's name in brackets, e.g. `[heap]' */
+    using Mappings = std::map<std::string, Mapping, std::less<>>;
+
+    explicit Smaps(std::size_t chunk_size = default_chunk_size)
+        : buffer(chunk_size)
+    {
+    }
+
+    /*
+     * Read smaps from `fd' until its end, replacing what the previous
+     * call found. Returns false if nothing could be read, e.g. because
+     * the process exited.
+     */
+    auto read(int fd) -> bool;
+
+    /* Forget every mapping, as if smaps was empty */
+    auto clear() -> void { totals.clear(); }
+
+    auto mappings() const -> const Mappings& { return totals; }
+
+    static auto write_header(std::ostream& os) -> void;
+
+    /* One line per mapping, starting with `pid' and ending in `timestamp' */
+    auto write(std::ostream& os, int pid, std::string_view timestamp) const
+        -> void;
+
+private:
+    auto consume(std::string_view text) -> std::size_t;
+    auto parse_line(std::string_view line) -> void;
+
+    std::vector<char> buffer;
+    Mappings totals;
+
+    /* Where values go until the next mapping starts */
+    Mapping* current = nullptr;
+
+    /* Lines longer than the buffer are cut short, drop what's left */
+    bool truncated = false;
+
+    /* Index of the key after the one last found */
+    std::size_t next = 0;
+};
+};
+
+#endif /* __SMAPS_HPP */
@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Stats - Where gossip itself spends its time
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __STATS_HPP
+#define __STATS_HPP
+
+#include <Writer.hpp>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+
+namespace Gossip {
+namespace Stats {
+    /* Phases of a tick we keep latency histograms for */
+    enum class Phase {
+        tick,
+        scan,
+        system,
+        cgroups,
+        cpu,
+        process,
+        rank,
+        open,
+        read,
+        parse_stat,
+        parse_cmdline,
+        parse_smaps_rollup,
+        parse_smaps,
+        write,
+    };
+
+    constexpr std::array<std::string_view, 14> phase_names { "Tick", "Scan",
+        "System", "Cgroups", "Cpu", "Process", "Rank", "Open", "Read",
+        "Parse_Stat", "Parse_Cmdline", "Parse_Smaps_Rollup", "Parse_Smaps",
+        "Write" };
+
+    enum class Counter {
+        /* Process directories looked at */
+        visited,
+
+        /* Kernel threads and anything else without smaps_rollup values */
+        skipped,
+
+        /* Processes that exited while we were reading them */
+        vanished,
+
+        /* smaps_rollup reads saved by carrying values over */
+        carried,
+    };
+
+    constexpr std::array<std::string_view, 4> counter_names { "Visited",
+        "Skipped", "Vanished", "Carried" };
+
+    /*
+     * Off unless enable() is called, before any collection starts. While
+     * off, timers and counters cost a predictable branch each.
+     */
+    inline bool enabled = false;
+
+    auto enable() -> void;
+
+    auto record(Phase phase, std::int64_t nanoseconds) -> void;
+    auto add(Counter counter) -> void;
+
+    inline auto count(Counter counter) -> void
+    {
+        if (enabled)
+            add(counter);
+    }
+
+    /* Times its own lifetime */
+    class Timer {
+    public:
+        explicit Timer(Phase phase)
+            : phase(phase)
+            , start(enabled ? now() : 0)
+        {
+        }
+
+        ~Timer()
+        {
+            if (start)
+                record(phase, now() - start);
+        }
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+    private:
+        static auto now() -> std::int64_t;
+
+        Phase phase;
+        std::int64_t start;
+    };
+
+    auto write_header(std::ostream& os) -> void;
+
+    /*
+     * Write one line with everything recorded, by any thread, since the
+     * previous call and start over. Only call this while no other thread
+     * is recording.
+     */
+    auto write(std::ostream& os, const Tick& tick) -> void;
+};
+};
+
+#endif /* __STATS_HPP */
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Summary - Per-process statistics instead of every sample
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __SUMMARY_HPP
+#define __SUMMARY_HPP
+
+#include <Sample.hpp>
+#include <Sketch.hpp>
+#include <Writer.hpp>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace Gossip {
+/*
+ * A Writer folding every tick into online statistics of each process,
+ * told apart by PID and starttime, and only writing those out every
+ * `interval' ticks and when finished. Memory grows with the number of
+ * processes, never with the number of ticks.
+ *
+ * Each summary covers every process seen since the previous one, from
+ * the first tick it was seen in. Processes that exited are dropped once
+ * they are written out.
+ */
+class Summary : public Writer {
+public:
+    /* What each process is summarized by, in this order */
+    static constexpr std::array<std::string_view, 4> metrics { "Rss", "Pss",
+        "Swap", "CPU" };
+
+    /*
+     * `fields' are the columns collected, where the smaps_rollup values
+     * are looked up. Metrics that aren't among them are left out. With
+     * an `interval' of zero, only finish() writes anything.
+     */
+    Summary(std::ostream& output,
+        std::span<const std::string_view> fields = Sample::fields,
+        unsigned interval = 0);
+
+    auto write(const Tick& tick) -> void override;
+
+    /* Write out whatever wasn't yet, after the last tick */
+    auto finish() -> void;
+
+private:
+    struct Process {
+        std::string comm;
+
+        /* Indexed like `metrics' */
+        std::array<Moments, metrics.size()> moments;
+        std::array<Sketch, metrics.size()> sketches;
+
+        /* As of the last tick, to turn CPU time into usage */
+        std::uint64_t total_time = 0;
+        std::int64_t start = 0;
+
+        std::uint64_t last_seen = 0;
+    };
+
+    auto summarize() -> void;
+
+    std::ostream& output;
+    unsigned interval;
+
+    /* Index into Sample::values of each metric, negative if not there */
+    std::array<int, metrics.size()> columns;
+
+    /* By PID and starttime, so a reused PID starts over */
+    std::map<std::pair<int, std::uint64_t>, Process> processes;
+
+    std::uint64_t ticks;
+    std::uint64_t summarized;
+
+    /* For the timestamp of each summary */
+    std::int64_t time;
+    std::int32_t utc_offset;
+
+    double clock_ticks;
+};
+};
+
+#endif /* __SUMMARY_HPP */
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * System - System-wide snapshot, taken once per tick
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __SYSTEM_HPP
+#define __SYSTEM_HPP
+
+#include <Cpu.hpp>
+#include <Parser.hpp>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+
+namespace Gossip {
+class System {
+public:
+    /* Fields picked from /proc/meminfo, in the order the kernel lists them */
+    static constexpr std::array<std::string_view, 12> meminfo_keys {
+        "MemTotal", "MemFree", "MemAvailable", "Buffers", "Cached",
+        "SwapCached", "SwapTotal", "SwapFree", "AnonPages", "Mapped", "Shmem",
+        "Slab" };
+
+    System(const std::filesystem::directory_entry& directory)
+        : directory(directory)
+        , loadavg_path(directory.path() / "loadavg")
+        , meminfo_path(directory.path() / "meminfo")
+        , cpu(directory)
+    {
+        meminfo.fill(0);
+    }
+
+    auto extract() -> void;
+
+    /*
+     * The per-CPU columns follow the online CPUs, so the header has to be
+     * written again whenever they change.
+     */
+    auto changed() const -> bool { return cpu.changed(); }
+
+    /* With a Burst column naming the trigger of each tick, if `bursts' */
+    auto write_header(std::ostream& os, bool bursts = false) const -> void;
+
+    friend std::ostream& operator<<(std::ostream& os, const System& system)
+    {
+        auto& load = system.loadavg;
+
+        os << system.cpu << load.load_1 << "," << load.load_5 << ","
+           << load.load_15 << "," << load.runnable << "," << load.threads
+           << ",";
+
+        for (auto value : system.meminfo) {
+            os << value << ",";
+        }
+
+        for (auto& online : system.cpu.online()) {
+            os << online.total_time << "," << online.idle_time << ",";
+        }
+
+        return os;
+    }
+
+private:
+    auto get_loadavg() -> void;
+    auto get_meminfo() -> void;
+
+    const std::filesystem::directory_entry& directory;
+
+    /* Built once, rather than every tick */
+    const std::filesystem::path loadavg_path;
+    const std::filesystem::path meminfo_path;
+
+    Cpu cpu;
+    Parser::Loadavg loadavg;
+    std::array<std::uint64_t, meminfo_keys.size()> meminfo;
+};
+};
+
+#endif /* __SYSTEM_HPP */
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Threads - Per-thread CPU time of one process
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __THREADS_HPP
+#define __THREADS_HPP
+
+#include <ProcessCache.hpp>
+#include <Scanner.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Gossip {
+/*
+ * Lists /proc/$PID/task and reads the stat of every thread in it. The
+ * task directory and each thread's stat stay open across ticks, the
+ * same way Collector keeps those of whole processes, so a process with
+ * thousands of threads costs a getdents64() and a pread() per thread.
+ */
+class Threads {
+public:
+    struct Thread {
+        /* Negative if it exited before its stat was read */
+        int tid = -1;
+
+        /* As in stat, which the thread may have renamed itself to */
+        std::string name;
+
+        /* utime + stime, in clock ticks */
+        std::uint64_t total_time = 0;
+    };
+
+    Threads(const std::filesystem::path& procfs, int pid);
+
+    /*
+     * List the threads of the process, ready to be extracted. Returns
+     * how many there are, none if the process is gone.
+     */
+    auto scan() -> std::size_t;
+
+    /*
+     * Read the stat of the `index'th thread scan() found. Different
+     * threads may be extracted from several workers at once.
+     */
+    auto extract(std::size_t index) -> void;
+
+    /* Evict the threads that exited since the previous tick */
+    auto finish() -> void;
+
+    auto pid() const -> int { return process; }
+
+    auto threads() const -> const std::vector<Thread>& { return list; }
+
+    static auto write_header(std::ostream& os) -> void;
+
+    /* One line per thread, ending in `timestamp' */
+    auto write(std::ostream& os, std::string_view timestamp) const -> void;
+
+private:
+    int process;
+    std::filesystem::path task;
+
+    /* Opened once the process is there, and again should its PID be reused */
+    std::optional<Scanner> scanner;
+    std::optional<ProcessCache> cache;
+
+    std::vector<Thread> list;
+};
+};
+
+#endif /* __THREADS_HPP */
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Top - The heaviest processes of each tick
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __TOP_HPP
+#define __TOP_HPP
+
+#include <Fields.hpp>
+#include <Process.hpp>
+#include <ProcessTable.hpp>
+#include <Sample.hpp>
+#include <SampleTable.hpp>
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Gossip {
+/*
+ * Picks the `count' heaviest processes of a tick by one metric, while
+ * reading smaps_rollup of as few of the others as it can. stat, read for
+ * every process anyway, bounds each metric from above: Pss never
+ * exceeds the resident set, nor Swap what of the address space isn't
+ * resident. Processes are read in descending order of their bound, and
+ * once the lightest of the heaviest so far outweighs the next bound,
+ * nobody left can make it.
+ */
+class Top {
+public:
+    enum class Metric : std::uint8_t {
+        rss,
+        pss,
+        swap,
+        cpu,
+    };
+
+    static constexpr std::array<std::string_view, 4> metric_names { "rss",
+        "pss", "swap", "cpu" };
+
+    /* A process stat was read for, and how heavy it might be */
+    struct Candidate {
+        int pid = -1;
+        std::uint64_t starttime = 0;
+        std::uint64_t total_time = 0;
+        std::uint64_t bound = 0;
+    };
+
+    /*
+     * `metric' is one of `metric_names'. Memory is ranked by the values
+     * `fields' collects, so they must include it. Throws
+     * std::invalid_argument otherwise.
+     */
+    Top(std::size_t count, std::string_view metric,
+        const Fields::Selection& fields);
+
+    /*
+     * `process' was peeked at. The resident set from stat is what
+     * smaps_rollup adds up to, give or take the kernel's per-CPU
+     * counters. CPU is the time used since the last tick, or since the
+     * process started if it wasn't around then; stat has it exactly.
+     */
+    auto candidate(const Process& process) const -> Candidate;
+
+    /*
+     * Drop the candidates left with a negative PID, and sort the rest
+     * heaviest first. Starts a new tick, remembering everyone's CPU
+     * time for the next one.
+     */
+    auto rank(std::vector<Candidate>& candidates) -> void;
+
+    /* Whether a process bound by `bound' may still make the cut */
+    auto contends(std::uint64_t bound) const -> bool
+    {
+        return heap.size() < count || bound > heap.front().first;
+    }
+
+    /* How many more it takes to fill the top */
+    auto missing() const -> std::size_t { return count - heap.size(); }
+
+    /* A process read in full, and the candidate it came from */
+    auto offer(const Sample& sample, const Candidate& candidate) -> void;
+
+    /* Move the heaviest out into `samples', in PID order */
+    auto take(SampleTable& samples) -> void;
+
+private:
+    std::size_t count;
+    Metric metric;
+
+    /* Index into Sample::values, for memory */
+    std::size_t column;
+
+    std::uint64_t page_kb;
+
+    /* Lightest first, by the metric */
+    std::vector<std::pair<std::uint64_t, Sample>> heap;
+
+    /* CPU time of every process, as of the last tick */
+    ProcessTable times;
+};
+};
+
+#endif /* __TOP_HPP */
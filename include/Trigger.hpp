@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Trigger - What sets off a burst of fast sampling
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __TRIGGER_HPP
+#define __TRIGGER_HPP
+
+#include <ProcessTable.hpp>
+#include <Writer.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <poll.h>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace Gossip {
+/*
+ * Looked at after every tick, with everything it collected. Those that
+ * can tell between ticks hand over a descriptor; the collector polls it
+ * while waiting, and starts a tick right away when it's ready.
+ */
+class Trigger {
+public:
+    virtual ~Trigger() = default;
+
+    /* Marks the ticks of the bursts it set off */
+    virtual auto name() const -> std::string_view = 0;
+
+    /* To poll between ticks, negative for none */
+    virtual auto fd() const -> int { return -1; }
+
+    /* What to poll fd() for */
+    virtual auto events() const -> short { return POLLIN; }
+
+    /* fd() had one of events() */
+    virtual auto notify() -> void { }
+
+    /* Whether a burst should start, or go on, after `tick' */
+    virtual auto fired(const Tick& tick) -> bool = 0;
+};
+
+/*
+ * A PSI trigger, e.g. "some 150000 1000000" for processes stalled on
+ * memory for 150ms out of any second. The kernel notifies us as soon as
+ * that happens, without waiting for the next tick.
+ */
+class PressureTrigger : public Trigger {
+public:
+    /*
+     * `path' is /proc/pressure/memory, or any other resource. Throws
+     * std::runtime_error if the kernel won't have `spec'.
+     */
+    PressureTrigger(const std::filesystem::path& path, const std::string& spec);
+    ~PressureTrigger();
+
+    PressureTrigger(const PressureTrigger&) = delete;
+    PressureTrigger& operator=(const PressureTrigger&) = delete;
+
+    auto name() const -> std::string_view override { return "pressure"; }
+    auto fd() const -> int override { return descriptor; }
+
+    /* These files are always readable, it's POLLPRI that fires */
+    auto events() const -> short override { return POLLPRI; }
+
+    auto notify() -> void override { pending = true; }
+    auto fired(const Tick& tick) -> bool override;
+
+private:
+    int descriptor;
+    bool pending;
+};
+
+/* MemAvailable in /proc/meminfo dropping below a number of kB */
+class MemoryTrigger : public Trigger {
+public:
+    MemoryTrigger(const std::filesystem::path& procfs, std::uint64_t kb);
+
+    auto name() const -> std::string_view override { return "memory"; }
+    auto fired(const Tick& tick) -> bool override;
+
+private:
+    std::filesystem::path meminfo_path;
+    std::uint64_t threshold;
+};
+
+/*
+ * Any process whose Rss grew by a number of kB since the tick before.
+ * Rss has to be among `fields'; throws std::invalid_argument otherwise.
+ */
+class GrowthTrigger : public Trigger {
+public:
+    GrowthTrigger(std::span<const std::string_view> fields, std::uint64_t kb);
+
+    auto name() const -> std::string_view override { return "growth"; }
+    auto fired(const Tick& tick) -> bool override;
+
+private:
+    /* Index into Sample::values */
+    std::size_t column;
+
+    std::uint64_t threshold;
+
+    /* Rss of every process, as of the last tick */
+    ProcessTable table;
+};
+};
+
+#endif /* __TRIGGER_HPP */
@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Uring - Minimal io_uring submission and completion rings
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __URING_HPP
+#define __URING_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Gossip {
+/*
+ * Just enough io_uring to batch reads, talking to the kernel directly so
+ * we don't grow a dependency on liburing. If the kernel (or a seccomp
+ * policy, as on Android) doesn't let us use io_uring, available() returns
+ * false and callers are expected to use plain syscalls instead.
+ */
+class Uring {
+public:
+    explicit Uring(unsigned entries);
+    ~Uring();
+
+    Uring(const Uring&) = delete;
+    Uring& operator=(const Uring&) = delete;
+
+    auto available() const -> bool { return ring_fd >= 0; }
+
+    /* How many requests may be queued or in flight at any time */
+    auto capacity() const -> unsigned { return sq_entries; }
+
+    /*
+     * Queue a read of `len' bytes at `offset'. Returns false when the
+     * submission queue is full.
+     */
+    auto read(int fd, void* buffer, std::size_t len, std::uint64_t offset,
+        std::uint64_t user_data) -> bool;
+
+    /*
+     * Submit everything queued so far and wait until at least `wait'
+     * requests have completed. Returns false on error.
+     */
+    auto submit(unsigned wait) -> bool;
+
+    /*
+     * Call `complete(user_data, result)' for every completion available,
+     * where `result' is what read() would have returned, or -errno.
+     */
+    template <typename F>
+    auto reap(F&& complete) -> unsigned
+    {
+        unsigned count = 0;
+        unsigned head = *cq_head;
+        unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+
+        while (head != tail) {
+            auto& cqe = cqes[head & *cq_mask];
+
+            complete(cqe.user_data, cqe.res);
+            head++;
+            count++;
+        }
+
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+        return count;
+    }
+
+private:
+    /* Mirrors struct io_uring_cqe, without pulling kernel headers in here */
+    struct Completion {
+        std::uint64_t user_data;
+        std::int32_t res;
+        std::uint32_t flags;
+    };
+
+    auto supports_read() -> bool;
+    auto teardown() -> void;
+
+    int ring_fd;
+    unsigned sq_entries;
+    unsigned pending;
+
+    void* sq_ring;
+    void* cq_ring;
+    void* sqes;
+    std::size_t sq_ring_size;
+    std::size_t cq_ring_size;
+    std::size_t sqes_size;
+
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    Completion* cqes;
+};
+};
+
+#endif /* __URING_HPP */
@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Writer - Output formats for process samples
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __WRITER_HPP
+#define __WRITER_HPP
+
+#include <Sample.hpp>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Gossip {
+/* A formatted Tick::timestamp(), kept inline so that none allocates */
+class Timestamp {
+public:
+    operator std::string_view() const { return { text.data(), length }; }
+
+    auto operator==(std::string_view other) const -> bool
+    {
+        return std::string_view { *this } == other;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Timestamp& stamp)
+    {
+        return os << std::string_view { stamp };
+    }
+
+private:
+    friend struct Tick;
+
+    std::array<char, 64> text;
+    std::size_t length = 0;
+};
+
+/* Every process sampled in one pass over /proc */
+struct Tick {
+    /* Seconds since the epoch, and the local offset from UTC at the time */
+    std::int64_t time = 0;
+    std::int32_t utc_offset = 0;
+
+    /* CLOCK_MONOTONIC nanoseconds when collection started and ended */
+    std::int64_t start = 0;
+    std::int64_t end = 0;
+
+    /* Deadlines skipped because the previous tick ran late */
+    std::uint32_t skipped = 0;
+
+    std::span<const Sample> samples;
+
+    static auto now() -> Tick;
+
+    /* Formatted as "%F %T %z" in the local time zone of the capture */
+    auto timestamp() const -> Timestamp;
+};
+
+class Writer {
+public:
+    virtual ~Writer() = default;
+
+    virtual auto write(const Tick& tick) -> void = 0;
+
+    /*
+     * The last tick never made it to storage. Formats relying on the
+     * previous tick must make the next one stand on its own.
+     */
+    virtual auto restart() -> void { }
+};
+
+class Reader {
+public:
+    virtual ~Reader() = default;
+
+    virtual auto fields() const -> std::span<const std::string_view> = 0;
+
+    /*
+     * Read the next tick. Its samples stay valid until the following
+     * call. Returns false at the end of the input and throws
+     * std::runtime_error if it is truncated or corrupt.
+     */
+    virtual auto next(Tick& tick) -> bool = 0;
+};
+
+class CsvWriter : public Writer {
+public:
+    /*
+     * Writes the header line for `fields' right away. Rows follow the
+     * same columns; the smaps_rollup ones take a sample's values in
+     * order, and rows with fewer values are left short.
+     */
+    explicit CsvWriter(std::ostream& output,
+        std::span<const std::string_view> fields = Sample::fields);
+
+    auto write(const Tick& tick) -> void override;
+
+private:
+    enum class Column {
+        pid,
+        comm,
+        value,
+        total_time,
+        fresh,
+        timestamp,
+
+        /* Not in the field table, written empty */
+        unknown,
+    };
+
+    std::ostream& output;
+    std::vector<Column> columns;
+    std::size_t value_columns;
+};
+};
+
+#endif /* __WRITER_HPP */
@@ -0,0 +1,264 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Binary - Compact columnar output format
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Binary.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+template <typename T> auto put(std::vector<char>& out, T value) -> void
+{
+    auto bits = static_cast<std::make_unsigned_t<T>>(value);
+    auto at = out.size();
+
+    out.resize(at + sizeof(T));
+
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(out.data() + at, &bits, sizeof(T));
+    } else {
+        for (std::size_t i = 0; i < sizeof(T); i++)
+            out[at + i] = static_cast<char>(bits >> (8 * i));
+    }
+}
+
+template <typename T> auto get(const char*& in) -> T
+{
+    std::make_unsigned_t<T> bits = 0;
+
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(&bits, in, sizeof(T));
+    } else {
+        for (std::size_t i = 0; i < sizeof(T); i++)
+            bits |= static_cast<decltype(bits)>(
+                        static_cast<unsigned char>(in[i]))
+                << (8 * i);
+    }
+
+    in += sizeof(T);
+
+    return static_cast<T>(bits);
+}
+
+auto put(std::vector<char>& out, std::string_view text) -> void
+{
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+/* tag, time, utc_offset, rows and columns */
+constexpr std::size_t tick_header_size = 4 + 8 + 4 + 4 + 4;
+
+/* start, end and skipped, from version 2 on */
+constexpr std::size_t tick_times_size = 8 + 8 + 4;
+
+/* Fixed-size part of a row up to version 2, not counting its values */
+constexpr std::size_t row_size = 4 + 8 + 1 + 4;
+};
+
+Gossip::BinaryWriter::BinaryWriter(
+    std::ostream& output, std::span<const std::string_view> fields)
+    : output(output)
+{
+    put(block, Binary::magic);
+    put(block, Binary::version);
+    put(block, static_cast<std::uint32_t>(fields.size()));
+
+    for (auto& field : fields) {
+        put(block, static_cast<std::uint16_t>(field.size()));
+        put(block, field);
+    }
+
+    output.write(block.data(), block.size());
+    output.flush();
+}
+
+auto Gossip::BinaryWriter::write(const Tick& tick) -> void
+{
+    auto& samples = tick.samples;
+    std::size_t columns = 0;
+
+    for (auto& sample : samples)
+        columns = std::max(columns, sample.num_values);
+
+    block.clear();
+
+    put(block, Binary::tick_tag);
+    put(block, tick.time);
+    put(block, tick.utc_offset);
+    put(block, tick.start);
+    put(block, tick.end);
+    put(block, tick.skipped);
+    put(block, static_cast<std::uint32_t>(samples.size()));
+    put(block, static_cast<std::uint32_t>(columns));
+
+    for (auto& sample : samples)
+        put(block, static_cast<std::int32_t>(sample.pid));
+
+    for (auto& sample : samples)
+        put(block, sample.total_time);
+
+    for (auto& sample : samples)
+        put(block, static_cast<std::uint8_t>(sample.num_values));
+
+    for (auto& sample : samples)
+        put(block, static_cast<std::uint8_t>(sample.freshness));
+
+    /* Rows with fewer values are padded with zeroes */
+    for (std::size_t column = 0; column < columns; column++) {
+        for (auto& sample : samples)
+            put(block,
+                column < sample.num_values ? sample.values[column]
+                                           : std::uint64_t { 0 });
+    }
+
+    for (auto& sample : samples)
+        put(block, static_cast<std::uint32_t>(sample.comm.size()));
+
+    for (auto& sample : samples)
+        put(block, std::string_view { sample.comm });
+
+    output.write(block.data(), block.size());
+    output.flush();
+}
+
+Gossip::BinaryReader::BinaryReader(std::istream& input)
+    : input(input)
+    , version(0)
+{
+    const char* in;
+
+    if (!fill(Binary::magic.size() + 4 + 4, in)
+        || std::string_view { in, Binary::magic.size() } != Binary::magic)
+        throw std::runtime_error { "Not a gossip binary file" };
+
+    in += Binary::magic.size();
+
+    version = get<std::uint32_t>(in);
+
+    auto num_fields = get<std::uint32_t>(in);
+
+    if (version < 1 || version > Binary::version)
+        throw std::runtime_error { "Unsupported version "
+            + std::to_string(version) };
+
+    for (std::uint32_t i = 0; i < num_fields; i++) {
+        if (!fill(2, in))
+            throw std::runtime_error { "Truncated header" };
+
+        auto length = get<std::uint16_t>(in);
+
+        if (!fill(length, in))
+            throw std::runtime_error { "Truncated header" };
+
+        storage.emplace_back(in, length);
+    }
+
+    names.assign(storage.begin(), storage.end());
+}
+
+auto Gossip::BinaryReader::next(Tick& tick) -> bool
+{
+    if (input.peek() == std::istream::traits_type::eof())
+        return false;
+
+    const char* in;
+
+    auto size = tick_header_size + (version >= 2 ? tick_times_size : 0);
+
+    if (!fill(size, in)
+        || std::string_view { in, Binary::tick_tag.size() } != Binary::tick_tag)
+        throw std::runtime_error { "Corrupt tick" };
+
+    in += Binary::tick_tag.size();
+
+    tick.time = get<std::int64_t>(in);
+    tick.utc_offset = get<std::int32_t>(in);
+    tick.start = tick.end = tick.skipped = 0;
+
+    if (version >= 2) {
+        tick.start = get<std::int64_t>(in);
+        tick.end = get<std::int64_t>(in);
+        tick.skipped = get<std::uint32_t>(in);
+    }
+
+    auto rows = get<std::uint32_t>(in);
+    auto columns = get<std::uint32_t>(in);
+
+    if (columns > Sample::max_values)
+        throw std::runtime_error { "Too many columns: "
+            + std::to_string(columns) };
+
+    auto row = row_size + (version >= 3 ? 1 : 0) + columns * 8;
+
+    if (!fill(rows * row, in))
+        throw std::runtime_error { "Truncated tick" };
+
+    samples.resize(rows);
+
+    for (auto& sample : samples)
+        sample.pid = get<std::int32_t>(in);
+
+    for (auto& sample : samples)
+        sample.total_time = get<std::uint64_t>(in);
+
+    for (auto& sample : samples) {
+        sample.num_values = get<std::uint8_t>(in);
+
+        if (sample.num_values > columns)
+            throw std::runtime_error { "Corrupt tick" };
+    }
+
+    for (auto& sample : samples) {
+        std::uint8_t freshness = version >= 3 ? get<std::uint8_t>(in) : 0;
+
+        if (freshness > static_cast<std::uint8_t>(Sample::Freshness::carried))
+            throw std::runtime_error { "Corrupt tick" };
+
+        sample.freshness = static_cast<Sample::Freshness>(freshness);
+    }
+
+    for (std::size_t column = 0; column < columns; column++) {
+        for (auto& sample : samples)
+            sample.values[column] = get<std::uint64_t>(in);
+    }
+
+    std::size_t total = 0;
+
+    for (auto& sample : samples) {
+        auto length = get<std::uint32_t>(in);
+
+        sample.comm.resize(length);
+        total += length;
+    }
+
+    if (!fill(total, in))
+        throw std::runtime_error { "Truncated tick" };
+
+    for (auto& sample : samples) {
+        sample.comm.assign(in, sample.comm.size());
+        in += sample.comm.size();
+    }
+
+    tick.samples = samples;
+
+    return true;
+}
+
+/*
+ * Read exactly `length' bytes into `block' and point `in' at them. Returns
+ * false if the file ended first.
+ */
+auto Gossip::BinaryReader::fill(std::size_t length, const char*& in) -> bool
+{
+    block.resize(length);
+    in = block.data();
+
+    return static_cast<bool>(
+        input.read(block.data(), static_cast<std::streamsize>(length)));
+}
@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Capture - Raw /proc files, archived for parsing elsewhere
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Capture.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+template <typename T> auto put(std::vector<char>& out, T value) -> void
+{
+    auto bits = static_cast<std::make_unsigned_t<T>>(value);
+    auto at = out.size();
+
+    out.resize(at + sizeof(T));
+
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(out.data() + at, &bits, sizeof(T));
+    } else {
+        for (std::size_t i = 0; i < sizeof(T); i++)
+            out[at + i] = static_cast<char>(bits >> (8 * i));
+    }
+}
+
+template <typename T> auto get(const char*& in) -> T
+{
+    std::make_unsigned_t<T> bits = 0;
+
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(&bits, in, sizeof(T));
+    } else {
+        for (std::size_t i = 0; i < sizeof(T); i++)
+            bits |= static_cast<decltype(bits)>(
+                        static_cast<unsigned char>(in[i]))
+                << (8 * i);
+    }
+
+    in += sizeof(T);
+
+    return static_cast<T>(bits);
+}
+
+auto put(std::vector<char>& out, std::string_view text) -> void
+{
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+/* pid, file, tick and length */
+constexpr std::size_t record_size = 4 + 1 + 4 + 4;
+
+/* time, utc_offset, start, end and skipped */
+constexpr std::size_t times_size = 8 + 4 + 8 + 8 + 4;
+
+auto read(std::istream& input, char* buffer, std::size_t length) -> bool
+{
+    return static_cast<bool>(
+        input.read(buffer, static_cast<std::streamsize>(length)));
+}
+};
+
+Gossip::CaptureWriter::CaptureWriter(std::ostream& output,
+    std::span<const std::string_view> fields, bool bursts)
+    : output(output)
+    , ticks(0)
+{
+    put(block, Capture::magic);
+    put(block, Capture::version);
+    put(block, static_cast<std::uint32_t>(fields.size()));
+
+    for (auto& field : fields) {
+        put(block, static_cast<std::uint16_t>(field.size()));
+        put(block, field);
+    }
+
+    put(block, static_cast<std::uint8_t>(bursts));
+
+    output.write(block.data(), static_cast<std::streamsize>(block.size()));
+    output.flush();
+}
+
+auto Gossip::CaptureWriter::append(std::vector<char>& block, int pid,
+    Capture::File file, std::string_view bytes) const -> void
+{
+    put(block, static_cast<std::int32_t>(pid));
+    put(block, static_cast<std::uint8_t>(file));
+    put(block, ticks);
+    put(block, static_cast<std::uint32_t>(bytes.size()));
+    put(block, bytes);
+}
+
+auto Gossip::CaptureWriter::write(std::span<std::vector<char>> blocks,
+    const Tick& tick, std::string_view burst) -> void
+{
+    for (auto& files : blocks) {
+        output.write(files.data(), static_cast<std::streamsize>(files.size()));
+        files.clear();
+    }
+
+    block.clear();
+
+    put(block, std::int32_t { 0 });
+    put(block, static_cast<std::uint8_t>(Capture::File::tick));
+    put(block, ticks);
+    put(block, static_cast<std::uint32_t>(times_size + 2 + burst.size()));
+    put(block, tick.time);
+    put(block, tick.utc_offset);
+    put(block, tick.start);
+    put(block, tick.end);
+    put(block, tick.skipped);
+    put(block, static_cast<std::uint16_t>(burst.size()));
+    put(block, burst);
+
+    output.write(block.data(), static_cast<std::streamsize>(block.size()));
+    output.flush();
+
+    ticks++;
+}
+
+Gossip::CaptureReader::CaptureReader(std::istream& input)
+    : input(input)
+    , ticks(0)
+    , marked(false)
+{
+    std::array<char, Capture::magic.size() + 4 + 4> header;
+    const char* in = header.data();
+
+    if (!read(input, header.data(), header.size())
+        || std::string_view { in, Capture::magic.size() } != Capture::magic)
+        throw std::runtime_error { "Not a gossip capture" };
+
+    in += Capture::magic.size();
+
+    version = get<std::uint32_t>(in);
+
+    auto num_fields = get<std::uint32_t>(in);
+
+    /* Version 1 had no bursts, and is otherwise the same */
+    if (version < 1 || version > Capture::version)
+        throw std::runtime_error { "Unsupported version "
+            + std::to_string(version) };
+
+    for (std::uint32_t i = 0; i < num_fields; i++) {
+        std::array<char, 2> length;
+
+        in = length.data();
+
+        if (!read(input, length.data(), length.size()))
+            throw std::runtime_error { "Truncated header" };
+
+        auto& name = storage.emplace_back(get<std::uint16_t>(in), '\0');
+
+        if (!read(input, name.data(), name.size()))
+            throw std::runtime_error { "Truncated header" };
+    }
+
+    names.assign(storage.begin(), storage.end());
+
+    if (version < 2)
+        return;
+
+    char bursts;
+
+    if (!read(input, &bursts, 1))
+        throw std::runtime_error { "Truncated header" };
+
+    marked = bursts != 0;
+}
+
+auto Gossip::CaptureReader::next(Tick& tick, std::vector<Record>& records)
+    -> bool
+{
+    data.clear();
+    extents.clear();
+    records.clear();
+    bursting = {};
+
+    for (bool first = true;; first = false) {
+        std::array<char, record_size> header;
+        const char* in = header.data();
+
+        if (!read(input, header.data(), header.size()))
+            return false;
+
+        auto pid = get<std::int32_t>(in);
+        auto file = get<std::uint8_t>(in);
+        auto number = get<std::uint32_t>(in);
+        auto length = get<std::uint32_t>(in);
+
+        /* Dropped ticks leave gaps, but never go back */
+        if (first && number > ticks)
+            ticks = number;
+
+        if (pid < 0 || file >= Capture::file_names.size() || number != ticks)
+            throw std::runtime_error { "Corrupt capture" };
+
+        auto at = data.size();
+
+        data.resize(at + length);
+
+        if (!read(input, data.data() + at, length))
+            return false;
+
+        if (static_cast<Capture::File>(file) != Capture::File::tick) {
+            extents.emplace_back(at, length);
+            records.push_back({ pid, static_cast<Capture::File>(file), {} });
+            continue;
+        }
+
+        auto burst_size = length - std::min<std::size_t>(length, times_size);
+
+        if (version < 2 ? length != times_size : burst_size < 2)
+            throw std::runtime_error { "Corrupt capture" };
+
+        in = data.data() + at;
+
+        tick.time = get<std::int64_t>(in);
+        tick.utc_offset = get<std::int32_t>(in);
+        tick.start = get<std::int64_t>(in);
+        tick.end = get<std::int64_t>(in);
+        tick.skipped = get<std::uint32_t>(in);
+        tick.samples = {};
+
+        if (version < 2)
+            break;
+
+        if (get<std::uint16_t>(in) != burst_size - 2)
+            throw std::runtime_error { "Corrupt capture" };
+
+        /* `data' is done growing, this is its last record */
+        bursting = { in, burst_size - 2 };
+
+        break;
+    }
+
+    /* Only now that `data' is done growing */
+    for (std::size_t i = 0; i < records.size(); i++) {
+        auto [at, length] = extents[i];
+
+        records[i].bytes = { data.data() + at, length };
+    }
+
+    ticks++;
+
+    return true;
+}
@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Cgroups - Memory and CPU of every cgroup in a cgroup v2 hierarchy
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Cgroups.hpp>
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iomanip>
+
+Gossip::Cgroups::Cgroups(const std::filesystem::path& root)
+    : root(root)
+{
+}
+
+auto Gossip::Cgroups::extract() -> void
+{
+    std::error_code error;
+    auto options = std::filesystem::directory_options::skip_permission_denied;
+    std::filesystem::recursive_directory_iterator it { root, options, error };
+    std::size_t count = 0;
+
+    if (error)
+        return;
+
+    if (list.empty())
+        list.emplace_back();
+
+    list[count].path = "/";
+    read(root, list[count++]);
+
+    /*
+     * Every directory is a cgroup. One removed while we walk it merely
+     * ends the walk early; it'll be picked up again next tick.
+     */
+    for (; it != std::filesystem::recursive_directory_iterator {};
+         it.increment(error)) {
+        if (error)
+            break;
+
+        if (!it->is_directory(error) || it->is_symlink(error))
+            continue;
+
+        if (count == list.size())
+            list.emplace_back();
+
+        auto& cgroup = list[count++];
+
+        cgroup.path = "/";
+        cgroup.path += it->path().lexically_relative(root).native();
+        read(it->path(), cgroup);
+    }
+
+    list.resize(count);
+
+    /* Directories come in no particular order, parents still go first */
+    std::sort(list.begin(), list.end(),
+        [](auto& a, auto& b) { return a.path < b.path; });
+}
+
+auto Gossip::Cgroups::read(
+    const std::filesystem::path& directory, Cgroup& cgroup) -> void
+{
+    auto& buffer = Parser::scratch();
+    auto text = Parser::read_file(directory / "memory.current", buffer);
+    auto line = Parser::next_line(text);
+    std::uint64_t current = 0;
+
+    cgroup.current = 0;
+    cgroup.memory.fill(0);
+    cgroup.cpu.fill(0);
+
+    if (std::from_chars(line.data(), line.data() + line.size(), current).ec
+        == std::errc {})
+        cgroup.current = current / 1024;
+
+    text = Parser::read_file(directory / "memory.stat", buffer);
+    Parser::parse_flat_keyed(text, memory_keys, cgroup.memory);
+
+    for (std::size_t i = 0; i < memory_sizes; i++)
+        cgroup.memory[i] /= 1024;
+
+    text = Parser::read_file(directory / "cpu.stat", buffer);
+    Parser::parse_flat_keyed(text, cpu_keys, cgroup.cpu);
+
+    text = Parser::read_file(directory / "memory.pressure", buffer);
+
+    if (!Parser::parse_pressure(text, cgroup.pressure))
+        cgroup.pressure = {};
+}
+
+auto Gossip::Cgroups::processes(std::string_view path,
+    std::vector<int>& pids) const -> bool
+{
+    while (!path.empty() && path.front() == '/')
+        path.remove_prefix(1);
+
+    /* Far too many PIDs, possibly, for the scratch buffer */
+    std::ifstream procs { root / path / "cgroup.procs" };
+    int pid;
+
+    pids.clear();
+
+    if (!procs)
+        return false;
+
+    while (procs >> pid)
+        pids.push_back(pid);
+
+    std::sort(pids.begin(), pids.end());
+    pids.erase(std::unique(pids.begin(), pids.end()), pids.end());
+
+    return true;
+}
+
+auto Gossip::Cgroups::write_header(std::ostream& os) -> void
+{
+    os << "# Cgroup,Memory_Current,";
+
+    for (auto column : memory_columns)
+        os << column << ",";
+
+    for (auto column : cpu_columns)
+        os << column << ",";
+
+    os << "Memory_Some_Avg10,Memory_Some_Total,Memory_Full_Avg10,"
+          "Memory_Full_Total,Timestamp"
+       << std::endl;
+}
+
+auto Gossip::Cgroups::write(std::ostream& os, std::string_view timestamp) const
+    -> void
+{
+    /* Averages come with two decimals, like in memory.pressure */
+    os << std::fixed << std::setprecision(2);
+
+    for (auto& cgroup : list) {
+        os << cgroup.path << "," << cgroup.current << ",";
+
+        for (auto value : cgroup.memory)
+            os << value << ",";
+
+        for (auto value : cgroup.cpu)
+            os << value << ",";
+
+        auto& pressure = cgroup.pressure;
+
+        os << pressure.some_avg10 << "," << pressure.some_total << ","
+           << pressure.full_avg10 << "," << pressure.full_total << ","
+           << timestamp << '\n';
+    }
+}
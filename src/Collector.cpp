@@ -6,26 +6,175 @@
  */
 
 #include <Collector.hpp>
-#include <Cpu.hpp>
+#include <Parser.hpp>
+#include <Pool.hpp>
 #include <Process.hpp>
+#include <Scheduler.hpp>
+#include <Stats.hpp>
+#include <System.hpp>
+#include <Uring.hpp>
+#include <Writer.hpp>
+#include <algorithm>
+#include <array>
+#include <fcntl.h>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <iterator>
+#include <malloc.h>
 #include <set>
 #include <sstream>
+#include <stdexcept>
 #include <string>
-#include <thread>
+#include <unistd.h>
 
-Gossip::Collector::Collector(std::string& pids_str,
-    std::chrono::seconds& seconds, int num_samples, std::ostream& output)
-    : seconds(seconds)
-    , num_samples(num_samples)
-    , output(output)
+Gossip::Collector::Collector(
+    const Options& options, Writer& writer, std::ostream& system_output)
+    : Collector(options, writer, system_output, Outputs {})
 {
-    if (pids_str.empty())
-        return;
+}
+
+Gossip::Collector::Collector(const Options& options, Writer& writer,
+    std::ostream& system_output, const Outputs& outputs)
+    : interval(options.interval)
+    , burst_interval(options.burst_interval)
+    , burst_window(options.burst_window)
+    , burst_limit(options.burst_limit)
+    , writer(writer)
+    , system_output(system_output)
+    , stats_output(outputs.stats)
+    , mapping_output(outputs.mapping)
+    , thread_output(outputs.thread)
+    , cgroup_output(outputs.cgroup)
+    , governor_output(outputs.governor)
+    , num_samples(options.num_samples)
+    , stopping(false)
+    , procdir(options.procfs)
+    , scanner(options.procfs)
+    , system(procdir)
+    , cache(options.procfs,
+          options.fields.needs(Fields::Source::smaps_rollup))
+    , pool(options.jobs)
+    , resting(0)
+    , limits(nullptr)
+    , cgroup(options.cgroup)
+    , processes_enabled(options.processes)
+    , system_buffer(Parser::buffer_size)
+    , captured_cpuinfo(false)
+    , burst_end(0)
+    , burst_start(0)
+    , rested(0)
+    , fields(options.fields)
+    , system_enabled(options.system)
+{
+    if (stats_output) {
+        Stats::enable();
+        Stats::write_header(*stats_output);
+    }
+
+    auto page_size = sysconf(_SC_PAGESIZE);
+    auto clock_ticks = sysconf(_SC_CLK_TCK);
+
+    Process::Staleness thresholds {
+        static_cast<std::int64_t>(options.rss_threshold_kb * 1024
+            / static_cast<std::uint64_t>(page_size)),
+        static_cast<std::uint64_t>(
+            options.cpu_threshold.count() * clock_ticks / 1000),
+        options.max_age,
+    };
+
+    if (options.adaptive)
+        staleness = thresholds;
+
+    if (options.budget.cpu > 0 || options.budget.rss_kb) {
+        governor.emplace(options.procfs, options.budget, thresholds);
+
+        if (governor_output)
+            Governor::write_header(*governor_output);
+    }
+
+    if (options.top)
+        top.emplace(options.top, options.by, options.fields);
+
+    /* Those left out of the top come and go, they don't start or exit */
+    if (outputs.event && top)
+        throw std::invalid_argument { "Events need every process, not "
+                                      "just the top" };
+
+    if (outputs.rate || outputs.event)
+        rates.emplace(options.fields.names(), outputs.rate, outputs.event);
+
+    /* Each of those needs something parsed that a capture leaves raw */
+    if (outputs.capture
+        && (top || rates || staleness || mapping_output || thread_output
+            || options.growth_kb))
+        throw std::invalid_argument { "Captures can't be combined with top, "
+                                      "adaptive, rates, events, per-mapping "
+                                      "or per-thread output, nor growth "
+                                      "triggers" };
+
+    /* The only place bursts are marked, decoded captures aside */
+    if (burst_interval.count() && !system_enabled && !outputs.capture)
+        throw std::invalid_argument { "Bursts need the system-wide output" };
+
+    if (burst_interval.count() && burst_limit.count() <= 0)
+        throw std::invalid_argument { "Burst limit must be positive" };
+
+    system_fds.fill(-1);
+
+    if (outputs.capture) {
+        capture.emplace(*outputs.capture, options.fields.names(),
+            burst_interval.count() != 0);
+        captured.resize(static_cast<std::size_t>(pool.size()));
+
+        for (auto file : { Capture::File::stat, Capture::File::loadavg,
+                 Capture::File::meminfo, Capture::File::cpuinfo }) {
+            auto index = static_cast<std::size_t>(file);
+
+            system_files[index] = procdir.path() / Capture::file_names[index];
+        }
+    }
+
+    if (!options.pressure.empty()) {
+        add_trigger(std::make_unique<PressureTrigger>(
+            options.procfs / "pressure" / "memory", options.pressure));
+    }
+
+    if (options.free_kb)
+        add_trigger(std::make_unique<MemoryTrigger>(
+            options.procfs, options.free_kb));
+
+    if (options.growth_kb)
+        add_trigger(std::make_unique<GrowthTrigger>(
+            options.fields.names(), options.growth_kb));
+
+    if (cgroup_output || !cgroup.empty())
+        cgroups.emplace(options.cgroup_root);
+
+    if (!cgroup.empty() && !cgroups->processes(cgroup, members))
+        throw std::invalid_argument { "No such cgroup: " + cgroup };
+
+    if (cgroup_output)
+        Cgroups::write_header(*cgroup_output);
+
+    if (options.io_uring) {
+        for (int job = 0; job < options.jobs; job++) {
+            auto ring = std::make_unique<Uring>(2 * batch_size);
 
-    std::istringstream ss { pids_str };
+            if (!ring->available()) {
+                std::cerr << "io_uring not available, using plain reads"
+                          << std::endl;
+                rings.clear();
+                break;
+            }
+
+            rings.push_back(std::move(ring));
+            batch_buffers.emplace_back(
+                batch_size * (stat_size + smaps_rollup_size));
+        }
+    }
+
+    std::istringstream ss { options.pids };
     std::string pid;
 
     while (std::getline(ss, pid, ',')) {
@@ -36,69 +185,610 @@ Gossip::Collector::Collector(std::string& pids_str,
             continue;
         }
     }
+
+    /* Far too expensive to do for every process */
+    if ((mapping_output || thread_output) && pids.empty())
+        throw std::invalid_argument { "Per-mapping and per-thread output "
+                                      "need --pids" };
+
+    if (mapping_output) {
+        for (auto pid : pids)
+            breakdowns.try_emplace(pid);
+
+        Smaps::write_header(*mapping_output);
+    }
+
+    if (thread_output) {
+        for (auto pid : pids)
+            threads.push_back(std::make_unique<Threads>(options.procfs, pid));
+
+        Threads::write_header(*thread_output);
+    }
+}
+
+Gossip::Collector::~Collector()
+{
+    for (auto fd : system_fds) {
+        if (fd >= 0)
+            ::close(fd);
+    }
+}
+
+auto Gossip::Collector::add_trigger(std::unique_ptr<Trigger> trigger) -> void
+{
+    if (trigger->fd() >= 0) {
+        polls.push_back({ trigger->fd(), trigger->events(), 0 });
+        polled.push_back(trigger.get());
+    }
+
+    triggers.push_back(std::move(trigger));
 }
 
 auto Gossip::Collector::collect_data() -> void
 {
-    for (int i = 0; i < num_samples; ++i) {
-        process_directories();
+    Scheduler scheduler { interval };
 
-        if (i == num_samples - 1) {
+    for (int i = 0; num_samples <= 0 || i < num_samples;) {
+        auto skipped = scheduler.wait(polls);
+
+        if (stopping)
             break;
+
+        for (std::size_t poll = 0; poll < polls.size(); poll++) {
+            auto& fd = polls[poll];
+
+            /* Gone bad for good, e.g. its cgroup removed: stop asking */
+            if (fd.revents & (POLLERR | POLLHUP | POLLNVAL))
+                fd.fd = -1;
+            else if (fd.revents & fd.events)
+                polled[poll]->notify();
         }
 
-        std::this_thread::sleep_for(seconds);
+        if (skipped) {
+            std::cerr << "Sampling took longer than the interval, skipped "
+                      << skipped << " tick(s)" << std::endl;
+        }
+
+        /* Spread out by the governor, these don't count as samples */
+        if (resting) {
+            resting -= std::min(resting, skipped + 1);
+            continue;
+        }
+
+        process_directories(skipped);
+        ++i;
+
+        if (burst_interval.count())
+            scheduler.retime(bursting.empty() ? interval : burst_interval);
+    }
+
+    if (scheduler.overruns()) {
+        std::cerr << scheduler.overruns() << " tick(s) overran the interval, "
+                  << scheduler.skipped() << " skipped in total" << std::endl;
     }
 }
 
-auto Gossip::Collector::process_directories() -> void
+auto Gossip::Collector::scan_processes() -> void
 {
-    const std::filesystem::path procfs { "/proc" };
-    const std::filesystem::directory_entry procdir { procfs };
+    Stats::Timer timer { Stats::Phase::scan };
 
-    std::time_t timestamp = std::chrono::system_clock::to_time_t(
-        std::chrono::system_clock::now());
-    std::tm tm = *std::localtime(&timestamp);
+    /*
+     * Output is in PID order no matter how many jobs collected it, so
+     * runs with different --jobs can be compared byte for byte. The
+     * scanner hands them over sorted already, as do cgroups.
+     */
+    if (!cgroup.empty())
+        cgroups->processes(cgroup, members);
 
-    for (auto const& entry : std::filesystem::directory_iterator { procfs }) {
-        int pid;
+    auto& scanned = cgroup.empty() ? scanner.scan() : members;
 
-        /*
-         * If this is not the directory for a process, `std::stoi()'
-         * will throw `std::invalid_argument'. Let's catch it here and
-         * skip the directory right away.
-         */
-        try {
-            pid = std::stoi(entry.path().filename());
-        } catch (const std::invalid_argument& err) {
-            /* Skipping non-process directories */
+    if (pids.empty()) {
+        processes.assign(scanned.begin(), scanned.end());
+        return;
+    }
+
+    /*
+     * If user requested a specific list of PIDs to be tracked, silently
+     * skip everything else.
+     */
+    processes.clear();
+    std::set_intersection(scanned.begin(), scanned.end(), pids.begin(),
+        pids.end(), std::back_inserter(processes));
+}
+
+auto Gossip::Collector::process_directories(std::uint32_t skipped) -> void
+{
+    auto tick = Tick::now();
+
+    tick.start = Scheduler::now();
+    tick.skipped = skipped;
+
+    if (system_enabled) {
+        Stats::Timer timer { Stats::Phase::system };
+
+        if (capture)
+            capture_system();
+        else
+            system.extract();
+    }
+
+    if (cgroup_output) {
+        Stats::Timer timer { Stats::Phase::cgroups };
+
+        cgroups->extract();
+    }
+
+    /* The governor may carry values over for longer, or at all */
+    limits = staleness ? &*staleness : nullptr;
+
+    if (governor && governor->staleness())
+        limits = governor->staleness();
+
+    cache.begin_tick();
+
+    if (processes_enabled) {
+        scan_processes();
+
+        if (capture)
+            capture_processes();
+        else if (top)
+            collect_top();
+        else
+            collect_processes();
+    } else {
+        samples.reset(0);
+    }
+
+    if (thread_output)
+        collect_threads();
+
+    tick.samples = samples.rows();
+    tick.end = Scheduler::now();
+
+    /*
+     * Every trigger gets to see every tick, even once one fired or while
+     * they rest. The tick that set a burst off is part of it.
+     */
+    auto window = std::chrono::nanoseconds { burst_window }.count();
+    auto limit = std::chrono::nanoseconds { burst_limit }.count();
+
+    for (auto& trigger : triggers) {
+        if (!trigger->fired(tick) || tick.start < rested)
             continue;
+
+        if (bursting.empty())
+            burst_start = tick.start;
+
+        bursting = trigger->name();
+        burst_end = std::min(tick.start + window, burst_start + limit);
+    }
+
+    if (!bursting.empty() && tick.start >= burst_end) {
+        /* Kept going by a trigger that never lets up, e.g. MemAvailable */
+        if (burst_end == burst_start + limit)
+            rested = tick.start + limit;
+
+        bursting = {};
+    }
+
+    {
+        Stats::Timer timer { Stats::Phase::write };
+        auto timestamp = tick.timestamp();
+
+        if (capture)
+            capture->write(captured, tick, bursting);
+        else
+            writer.write(tick);
+
+        if (system_enabled && !capture) {
+            if (system.changed())
+                system.write_header(system_output, burst_interval.count());
+
+            system_output << system << tick.start << "," << tick.end << ","
+                          << tick.skipped << ",";
+
+            if (burst_interval.count())
+                system_output << bursting << ",";
+
+            system_output << timestamp << std::endl;
+        }
+
+        if (mapping_output) {
+            for (auto& sample : tick.samples) {
+                auto it = breakdowns.find(sample.pid);
+
+                if (it != breakdowns.end())
+                    it->second.write(*mapping_output, sample.pid, timestamp);
+            }
+
+            mapping_output->flush();
+        }
+
+        if (rates)
+            rates->write(tick);
+
+        if (cgroup_output) {
+            cgroups->write(*cgroup_output, timestamp);
+            cgroup_output->flush();
         }
 
+        if (thread_output) {
+            for (auto& list : threads)
+                list->write(*thread_output, timestamp);
+
+            thread_output->flush();
+        }
+    }
+
+    /* Whatever wasn't seen this tick has exited */
+    cache.end_tick();
+
+    if (governor) {
+        if (governor->update(Scheduler::now()) && governor_output)
+            governor->write(*governor_output, tick.timestamp());
+
+        resting = governor->stretch() - 1;
+
+        if (governor->lean())
+            trim();
+    }
+
+    if (stats_output) {
+        Stats::record(Stats::Phase::tick, Scheduler::now() - tick.start);
+        Stats::write(*stats_output, tick);
+    }
+}
+
+/* Every process in `processes' into `samples', in the same order */
+auto Gossip::Collector::collect_processes() -> void
+{
+    samples.reset(processes.size());
+
+    if (rings.empty()) {
+        pool.run(processes.size(), [this](int, std::size_t index) {
+            Gossip::Process process { processes[index], cache,
+                samples[index] };
+
+            collect_process(index, process);
+        });
+    } else {
+        auto batches = (processes.size() + batch_size - 1) / batch_size;
+
+        pool.run(batches, [this](int worker, std::size_t batch) {
+            collect_batch(worker, batch);
+        });
+    }
+
+    samples.compact();
+}
+
+/*
+ * stat of every process first, to rank them. Then the rest of them,
+ * heaviest first, a batch at a time until nobody left can make the top.
+ */
+auto Gossip::Collector::collect_top() -> void
+{
+    {
+        Stats::Timer timer { Stats::Phase::rank };
+
+        candidates.resize(processes.size());
+
+        pool.run(processes.size(), [this](int, std::size_t index) {
+            Gossip::Process process { processes[index], cache };
+
+            candidates[index] = {};
+
+            try {
+                if (process.peek())
+                    candidates[index] = top->candidate(process);
+            } catch (const std::runtime_error& err) {
+                /* Exited since the scan */
+            }
+        });
+
+        top->rank(candidates);
+    }
+
+    std::size_t next = 0;
+
+    while (next < candidates.size() && top->contends(candidates[next].bound)) {
+        auto first = next;
+        auto size = std::max(top->missing(),
+            static_cast<std::size_t>(pool.size()));
+
+        processes.clear();
+
+        while (next < candidates.size() && processes.size() < size
+            && top->contends(candidates[next].bound))
+            processes.push_back(candidates[next++].pid);
+
+        collect_processes();
+
+        /* Exited ones were dropped, the rest are still in order */
+        for (auto& sample : samples.rows()) {
+            while (candidates[first].pid != sample.pid)
+                first++;
+
+            top->offer(sample, candidates[first]);
+        }
+    }
+
+    top->take(samples);
+}
+
+auto Gossip::Collector::collect_process(std::size_t index, Process& process)
+    -> void
+{
+    Stats::count(Stats::Counter::visited);
+
+    process.select(fields);
+
+    if (limits)
+        process.carry_over(*limits);
+
+    if (auto it = breakdowns.find(processes[index]); it != breakdowns.end())
+        process.break_down(it->second);
+
+    /* Filled in right in its row, which is dropped unless it all worked */
+    try {
+        Stats::Timer timer { Stats::Phase::process };
+
+        /* Kernel threads are left out */
+        if (!process.extract())
+            samples[index].pid = -1;
+    } catch (const std::runtime_error& err) {
+        /* Skipping empty smaps_rollup */
+        samples[index].pid = -1;
+    }
+}
+
+/*
+ * The system-wide files as they are. cpuinfo only goes in once: knowing
+ * when CPUs came or went, to capture it again, would take parsing stat.
+ */
+auto Gossip::Collector::capture_system() -> void
+{
+    using File = Capture::File;
+
+    auto& block = captured.front();
+
+    for (auto file : { File::stat, File::loadavg, File::meminfo })
+        capture->append(block, 0, file, read_system(file));
+
+    if (captured_cpuinfo)
+        return;
+
+    capture->append(block, 0, File::cpuinfo, read_system(File::cpuinfo));
+    captured_cpuinfo = true;
+
+    auto& fd = system_fds[static_cast<std::size_t>(File::cpuinfo)];
+
+    ::close(fd);
+    fd = -1;
+}
+
+/*
+ * All of it: a single pread() of procfs returns as much as fits, so grow
+ * the buffer until something is left over.
+ */
+auto Gossip::Collector::read_system(Capture::File file) -> std::string_view
+{
+    auto index = static_cast<std::size_t>(file);
+    auto& fd = system_fds[index];
+
+    if (fd < 0)
+        fd = ::open(system_files[index].c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+        return {};
+
+    for (;;) {
+        auto text = Parser::read_fd(fd, system_buffer);
+
+        if (text.size() < system_buffer.size())
+            return text;
+
+        system_buffer.resize(2 * system_buffer.size());
+    }
+}
+
+/*
+ * Every file of every process in `processes' the fields need, read
+ * through the cache and archived without a look at what's in them.
+ * Kernel threads and processes that exited are told apart when decoding.
+ */
+auto Gossip::Collector::capture_processes() -> void
+{
+    using File = ProcessCache::File;
+
+    auto cmdline = fields.needs(Fields::Source::cmdline);
+    auto smaps_rollup = fields.needs(Fields::Source::smaps_rollup);
+
+    pool.run(processes.size(), [&](int worker, std::size_t index) {
+        auto pid = processes[index];
+        auto& block = captured[static_cast<std::size_t>(worker)];
+        auto& entry = cache.acquire(pid);
+        auto text = cache.read(entry, File::stat, Parser::scratch());
+
+        Stats::count(Stats::Counter::visited);
+
+        if (text.empty())
+            return;
+
+        capture->append(block, pid, Capture::File::stat, text);
+
+        if (cmdline) {
+            text = cache.read(entry, File::cmdline, Parser::scratch());
+            capture->append(block, pid, Capture::File::cmdline, text);
+        }
+
+        if (smaps_rollup) {
+            text = cache.read(entry, File::smaps_rollup, Parser::scratch());
+            capture->append(block, pid, Capture::File::smaps_rollup, text);
+        }
+    });
+
+    samples.reset(0);
+}
+
+auto Gossip::Collector::collect_threads() -> void
+{
+    /* One process per worker to list its threads... */
+    pool.run(threads.size(),
+        [this](int, std::size_t index) { threads[index]->scan(); });
+
+    tasks.clear();
+
+    for (auto& list : threads) {
+        for (std::size_t i = 0; i < list->threads().size(); i++)
+            tasks.emplace_back(list.get(), i);
+    }
+
+    /* ...but those of a large process are spread over all of them */
+    pool.run(tasks.size(), [this](int, std::size_t index) {
+        auto [list, thread] = tasks[index];
+
+        list->extract(thread);
+    });
+
+    for (auto& list : threads)
+        list->finish();
+}
+
+/* Lean mode: keep no more memory between ticks than they use */
+auto Gossip::Collector::trim() -> void
+{
+    samples.trim();
+
+    /* The allocator would otherwise hold on to what was freed */
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#elif defined(M_PURGE)
+    mallopt(M_PURGE, 0);
+#endif
+}
+
+auto Gossip::Collector::collect_batch(int worker, std::size_t batch) -> void
+{
+    using File = ProcessCache::File;
+
+    constexpr std::size_t sizes[] = { stat_size, smaps_rollup_size };
+    constexpr std::size_t offsets[] = { 0, stat_size };
+
+    auto first = batch * batch_size;
+    auto last = std::min(first + batch_size, processes.size());
+
+    if (!rings[worker]) {
+        for (auto index = first; index < last; index++) {
+            Gossip::Process process { processes[index], cache,
+                samples[index] };
+
+            collect_process(index, process);
+        }
+
+        return;
+    }
+
+    auto& ring = *rings[worker];
+    auto* memory = batch_buffers[worker].data();
+
+    std::array<int, batch_size> outstanding {};
+    std::array<std::array<std::string_view, 2>, batch_size> texts {};
+
+    auto buffer = [&](std::size_t slot, std::size_t file) {
+        return memory + slot * (stat_size + smaps_rollup_size) + offsets[file];
+    };
+
+    auto finish = [&](std::size_t slot) {
+        auto& text = texts[slot];
+        Gossip::Process process { processes[first + slot], cache,
+            samples[first + slot] };
+
         /*
-         * If user requested a specific list of PIDs to be tracked and
-         * that list does not contain the current PID, just silently
-         * skip it.
+         * A failed stat read means the cached descriptors went stale;
+         * leave it all to extract(), which reopens them and retries.
          */
-        if (!pids.empty() && !pids.contains(pid)) {
-            continue;
+        if (!text[0].empty()) {
+            process.prefetch(File::stat, text[0]);
+            process.prefetch(File::smaps_rollup, text[1]);
         }
 
-        try {
-            Gossip::Process process { entry };
-            Gossip::Cpu cpu { procdir };
+        collect_process(first + slot, process);
+    };
+
+    for (auto index = first; index < last; index++) {
+        auto slot = index - first;
+        auto& entry = cache.acquire(processes[index]);
+
+        for (std::size_t file = 0; file < entry.fds.size(); file++) {
+            if (entry.fds[file] < 0)
+                continue;
+
+            /* Whether smaps_rollup is needed at all depends on stat */
+            if (limits
+                && file == static_cast<std::size_t>(File::smaps_rollup))
+                continue;
+
+            if (ring.read(entry.fds[file], buffer(slot, file), sizes[file], 0,
+                    slot * 2 + file))
+                outstanding[slot]++;
+        }
+    }
+
+    int remaining = 0;
+
+    for (std::size_t slot = 0; slot < last - first; slot++) {
+        /* Nothing cached for it, take the plain syscall path */
+        if (outstanding[slot] == 0)
+            finish(slot);
 
-            cpu.extract();
-            process.extract();
+        remaining += outstanding[slot];
+    }
+
+    /* Parse each process as soon as all of its reads are back */
+    while (remaining > 0) {
+        bool submitted;
 
-            output << cpu;
-            output << process;
-            output << std::put_time(&tm, "%F %T %z") << std::endl;
+        {
+            Stats::Timer timer { Stats::Phase::read };
 
-        } catch (const std::invalid_argument& err) {
-            /* Skipping non-directories */
-        } catch (const std::runtime_error& err) {
-            /* Skipping empty smaps_rollup */
+            submitted = ring.submit(1);
         }
+
+        if (!submitted)
+            break;
+
+        ring.reap([&](std::uint64_t user_data, int result) {
+            auto slot = user_data / 2;
+            auto file = user_data % 2;
+
+            /* A full buffer may be truncated, read it again the slow way */
+            if (result > 0 && static_cast<std::size_t>(result) < sizes[file])
+                texts[slot][file] = { buffer(slot, file),
+                    static_cast<std::size_t>(result) };
+
+            remaining--;
+
+            if (--outstanding[slot] == 0)
+                finish(slot);
+        });
+    }
+
+    if (remaining == 0)
+        return;
+
+    /*
+     * io_uring_enter() failing at this point is not something we expect.
+     * Requests may still be in flight and writing to this worker's buffers,
+     * so stop using both for good and finish off with plain reads.
+     */
+    rings[worker].reset();
+
+    for (std::size_t slot = 0; slot < last - first; slot++) {
+        if (outstanding[slot] == 0)
+            continue;
+
+        texts[slot] = {};
+        finish(slot);
     }
 }
@@ -6,40 +6,93 @@
  */
 
 #include <Cpu.hpp>
+#include <Parser.hpp>
 
+#include <algorithm>
+#include <charconv>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <numeric>
-#include <regex>
-#include <sstream>
 #include <string>
 
+namespace {
+/* Enough for the `cpuN' lines of a few hundred CPUs, grown past that */
+constexpr std::size_t stat_buffer_size = 65536;
+
+auto layout_of(std::span<const Gossip::Cpu::Online> cpus) -> std::uint64_t
+{
+    std::uint64_t hash = 14695981039346656037ull;
+
+    for (auto& cpu : cpus)
+        hash = (hash ^ static_cast<std::uint64_t>(cpu.id)) * 1099511628211ull;
+
+    return hash ^ cpus.size();
+}
+}
+
 auto Gossip::Cpu::extract() -> void
 {
+    auto before = layout_of(cpus);
+
     get_stat();
-    get_num_cpus();
+
+    /*
+     * Counting `processor' lines means walking all of cpuinfo, which is
+     * large on big machines. Only do it when CPUs came or went.
+     */
+    hotplug = num_cpus == 0 || layout_of(cpus) != before;
+
+    if (hotplug)
+        get_num_cpus();
 }
 
 auto Gossip::Cpu::get_stat() -> void
 {
-    std::ifstream stat { directory.path() / "stat" };
-    std::string first_line;
-    std::string line;
+    if (buffer.empty())
+        buffer.resize(stat_buffer_size);
 
-    std::getline(stat, first_line);
+    auto text = Parser::read_file(stat_path, buffer);
 
-    std::istringstream ss { first_line };
+    /*
+     * A cut off line would look like CPUs went offline and have cpuinfo
+     * read again, so read the whole of it.
+     */
+    while (text.size() == buffer.size()) {
+        buffer.resize(2 * buffer.size());
+        text = Parser::read_file(stat_path, buffer);
+    }
+    auto first_line = Parser::next_line(text);
 
-    /* First column contains the string 'cpu', skip it */
-    std::getline(ss, line, ' ');
-    std::getline(ss, line, ' ');
+    num_values = Parser::parse_cpu_line(first_line, values);
+    total_time = std::accumulate(
+        values.begin(), values.begin() + num_values, std::uint64_t(0));
 
-    while (std::getline(ss, line, ' ')) {
-        values.push_back(std::stoi(line));
-    }
+    cpus.clear();
+
+    /* Per-CPU lines follow the aggregate one, for online CPUs only */
+    while (!text.empty()) {
+        auto line = Parser::next_line(text);
+
+        if (!line.starts_with("cpu"))
+            break;
+
+        std::array<std::uint64_t, max_values> times;
+        Online cpu {};
+
+        std::from_chars(line.data() + 3, line.data() + line.size(), cpu.id);
 
-    total_time = std::accumulate(values.begin(), values.end(), 0);
+        auto count = Parser::parse_cpu_line(line, times);
+
+        cpu.total_time = std::accumulate(
+            times.begin(), times.begin() + count, std::uint64_t(0));
+
+        /* idle and iowait */
+        for (std::size_t i = 3; i < std::min<std::size_t>(count, 5); i++)
+            cpu.idle_time += times[i];
+
+        cpus.push_back(cpu);
+    }
 }
 
 auto Gossip::Cpu::get_num_cpus() -> void
@@ -47,6 +100,8 @@ auto Gossip::Cpu::get_num_cpus() -> void
     std::ifstream cpuinfo { directory.path() / "cpuinfo" };
     std::string line;
 
+    num_cpus = 0;
+
     while (std::getline(cpuinfo, line)) {
         if (line.starts_with("processor"))
             num_cpus += 1;
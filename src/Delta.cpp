@@ -0,0 +1,430 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Delta - Output format storing only what changed between ticks
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Delta.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+auto put_varint(std::vector<char>& out, std::uint64_t value) -> void
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+
+    out.push_back(static_cast<char>(value));
+}
+
+auto put_svarint(std::vector<char>& out, std::int64_t value) -> void
+{
+    auto bits = static_cast<std::uint64_t>(value);
+
+    put_varint(out, (bits << 1) ^ (value < 0 ? ~std::uint64_t { 0 } : 0));
+}
+
+auto put_bytes(std::vector<char>& out, std::string_view text) -> void
+{
+    put_varint(out, text.size());
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+/* Reads from a record, throwing instead of running off its end */
+struct Cursor {
+    const char* at;
+    const char* end;
+
+    auto varint() -> std::uint64_t
+    {
+        std::uint64_t value = 0;
+
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            if (at == end)
+                throw std::runtime_error { "Truncated tick" };
+
+            auto byte = static_cast<unsigned char>(*at++);
+
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+
+            if (!(byte & 0x80))
+                return value;
+        }
+
+        throw std::runtime_error { "Corrupt varint" };
+    }
+
+    auto svarint() -> std::int64_t
+    {
+        auto bits = varint();
+
+        return static_cast<std::int64_t>(bits >> 1)
+            ^ -static_cast<std::int64_t>(bits & 1);
+    }
+
+    auto bytes() -> std::string_view
+    {
+        auto length = varint();
+
+        if (length > static_cast<std::uint64_t>(end - at))
+            throw std::runtime_error { "Truncated tick" };
+
+        std::string_view text { at, length };
+
+        at += length;
+
+        return text;
+    }
+};
+
+/* Same as Cursor::varint(), straight from the file */
+auto get_varint(std::istream& input) -> std::uint64_t
+{
+    std::uint64_t value = 0;
+
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        int byte = input.get();
+
+        if (byte == std::istream::traits_type::eof())
+            throw std::runtime_error { "Truncated file" };
+
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+
+        if (!(byte & 0x80))
+            return value;
+    }
+
+    throw std::runtime_error { "Corrupt varint" };
+}
+
+/* Bit 0 of a row's mask marks a delta, value i changed is bit 1 + i */
+constexpr unsigned total_time_bit = 1 + Gossip::Sample::max_values;
+constexpr unsigned freshness_bit = 2 + Gossip::Sample::max_values;
+
+auto to_freshness(std::uint64_t value) -> Gossip::Sample::Freshness
+{
+    using Freshness = Gossip::Sample::Freshness;
+
+    if (value > static_cast<std::uint64_t>(Freshness::carried))
+        throw std::runtime_error { "Corrupt tick" };
+
+    return static_cast<Freshness>(value);
+}
+
+auto find(std::vector<Gossip::Sample>& samples, int pid) -> Gossip::Sample*
+{
+    auto it = std::lower_bound(samples.begin(), samples.end(), pid,
+        [](auto& sample, int pid) { return sample.pid < pid; });
+
+    if (it == samples.end() || it->pid != pid)
+        return nullptr;
+
+    return &*it;
+}
+
+auto remember(std::vector<Gossip::Sample>& previous,
+    std::span<const Gossip::Sample> samples) -> void
+{
+    previous.assign(samples.begin(), samples.end());
+
+    auto by_pid = [](auto& a, auto& b) { return a.pid < b.pid; };
+
+    if (!std::is_sorted(previous.begin(), previous.end(), by_pid))
+        std::sort(previous.begin(), previous.end(), by_pid);
+}
+};
+
+Gossip::DeltaWriter::DeltaWriter(std::ostream& output,
+    std::span<const std::string_view> fields, unsigned keyframe_interval)
+    : output(output)
+    , keyframe_interval(keyframe_interval)
+    , ticks(0)
+    , previous_time(0)
+    , previous_start(0)
+{
+    if (keyframe_interval == 0)
+        throw std::invalid_argument { "Keyframe interval must be positive" };
+
+    record.insert(record.end(), Delta::magic.begin(), Delta::magic.end());
+    put_varint(record, Delta::version);
+    put_varint(record, fields.size());
+
+    for (auto& field : fields)
+        put_bytes(record, field);
+
+    output.write(record.data(), record.size());
+    output.flush();
+}
+
+auto Gossip::DeltaWriter::write(const Tick& tick) -> void
+{
+    bool keyframe = ticks++ % keyframe_interval == 0;
+    int last_pid = 0;
+
+    record.clear();
+
+    put_svarint(record, keyframe ? tick.time : tick.time - previous_time);
+    put_svarint(record, tick.utc_offset);
+    put_svarint(record, keyframe ? tick.start : tick.start - previous_start);
+    put_varint(record, static_cast<std::uint64_t>(tick.end - tick.start));
+    put_varint(record, tick.skipped);
+    put_varint(record, tick.samples.size());
+
+    for (auto& sample : tick.samples) {
+        put_svarint(record, sample.pid - last_pid);
+        last_pid = sample.pid;
+
+        auto* before = keyframe ? nullptr : find(previous, sample.pid);
+
+        /* A new process, or a PID that was reused since */
+        if (!before || before->num_values != sample.num_values
+            || before->comm != sample.comm) {
+            write_row(sample);
+            continue;
+        }
+
+        std::uint64_t mask = 1;
+
+        for (std::size_t i = 0; i < sample.num_values; i++) {
+            if (sample.values[i] != before->values[i])
+                mask |= std::uint64_t { 1 } << (1 + i);
+        }
+
+        if (sample.total_time != before->total_time)
+            mask |= std::uint64_t { 1 } << total_time_bit;
+
+        if (sample.freshness != before->freshness)
+            mask |= std::uint64_t { 1 } << freshness_bit;
+
+        put_varint(record, mask);
+
+        /* Unsigned wrap-around gives back the right value when decoding */
+        for (std::size_t i = 0; i < sample.num_values; i++) {
+            if (mask & std::uint64_t { 1 } << (1 + i))
+                put_svarint(record,
+                    static_cast<std::int64_t>(
+                        sample.values[i] - before->values[i]));
+        }
+
+        if (mask & std::uint64_t { 1 } << total_time_bit)
+            put_svarint(record,
+                static_cast<std::int64_t>(
+                    sample.total_time - before->total_time));
+
+        if (mask & std::uint64_t { 1 } << freshness_bit)
+            put_varint(record, static_cast<std::uint64_t>(sample.freshness));
+    }
+
+    prefix.clear();
+    prefix.push_back(keyframe ? Delta::keyframe : Delta::delta);
+    put_varint(prefix, record.size());
+
+    output.write(prefix.data(), prefix.size());
+    output.write(record.data(), record.size());
+    output.flush();
+
+    remember(previous, tick.samples);
+    previous_time = tick.time;
+    previous_start = tick.start;
+}
+
+auto Gossip::DeltaWriter::write_row(const Sample& sample) -> void
+{
+    put_varint(record, 0);
+    put_bytes(record, sample.comm);
+    put_varint(record, sample.num_values);
+
+    for (std::size_t i = 0; i < sample.num_values; i++)
+        put_varint(record, sample.values[i]);
+
+    put_varint(record, sample.total_time);
+    put_varint(record, static_cast<std::uint64_t>(sample.freshness));
+}
+
+Gossip::DeltaReader::DeltaReader(std::istream& input)
+    : input(input)
+    , version(0)
+    , pending(false)
+    , pending_kind(0)
+    , previous_time(0)
+    , previous_start(0)
+{
+    char magic[Delta::magic.size()];
+
+    if (!input.read(magic, sizeof(magic))
+        || std::string_view { magic, sizeof(magic) } != Delta::magic)
+        throw std::runtime_error { "Not a gossip delta file" };
+
+    version = get_varint(input);
+
+    if (version < 1 || version > Delta::version)
+        throw std::runtime_error { "Unsupported version "
+            + std::to_string(version) };
+
+    auto num_fields = get_varint(input);
+
+    for (std::uint64_t i = 0; i < num_fields; i++) {
+        std::string name(get_varint(input), '\0');
+
+        auto size = static_cast<std::streamsize>(name.size());
+
+        if (!input.read(name.data(), size))
+            throw std::runtime_error { "Truncated file" };
+
+        storage.push_back(std::move(name));
+    }
+
+    names.assign(storage.begin(), storage.end());
+}
+
+auto Gossip::DeltaReader::next(Tick& tick) -> bool
+{
+    char kind = pending_kind;
+
+    if (!pending && !read_record(kind))
+        return false;
+
+    pending = false;
+
+    Cursor in { record.data(), record.data() + record.size() };
+    bool keyframe = kind == Delta::keyframe;
+
+    auto time = in.svarint();
+
+    tick.time = keyframe ? time : previous_time + time;
+    tick.utc_offset = static_cast<std::int32_t>(in.svarint());
+    tick.start = tick.end = tick.skipped = 0;
+
+    if (version >= 2) {
+        auto start = in.svarint();
+
+        tick.start = keyframe ? start : previous_start + start;
+        tick.end = tick.start + static_cast<std::int64_t>(in.varint());
+        tick.skipped = static_cast<std::uint32_t>(in.varint());
+    }
+
+    auto rows = in.varint();
+
+    /* Every row takes at least two bytes */
+    if (rows > record.size() / 2)
+        throw std::runtime_error { "Corrupt tick" };
+
+    samples.resize(rows);
+
+    int pid = 0;
+
+    for (auto& sample : samples) {
+        pid += static_cast<int>(in.svarint());
+
+        auto mask = in.varint();
+
+        if (!(mask & 1)) {
+            sample.pid = pid;
+            sample.comm = in.bytes();
+            sample.num_values = in.varint();
+
+            if (sample.num_values > Sample::max_values)
+                throw std::runtime_error { "Corrupt tick" };
+
+            for (std::size_t i = 0; i < sample.num_values; i++)
+                sample.values[i] = in.varint();
+
+            sample.total_time = in.varint();
+            sample.freshness = version >= 3 ? to_freshness(in.varint())
+                                            : Sample::Freshness::always;
+
+            continue;
+        }
+
+        auto* before = keyframe ? nullptr : find(previous, pid);
+
+        if (!before)
+            throw std::runtime_error { "Delta for unknown PID "
+                + std::to_string(pid) };
+
+        sample = *before;
+
+        for (std::size_t i = 0; i < sample.num_values; i++) {
+            if (mask & std::uint64_t { 1 } << (1 + i))
+                sample.values[i] += static_cast<std::uint64_t>(in.svarint());
+        }
+
+        if (mask & std::uint64_t { 1 } << total_time_bit)
+            sample.total_time += static_cast<std::uint64_t>(in.svarint());
+
+        if (mask & std::uint64_t { 1 } << freshness_bit)
+            sample.freshness = to_freshness(in.varint());
+    }
+
+    if (in.at != in.end)
+        throw std::runtime_error { "Corrupt tick" };
+
+    remember(previous, samples);
+    previous_time = tick.time;
+    previous_start = tick.start;
+
+    tick.samples = samples;
+
+    return true;
+}
+
+auto Gossip::DeltaReader::seek(std::int64_t time) -> bool
+{
+    char kind;
+
+    pending = false;
+
+    while (read_record(kind, true)) {
+        if (kind != Delta::keyframe)
+            continue;
+
+        Cursor in { record.data(), record.data() + record.size() };
+
+        if (in.svarint() >= time) {
+            pending = true;
+            pending_kind = kind;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Read the next record into `record'. When `skip_deltas' is set, deltas
+ * are skipped over rather than read. Returns false at the end of the
+ * file.
+ */
+auto Gossip::DeltaReader::read_record(char& kind, bool skip_deltas) -> bool
+{
+    int byte = input.get();
+
+    if (byte == std::istream::traits_type::eof())
+        return false;
+
+    kind = static_cast<char>(byte);
+
+    if (kind != Delta::keyframe && kind != Delta::delta)
+        throw std::runtime_error { "Corrupt tick" };
+
+    auto length = get_varint(input);
+    auto size = static_cast<std::streamsize>(length);
+
+    if (skip_deltas && kind == Delta::delta) {
+        if (input.ignore(size).gcount() != size)
+            throw std::runtime_error { "Truncated tick" };
+
+        return true;
+    }
+
+    record.resize(length);
+
+    if (!input.read(record.data(), size))
+        throw std::runtime_error { "Truncated tick" };
+
+    return true;
+}
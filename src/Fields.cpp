@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Fields - Output columns and the files they come from
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Fields.hpp>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+auto Gossip::Fields::Selection::all(bool adaptive) -> Selection
+{
+    Selection selection;
+
+    for (auto& field : table) {
+        if (field.name != "Fresh" || adaptive)
+            selection.add(field);
+    }
+
+    /*
+     * Every key is looked up by name rather than taken by position, so
+     * values line up with the header whatever the kernel adds, such as
+     * Pss_Dirty in 6.0.
+     */
+    return selection;
+}
+
+auto Gossip::Fields::Selection::parse(const std::string& list) -> Selection
+{
+    Selection selection;
+    std::istringstream ss { list };
+    std::string name;
+
+    while (std::getline(ss, name, ',')) {
+        auto* field = find(name);
+
+        if (!field)
+            throw std::invalid_argument { "Unknown field `" + name + "'" };
+
+        if (std::find(selection.columns.begin(), selection.columns.end(),
+                field->name)
+            != selection.columns.end())
+            throw std::invalid_argument { "Field `" + name
+                + "' given twice" };
+
+        selection.add(*field);
+    }
+
+    if (selection.columns.empty())
+        throw std::invalid_argument { "No fields selected" };
+
+    return selection;
+}
+
+auto Gossip::Fields::Selection::add(const Field& field) -> void
+{
+    columns.push_back(field.name);
+
+    if (is_value(field.name))
+        values.push_back(field.name);
+
+    sources[static_cast<std::size_t>(Source::stat)] = true;
+    sources[static_cast<std::size_t>(field.source)] = true;
+}
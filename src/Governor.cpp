@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Governor - Keeps gossip's own overhead within a budget
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Governor.hpp>
+#include <Parser.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <sched.h>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+Gossip::Governor::Governor(const std::filesystem::path& procfs,
+    const Budget& budget, const Process::Staleness& staleness)
+    : stat_path(procfs / "self" / "stat")
+    , budget(budget)
+    , loose { 4 * staleness.rss, 4 * staleness.cpu,
+        4 * std::max(staleness.max_age, 1u) }
+    , clock_ticks(static_cast<double>(sysconf(_SC_CLK_TCK)))
+    , page_kb(static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE)) / 1024)
+    , time(-1)
+    , total_time(0)
+    , usage(-1)
+    , rss_kb(0)
+    , current(0)
+    , since_change(0)
+    , trimming(false)
+    , reason("")
+{
+}
+
+auto Gossip::Governor::confine(bool idle, int cpu) -> void
+{
+    if (idle) {
+        sched_param param {};
+
+        if (sched_setscheduler(0, SCHED_IDLE, &param))
+            throw std::runtime_error { std::string { "Can't run at idle "
+                                                     "priority: " }
+                + std::strerror(errno) };
+    }
+
+    if (cpu < 0)
+        return;
+
+    if (cpu >= CPU_SETSIZE)
+        throw std::invalid_argument { "No such CPU: "
+            + std::to_string(cpu) };
+
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    if (sched_setaffinity(0, sizeof(set), &set))
+        throw std::runtime_error { "Can't run on CPU "
+            + std::to_string(cpu) + ": " + std::strerror(errno) };
+}
+
+auto Gossip::Governor::update(std::int64_t now) -> bool
+{
+    Parser::Stat stat;
+
+    if (!Parser::parse_stat(
+            Parser::read_file(stat_path, Parser::scratch()), stat))
+        return false;
+
+    auto total = stat.utime + stat.stime;
+
+    rss_kb = static_cast<std::uint64_t>(std::max<std::int64_t>(stat.rss, 0))
+        * page_kb;
+
+    if (time < 0 || now <= time) {
+        time = now;
+        total_time = total;
+        return false;
+    }
+
+    /*
+     * Over wall clock time, sleeping included: backing off by spreading
+     * ticks apart brings it down, as it should. CPU time only comes in
+     * clock ticks, far coarser than what a tick may take, hence the
+     * average.
+     */
+    auto seconds = static_cast<double>(now - time) / 1e9;
+    auto used = static_cast<double>(total - std::min(total_time, total))
+        / clock_ticks;
+    auto latest = 100 * used / seconds;
+
+    usage = usage < 0 ? latest : usage + weight * (latest - usage);
+    time = now;
+    total_time = total;
+
+    if (++since_change < settle)
+        return false;
+
+    bool over_cpu = budget.cpu > 0 && usage > budget.cpu;
+    bool over_rss = budget.rss_kb && rss_kb > budget.rss_kb;
+
+    /*
+     * Measured before lean mode trims, this is what a tick needs: only
+     * once that is well below the budget would leaving it not go over.
+     */
+    bool low_rss = rss_kb < budget.rss_kb * 3 / 4;
+
+    /*
+     * Each level about halves the usage of the one before, so coming
+     * back down from below a quarter of the budget stays below half.
+     */
+    if (over_rss && !trimming) {
+        trimming = true;
+        reason = "rss";
+    } else if (over_cpu && current < max_level) {
+        current++;
+        reason = "cpu";
+    } else if (trimming && low_rss) {
+        trimming = false;
+        reason = "relax";
+    } else if (!over_cpu && current > 0 && usage < budget.cpu / 4) {
+        current--;
+        reason = "relax";
+    } else {
+        return false;
+    }
+
+    since_change = 0;
+
+    return true;
+}
+
+auto Gossip::Governor::write_header(std::ostream& os) -> void
+{
+    os << "# Level,Reason,Cpu_Percent,Rss,Stretch,Lean,Timestamp"
+       << std::endl;
+}
+
+auto Gossip::Governor::write(std::ostream& os, std::string_view timestamp) const
+    -> void
+{
+    /* Often std::cerr, which others write to as well */
+    auto flags = os.flags();
+    auto precision = os.precision();
+
+    os << std::fixed << std::setprecision(2) << current << "," << reason
+       << "," << usage << "," << rss_kb << "," << stretch() << ","
+       << trimming << "," << timestamp << std::endl;
+
+    os.flags(flags);
+    os.precision(precision);
+}
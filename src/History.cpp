@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * History - The last few ticks, kept in memory
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <History.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+Gossip::History::History(std::size_t capacity)
+    : slots(capacity)
+    , count(0)
+{
+    if (capacity == 0)
+        throw std::invalid_argument { "History must keep at least one tick" };
+}
+
+auto Gossip::History::write(const Tick& tick) -> void
+{
+    std::lock_guard<std::mutex> guard { lock };
+    auto& slot = slots[count % slots.size()];
+    auto rows = tick.samples.size();
+
+    slot.number = count++;
+    slot.time = tick.time;
+    slot.utc_offset = tick.utc_offset;
+    slot.start = tick.start;
+    slot.end = tick.end;
+    slot.skipped = tick.skipped;
+    slot.columns = 0;
+
+    slot.pids.clear();
+    slot.total_times.clear();
+    slot.num_values.clear();
+    slot.freshness.clear();
+    slot.names.clear();
+    slot.name_ends.clear();
+
+    for (auto& sample : tick.samples) {
+        slot.pids.push_back(sample.pid);
+        slot.total_times.push_back(sample.total_time);
+        slot.num_values.push_back(static_cast<std::uint8_t>(sample.num_values));
+        slot.freshness.push_back(sample.freshness);
+        slot.names += sample.comm;
+        slot.name_ends.push_back(static_cast<std::uint32_t>(slot.names.size()));
+        slot.columns = std::max(slot.columns, sample.num_values);
+    }
+
+    /* Rows with fewer values leave the rest of their column as zero */
+    slot.values.assign(slot.columns * rows, 0);
+
+    for (std::size_t row = 0; row < rows; row++) {
+        auto& sample = tick.samples[row];
+
+        for (std::size_t column = 0; column < sample.num_values; column++)
+            slot.values[column * rows + row] = sample.values[column];
+    }
+}
+
+auto Gossip::History::written() const -> std::uint64_t
+{
+    std::lock_guard<std::mutex> guard { lock };
+
+    return count;
+}
+
+auto Gossip::History::replay(std::uint64_t number, Writer& writer) -> bool
+{
+    std::lock_guard<std::mutex> guard { lock };
+    auto* kept = slot(number);
+
+    if (!kept)
+        return false;
+
+    samples.resize(kept->pids.size());
+
+    for (std::size_t row = 0; row < samples.size(); row++)
+        unpack(*kept, row, samples[row]);
+
+    auto tick = header(*kept);
+
+    tick.samples = samples;
+    writer.write(tick);
+
+    return true;
+}
+
+auto Gossip::History::replay(int pid, std::int64_t seconds, Writer& writer)
+    -> std::size_t
+{
+    std::lock_guard<std::mutex> guard { lock };
+    auto oldest = count > slots.size() ? count - slots.size() : 0;
+    std::size_t rows = 0;
+
+    if (count == 0)
+        return 0;
+
+    auto since = seconds > 0 ? slot(count - 1)->time - seconds : INT64_MIN;
+
+    samples.resize(1);
+
+    for (auto number = oldest; number < count; number++) {
+        auto* kept = slot(number);
+
+        if (kept->time < since)
+            continue;
+
+        /* Rows are in PID order */
+        auto it = std::lower_bound(kept->pids.begin(), kept->pids.end(), pid);
+
+        if (it == kept->pids.end() || *it != pid)
+            continue;
+
+        unpack(*kept, static_cast<std::size_t>(it - kept->pids.begin()),
+            samples[0]);
+
+        auto tick = header(*kept);
+
+        tick.samples = samples;
+        writer.write(tick);
+        rows++;
+    }
+
+    return rows;
+}
+
+auto Gossip::History::list(std::ostream& os) const -> void
+{
+    std::lock_guard<std::mutex> guard { lock };
+    auto oldest = count > slots.size() ? count - slots.size() : 0;
+
+    os << "# Tick,Processes,Timestamp\n";
+
+    for (auto number = oldest; number < count; number++) {
+        auto* kept = slot(number);
+
+        os << number << "," << kept->pids.size() << ","
+           << header(*kept).timestamp() << '\n';
+    }
+}
+
+/* Where tick `number' is kept, if it still is */
+auto Gossip::History::slot(std::uint64_t number) const -> const Slot*
+{
+    if (number >= count || count - number > slots.size())
+        return nullptr;
+
+    return &slots[number % slots.size()];
+}
+
+auto Gossip::History::unpack(const Slot& slot, std::size_t row,
+    Sample& sample) const -> void
+{
+    auto rows = slot.pids.size();
+    auto first = row ? slot.name_ends[row - 1] : 0;
+
+    sample.pid = slot.pids[row];
+    sample.comm.assign(slot.names, first, slot.name_ends[row] - first);
+    sample.num_values = slot.num_values[row];
+    sample.total_time = slot.total_times[row];
+    sample.freshness = slot.freshness[row];
+
+    for (std::size_t column = 0; column < sample.num_values; column++)
+        sample.values[column] = slot.values[column * rows + row];
+}
+
+auto Gossip::History::header(const Slot& slot) const -> Tick
+{
+    Tick tick;
+
+    tick.time = slot.time;
+    tick.utc_offset = slot.utc_offset;
+    tick.start = slot.start;
+    tick.end = slot.end;
+    tick.skipped = slot.skipped;
+
+    return tick;
+}
@@ -0,0 +1,426 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Parser - Allocation-free parsers for /proc files
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Parser.hpp>
+#include <Stats.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+auto is_digit(char c) -> bool { return c >= '0' && c <= '9'; }
+
+/*
+ * Find the next run of digits in `text', parse it into `value' and advance
+ * `text' past it. Returns false when there are no more digits.
+ */
+auto next_number(std::string_view& text, std::uint64_t& value) -> bool
+{
+    const char* first = text.data();
+    const char* last = text.data() + text.size();
+
+    while (first != last && !is_digit(*first))
+        first++;
+
+    if (first == last) {
+        text = {};
+        return false;
+    }
+
+    const char* end = first;
+
+    while (end != last && is_digit(*end))
+        end++;
+
+    /* Out of range values saturate rather than being dropped */
+    if (std::from_chars(first, end, value).ec != std::errc {})
+        value = UINT64_MAX;
+
+    text = { end, static_cast<std::size_t>(last - end) };
+
+    return true;
+}
+
+/*
+ * Parse the next space separated field of `text' as a signed number and
+ * advance `text' past it. Malformed fields read as zero.
+ */
+auto next_field(std::string_view& text) -> std::int64_t
+{
+    const char* first = text.data();
+    const char* last = text.data() + text.size();
+    std::int64_t value = 0;
+
+    while (first != last && *first == ' ')
+        first++;
+
+    const char* end = std::from_chars(first, last, value).ptr;
+
+    while (end != last && *end != ' ' && *end != '\n')
+        end++;
+
+    text = { end, static_cast<std::size_t>(last - end) };
+
+    return value;
+}
+}
+
+auto Gossip::Parser::scratch() -> Buffer&
+{
+    thread_local Buffer buffer;
+
+    return buffer;
+}
+
+auto Gossip::Parser::read_file(const std::filesystem::path& path,
+    std::span<char> buffer) -> std::string_view
+{
+    int fd;
+
+    {
+        Stats::Timer timer { Stats::Phase::open };
+
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+
+    if (fd < 0)
+        return {};
+
+    /*
+     * procfs generates the whole file on the first read() and hands back
+     * as much of it as fits, so one call is all we need.
+     */
+    ssize_t len;
+
+    {
+        Stats::Timer timer { Stats::Phase::read };
+
+        len = ::read(fd, buffer.data(), buffer.size());
+    }
+
+    ::close(fd);
+
+    if (len <= 0)
+        return {};
+
+    return { buffer.data(), static_cast<std::size_t>(len) };
+}
+
+auto Gossip::Parser::read_fd(int fd, std::span<char> buffer)
+    -> std::string_view
+{
+    Stats::Timer timer { Stats::Phase::read };
+    ssize_t len = ::pread(fd, buffer.data(), buffer.size(), 0);
+
+    if (len <= 0)
+        return {};
+
+    return { buffer.data(), static_cast<std::size_t>(len) };
+}
+
+auto Gossip::Parser::next_line(std::string_view& text) -> std::string_view
+{
+    auto end = text.find('\n');
+    auto line = text.substr(0, end);
+
+    text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+
+    return line;
+}
+
+auto Gossip::Parser::parse_smaps_rollup(
+    std::string_view text, std::span<std::uint64_t> values) -> std::size_t
+{
+    std::size_t count = 0;
+    std::uint64_t value;
+
+    /*
+     * First line contains address space details which we're not
+     * interested in. It's safe to just drop it
+     */
+    next_line(text);
+
+    while (count < values.size() && next_number(text, value))
+        values[count++] = value;
+
+    return count;
+}
+
+auto Gossip::Parser::parse_smaps_rollup(std::string_view text,
+    std::span<const std::string_view> keys, std::span<std::uint64_t> values)
+    -> std::size_t
+{
+    next_line(text);
+
+    /* The rest is made of "Key:   value kB" lines, as in meminfo */
+    return parse_meminfo(text, keys, values);
+}
+
+auto Gossip::Parser::parse_stat(std::string_view text, Stat& stat) -> bool
+{
+    auto open = text.find('(');
+    auto close = text.rfind(')');
+
+    if (open == std::string_view::npos || close == std::string_view::npos
+        || close < open)
+        return false;
+
+    auto head = text.substr(0, open);
+    stat.pid = static_cast<int>(next_field(head));
+    stat.comm = text.substr(open + 1, close - open - 1);
+
+    auto rest = text.substr(close + 1);
+
+    while (!rest.empty() && rest.front() == ' ')
+        rest.remove_prefix(1);
+
+    if (rest.empty())
+        return false;
+
+    stat.state = rest.front();
+    rest.remove_prefix(1);
+
+    /*
+     * Fields are numbered from 1 as in proc(5); `state' was field 3, so
+     * the loop starts at 4 (ppid) and stops after 24 (rss).
+     */
+    for (int field = 4; field <= 24; field++) {
+        while (!rest.empty() && rest.front() == ' ')
+            rest.remove_prefix(1);
+
+        if (rest.empty() || rest.front() == '\n') {
+            /* utime and stime are the bare minimum we need */
+            return field > 15;
+        }
+
+        auto value = next_field(rest);
+
+        switch (field) {
+        case 4:
+            stat.ppid = static_cast<int>(value);
+            break;
+        case 9:
+            stat.flags = static_cast<std::uint64_t>(value);
+            break;
+        case 14:
+            stat.utime = static_cast<std::uint64_t>(value);
+            break;
+        case 15:
+            stat.stime = static_cast<std::uint64_t>(value);
+            break;
+        case 20:
+            stat.num_threads = value;
+            break;
+        case 22:
+            stat.starttime = static_cast<std::uint64_t>(value);
+            break;
+        case 23:
+            stat.vsize = static_cast<std::uint64_t>(value);
+            break;
+        case 24:
+            stat.rss = value;
+            break;
+        default:
+            break;
+        }
+    }
+
+    return true;
+}
+
+auto Gossip::Parser::parse_statm(std::string_view text, Statm& statm) -> bool
+{
+    std::uint64_t* fields[] = { &statm.size, &statm.resident, &statm.shared,
+        &statm.text, nullptr, &statm.data };
+    std::uint64_t value;
+
+    for (auto* field : fields) {
+        if (!next_number(text, value))
+            return false;
+
+        if (field)
+            *field = value;
+    }
+
+    return true;
+}
+
+auto Gossip::Parser::parse_cmdline(std::string_view text) -> std::string_view
+{
+    auto argv0 = text.substr(0, text.find('\0'));
+
+    return argv0.substr(0, argv0.find(' '));
+}
+
+auto Gossip::Parser::parse_cpu_line(
+    std::string_view line, std::span<std::uint64_t> values) -> std::size_t
+{
+    std::size_t count = 0;
+    std::uint64_t value;
+
+    /* First column contains the string 'cpu' or 'cpuN', skip it */
+    line.remove_prefix(std::min(line.find(' '), line.size()));
+
+    while (count < values.size() && next_number(line, value))
+        values[count++] = value;
+
+    return count;
+}
+
+auto Gossip::Parser::parse_flat_keyed(std::string_view text,
+    std::span<const std::string_view> keys, std::span<std::uint64_t> values)
+    -> std::size_t
+{
+    std::size_t found = 0;
+    std::size_t next = 0;
+
+    while (!text.empty() && found < keys.size()) {
+        auto line = next_line(text);
+        auto space = line.find(' ');
+
+        if (space == std::string_view::npos)
+            continue;
+
+        auto key = line.substr(0, space);
+
+        /* In the kernel's order too, more often than not */
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            auto k = (next + i) % keys.size();
+
+            if (keys[k] != key)
+                continue;
+
+            auto rest = line.substr(space + 1);
+
+            if (next_number(rest, values[k]))
+                found++;
+
+            next = k + 1;
+            break;
+        }
+    }
+
+    return found;
+}
+
+/* some avg10=0.00 avg60=0.00 avg300=0.00 total=0, then the same for full */
+auto Gossip::Parser::parse_pressure(std::string_view text, Pressure& pressure)
+    -> bool
+{
+    bool some = false;
+
+    pressure = {};
+
+    while (!text.empty()) {
+        auto line = next_line(text);
+        double* average;
+        std::uint64_t* total;
+
+        if (line.starts_with("some ")) {
+            average = &pressure.some_avg10;
+            total = &pressure.some_total;
+            some = true;
+        } else if (line.starts_with("full ")) {
+            average = &pressure.full_avg10;
+            total = &pressure.full_total;
+        } else {
+            continue;
+        }
+
+        auto avg10 = line.find("avg10=");
+        auto sum = line.find("total=");
+
+        if (avg10 == std::string_view::npos || sum == std::string_view::npos)
+            return false;
+
+        auto value = line.substr(avg10 + 6);
+
+        if (std::from_chars(value.data(), value.data() + value.size(),
+                *average)
+                .ec
+            != std::errc {})
+            return false;
+
+        value = line.substr(sum + 6);
+
+        if (!next_number(value, *total))
+            return false;
+    }
+
+    return some;
+}
+
+auto Gossip::Parser::parse_loadavg(std::string_view text, Loadavg& loadavg)
+    -> bool
+{
+    double* averages[] = { &loadavg.load_1, &loadavg.load_5, &loadavg.load_15 };
+
+    for (auto* average : averages) {
+        while (!text.empty() && text.front() == ' ')
+            text.remove_prefix(1);
+
+        auto [end, ec] = std::from_chars(
+            text.data(), text.data() + text.size(), *average);
+
+        if (ec != std::errc {})
+            return false;
+
+        text.remove_prefix(end - text.data());
+    }
+
+    std::uint64_t runnable;
+    std::uint64_t threads;
+
+    if (!next_number(text, runnable) || !next_number(text, threads))
+        return false;
+
+    loadavg.runnable = runnable;
+    loadavg.threads = threads;
+
+    return true;
+}
+
+auto Gossip::Parser::parse_meminfo(std::string_view text,
+    std::span<const std::string_view> keys, std::span<std::uint64_t> values)
+    -> std::size_t
+{
+    std::size_t found = 0;
+    std::size_t next = 0;
+
+    while (!text.empty() && found < keys.size()) {
+        auto line = next_line(text);
+        auto colon = line.find(':');
+
+        if (colon == std::string_view::npos)
+            continue;
+
+        auto key = line.substr(0, colon);
+
+        /*
+         * Keys are usually asked for in the order the kernel prints them,
+         * so start looking right after the previous match.
+         */
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            auto k = (next + i) % keys.size();
+
+            if (keys[k] != key)
+                continue;
+
+            auto rest = line.substr(colon + 1);
+
+            if (next_number(rest, values[k]))
+                found++;
+
+            next = k + 1;
+            break;
+        }
+    }
+
+    return found;
+}
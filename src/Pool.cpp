@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Pool - Work-stealing pool of collector threads
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Pool.hpp>
+
+#include <stdexcept>
+
+namespace {
+auto pack(std::uint64_t begin, std::uint64_t end) -> std::uint64_t
+{
+    return begin << 32 | end;
+}
+
+auto begin_of(std::uint64_t bounds) -> std::size_t { return bounds >> 32; }
+
+auto end_of(std::uint64_t bounds) -> std::size_t
+{
+    return bounds & 0xffffffff;
+}
+}
+
+Gossip::Pool::Pool(int jobs)
+    : jobs(jobs)
+    , work(nullptr)
+    , generation(0)
+    , running(0)
+    , stopping(false)
+{
+    if (jobs < 1) {
+        throw std::invalid_argument { "Need at least one job" };
+    }
+
+    ranges = std::make_unique<Range[]>(jobs);
+
+    for (int worker = 1; worker < jobs; worker++)
+        threads.emplace_back(&Pool::worker_main, this, worker);
+}
+
+Gossip::Pool::~Pool()
+{
+    {
+        std::lock_guard<std::mutex> guard { lock };
+        stopping = true;
+    }
+
+    start.notify_all();
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+auto Gossip::Pool::run(std::size_t count, const Work& work) -> void
+{
+    auto share = count / jobs;
+    auto extra = count % jobs;
+    std::size_t begin = 0;
+
+    for (int worker = 0; worker < jobs; worker++) {
+        auto end = begin + share + (static_cast<std::size_t>(worker) < extra);
+
+        ranges[worker].bounds = pack(begin, end);
+        begin = end;
+    }
+
+    if (threads.empty()) {
+        this->work = &work;
+        drain(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard { lock };
+
+        this->work = &work;
+        running = static_cast<int>(threads.size());
+        generation++;
+    }
+
+    start.notify_all();
+    drain(0);
+
+    std::unique_lock<std::mutex> guard { lock };
+    finish.wait(guard, [this] { return running == 0; });
+}
+
+auto Gossip::Pool::worker_main(int worker) -> void
+{
+    std::uint64_t seen = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> guard { lock };
+
+            start.wait(
+                guard, [&] { return stopping || generation != seen; });
+
+            if (stopping)
+                return;
+
+            seen = generation;
+        }
+
+        drain(worker);
+
+        std::lock_guard<std::mutex> guard { lock };
+
+        if (--running == 0)
+            finish.notify_one();
+    }
+}
+
+auto Gossip::Pool::drain(int worker) -> void
+{
+    std::size_t index;
+
+    while (take(worker, index))
+        (*work)(worker, index);
+
+    /*
+     * Our own slice is done. A few large processes can make a slice much
+     * slower than the others, so help whoever is still busy.
+     */
+    for (int i = 1; i < jobs; i++) {
+        int victim = (worker + i) % jobs;
+
+        while (steal(victim, index))
+            (*work)(worker, index);
+    }
+}
+
+auto Gossip::Pool::take(int worker, std::size_t& index) -> bool
+{
+    auto& bounds = ranges[worker].bounds;
+    auto current = bounds.load();
+
+    for (;;) {
+        auto begin = begin_of(current);
+        auto end = end_of(current);
+
+        if (begin >= end)
+            return false;
+
+        if (bounds.compare_exchange_weak(current, pack(begin + 1, end))) {
+            index = begin;
+            return true;
+        }
+    }
+}
+
+auto Gossip::Pool::steal(int victim, std::size_t& index) -> bool
+{
+    auto& bounds = ranges[victim].bounds;
+    auto current = bounds.load();
+
+    for (;;) {
+        auto begin = begin_of(current);
+        auto end = end_of(current);
+
+        if (begin >= end)
+            return false;
+
+        if (bounds.compare_exchange_weak(current, pack(begin, end - 1))) {
+            index = end - 1;
+            return true;
+        }
+    }
+}
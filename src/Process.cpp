@@ -5,112 +5,252 @@
  * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
  */
 
+#include <Parser.hpp>
 #include <Process.hpp>
-#include <fstream>
+#include <Stats.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <fcntl.h>
 #include <iostream>
 #include <limits>
-#include <regex>
-#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <unistd.h>
 
-auto Gossip::Process::extract() -> void
+namespace {
+/* From include/linux/sched.h, not exported to userspace */
+constexpr std::uint64_t pf_kthread = 0x00200000;
+};
+
+auto Gossip::Process::extract() -> bool
+{
+    if (!peek())
+        return false;
+
+    using Fields::Source;
+
+    if (!selection || selection->needs(Source::cmdline))
+        get_cmdline();
+
+    if (!selection || selection->needs(Source::smaps_rollup))
+        get_smaps_rollup();
+
+    if (mappings)
+        get_smaps();
+
+    return true;
+}
+
+auto Gossip::Process::peek() -> bool
 {
+    if (peeked)
+        return !kernel_thread;
+
     get_pid();
-    get_cmdline();
-    get_smaps_rollup();
+
+    if (cache)
+        entry = &cache->acquire(data.pid);
+
+    /*
+     * stat goes first: its starttime tells us whether a cached PID now
+     * belongs to a different process, and its flags whether this is a
+     * kernel thread we can stop at.
+     */
     get_stat();
+    peeked = true;
+
+    if (kernel_thread) {
+        Stats::count(Stats::Counter::skipped);
+
+        /* Its descriptor budget is better spent on someone else */
+        if (entry)
+            cache->release(*entry, ProcessCache::File::smaps_rollup);
+
+        return false;
+    }
+
+    return true;
 }
 
 auto Gossip::Process::get_pid() -> void
 {
-    if (!directory.is_directory()) {
+    /* Constructed from a PID, nothing to find out */
+    if (!directory)
+        return;
+
+    if (!directory->is_directory()) {
         throw std::invalid_argument { "Expecting a directory" };
     }
 
-    std::string process_id = directory.path().filename().string();
+    std::string process_id = directory->path().filename().string();
+
+    data.pid = std::stoi(process_id);
+}
+
+auto Gossip::Process::read(ProcessCache::File file, std::string_view name)
+    -> std::string_view
+{
+    auto index = static_cast<std::size_t>(file);
+
+    if (index < prefetched.size() && !prefetched[index].empty())
+        return prefetched[index];
+
+    if (entry)
+        return cache->read(*entry, file, Parser::scratch());
 
-    pid = std::stoi(process_id);
+    return Parser::read_file(directory->path() / name, Parser::scratch());
 }
 
 auto Gossip::Process::get_cmdline() -> void
 {
-    std::ifstream process_name { directory.path() / "cmdline" };
-    std::string cmdline;
+    if (entry && !entry->comm.empty()) {
+        data.comm = entry->comm;
+        return;
+    }
+
+    auto text = read(ProcessCache::File::cmdline, "cmdline");
 
-    getline(process_name, cmdline, '\0');
+    {
+        Stats::Timer timer { Stats::Phase::parse_cmdline };
 
-    std::istringstream iss(cmdline);
-    getline(iss, comm, ' ');
+        data.comm = Parser::parse_cmdline(text);
+    }
 
-    if (comm.empty()) {
-        comm = "unknown";
+    if (data.comm.empty()) {
+        data.comm = "unknown";
     }
+
+    if (entry)
+        entry->comm = data.comm;
 }
 
 auto Gossip::Process::get_smaps_rollup() -> void
 {
-    std::ifstream process_smaps { directory.path() / "smaps_rollup" };
-    std::string contents = std::string();
+    bool adaptive = staleness && entry;
 
-    constexpr auto read_size = std::size_t(1024);
-    auto buf = std::string(read_size, '\0');
+    if (adaptive && !stale()) {
+        std::copy(entry->values.begin(), entry->values.end(),
+            data.values.begin());
+        data.num_values = entry->values.size();
+        data.freshness = Sample::Freshness::carried;
+        entry->age++;
 
-    /*
-     * First line contains address space details which we're not
-     * interested in. It's safe to just drop it
-     */
-    process_smaps.getline(buf.data(), read_size, '\n');
-
-    while (process_smaps.read(buf.data(), read_size)) {
-        contents.append(buf, 0, process_smaps.gcount());
+        Stats::count(Stats::Counter::carried);
+        return;
     }
 
-    contents.append(buf, 0, process_smaps.gcount());
+    auto text = read(ProcessCache::File::smaps_rollup, "smaps_rollup");
+
+    {
+        Stats::Timer timer { Stats::Phase::parse_smaps_rollup };
+
+        if (selection && !selection->keys().empty())
+            data.num_values = parse_keys(text);
+        else
+            data.num_values = Parser::parse_smaps_rollup(text, data.values);
+    }
 
     /*
-     * If the contents of smaps_rollup are empty, ignore this
-     * process. It must be a kernel thread, such as a kworker.
+     * If smaps_rollup has no values, ignore this process. It must be a
+     * kernel thread, such as a kworker.
      */
-    if (contents.empty()) {
-        throw std::runtime_error { "No data for `" + comm + "'" + ":"
-            + std::to_string(pid) };
+    if (data.num_values == 0) {
+        Stats::count(Stats::Counter::skipped);
+        throw std::runtime_error { "No data for `" + data.comm + "'" + ":"
+            + std::to_string(data.pid) };
     }
 
-    std::regex values_regex("[0-9]+");
-    auto values_begin
-        = std::sregex_iterator(contents.begin(), contents.end(), values_regex);
-    auto values_end = std::sregex_iterator();
+    if (!adaptive)
+        return;
+
+    entry->values.assign(
+        data.values.begin(), data.values.begin() + data.num_values);
+    entry->rss = rss;
+    entry->total_time = data.total_time;
+    entry->age = 0;
+
+    data.freshness = Sample::Freshness::fresh;
+}
+
+auto Gossip::Process::get_smaps() -> void
+{
+    int fd;
+
+    if (cache) {
+        fd = cache->openat(data.pid, "smaps");
+    } else {
+        Stats::Timer timer { Stats::Phase::open };
 
-    for (std::sregex_iterator i = values_begin; i != values_end; ++i) {
-        std::smatch match = *i;
-        std::string str = match.str();
-        int value = std::stoi(str);
+        fd = ::open((directory->path() / "smaps").c_str(),
+            O_RDONLY | O_CLOEXEC);
+    }
 
-        values.push_back(value);
+    if (fd < 0) {
+        mappings->clear();
+        Stats::count(Stats::Counter::vanished);
+        return;
     }
+
+    /* Far too large to keep open or read in one go, it's streamed instead */
+    if (!mappings->read(fd))
+        Stats::count(Stats::Counter::vanished);
+
+    ::close(fd);
 }
 
-auto Gossip::Process::get_stat() -> void
+/*
+ * Look up the selected keys only. Those missing read as zero, so every
+ * row has the same columns; nothing found at all means no values.
+ */
+auto Gossip::Process::parse_keys(std::string_view text) -> std::size_t
 {
-    std::ifstream stat { directory.path() / "stat" };
-    std::string line;
-    int i;
+    auto keys = selection->keys();
 
-    /*
-     * The only values we want are utime, stime, and num_threads to compute cpu
-     * utilization, we know they are fields 14, 15, and 20. but the fields are
-     * zero-based, so we skip fields 0 - 12, and later skip 15-18.
-     */
-    for (i = 0; i < 13; i++)
-        std::getline(stat, line, ' ');
+    std::fill_n(data.values.begin(), keys.size(), 0);
 
-    std::getline(stat, line, ' ');
+    if (Parser::parse_smaps_rollup(text, keys, data.values) == 0)
+        return 0;
+
+    return keys.size();
+}
 
-    int utime = std::stoi(line);
+/* Whether values remembered in the cache entry are too old to carry over */
+auto Gossip::Process::stale() const -> bool
+{
+    return entry->values.empty() || entry->age >= staleness->max_age
+        || std::abs(rss - entry->rss) >= staleness->rss
+        || data.total_time - entry->total_time >= staleness->cpu;
+}
 
-    std::getline(stat, line, ' ');
+auto Gossip::Process::get_stat() -> void
+{
+    auto text = read(ProcessCache::File::stat, "stat");
+    Parser::Stat stat;
+    bool valid;
+
+    {
+        Stats::Timer timer { Stats::Phase::parse_stat };
+
+        valid = Parser::parse_stat(text, stat);
+    }
+
+    /*
+     * The only values we want are utime and stime to compute cpu
+     * utilization. A process that vanished since we listed /proc leaves
+     * us with nothing to parse.
+     */
+    if (!valid) {
+        Stats::count(Stats::Counter::vanished);
+        throw std::runtime_error { "Invalid stat for "
+            + std::to_string(data.pid) };
+    }
 
-    int stime = std::stoi(line);
+    data.total_time = stat.utime + stat.stime;
+    data.starttime = stat.starttime;
+    kernel_thread = stat.flags & pf_kthread;
+    rss = stat.rss;
+    vsize = stat.vsize;
 
-    total_time = utime + stime;
+    if (entry && entry->starttime != stat.starttime)
+        cache->renew(*entry, stat.starttime);
 }
@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * ProcessCache - Per-PID file descriptors kept open across samples
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <ProcessCache.hpp>
+#include <Stats.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace {
+/* Descriptors left alone for output files, /proc/stat and friends */
+constexpr rlim_t reserved_fds = 64;
+
+constexpr std::string_view file_names[] = { "stat", "smaps_rollup", "cmdline" };
+
+/*
+ * With one descriptor per file per process, the default soft limit of
+ * 1024 descriptors runs out quickly. Raise it as far as we're allowed
+ * and return how many descriptors we may spend on the cache.
+ */
+auto raise_fd_limit() -> long
+{
+    struct rlimit limit;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) < 0)
+        return 0;
+
+    if (limit.rlim_cur < limit.rlim_max) {
+        struct rlimit raised = limit;
+
+        raised.rlim_cur = limit.rlim_max == RLIM_INFINITY
+            ? std::max<rlim_t>(limit.rlim_cur, 1 << 20)
+            : limit.rlim_max;
+
+        if (setrlimit(RLIMIT_NOFILE, &raised) == 0)
+            limit = raised;
+    }
+
+    if (limit.rlim_cur <= reserved_fds)
+        return 0;
+
+    return static_cast<long>(limit.rlim_cur - reserved_fds);
+}
+
+/*
+ * The limit is the process's, so every cache draws from the same budget:
+ * per-thread caches can't each claim all of it and starve the others.
+ */
+auto shared_budget() -> std::atomic<long>&
+{
+    static std::atomic<long> budget { raise_fd_limit() };
+
+    return budget;
+}
+}
+
+Gossip::ProcessCache::ProcessCache(
+    const std::filesystem::path& procfs, bool smaps_rollup)
+    : generation(0)
+    , budget(shared_budget())
+    , kept(smaps_rollup ? 2 : 1)
+{
+    procfs_fd = ::open(procfs.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (procfs_fd < 0) {
+        throw std::runtime_error { "Can't open " + procfs.string() };
+    }
+}
+
+Gossip::ProcessCache::~ProcessCache()
+{
+    for (auto& [pid, entry] : entries)
+        close(entry);
+
+    ::close(procfs_fd);
+}
+
+auto Gossip::ProcessCache::available() -> long { return shared_budget(); }
+
+auto Gossip::ProcessCache::begin_tick() -> void { generation++; }
+
+auto Gossip::ProcessCache::end_tick() -> void
+{
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.last_seen == generation) {
+            ++it;
+            continue;
+        }
+
+        close(it->second);
+        it = entries.erase(it);
+    }
+}
+
+auto Gossip::ProcessCache::acquire(int pid) -> Entry&
+{
+    std::unique_lock<std::mutex> guard { lock };
+
+    /* References to unordered_map elements survive rehashing */
+    auto [it, inserted] = entries.try_emplace(pid);
+    auto& entry = it->second;
+
+    entry.last_seen = generation;
+    guard.unlock();
+
+    if (inserted) {
+        entry.pid = pid;
+        open(entry);
+    }
+
+    return entry;
+}
+
+auto Gossip::ProcessCache::read(Entry& entry, File file,
+    Parser::Buffer& buffer) -> std::string_view
+{
+    auto index = static_cast<std::size_t>(file);
+
+    /*
+     * cmdline is only read once per process, and processes we had no
+     * descriptor budget for fall back to opening their files every time.
+     */
+    if (file == File::cmdline || entry.fds[index] < 0) {
+        int fd = openat(entry.pid, file_names[index]);
+
+        if (fd < 0)
+            return {};
+
+        auto text = Parser::read_fd(fd, buffer);
+        ::close(fd);
+
+        return text;
+    }
+
+    auto text = Parser::read_fd(entry.fds[index], buffer);
+
+    /*
+     * stat is never empty for a live process. When reading it fails the
+     * process we had open is gone, but its PID may already belong to
+     * someone else: open the files again and let the caller compare
+     * starttime to tell them apart.
+     */
+    if (text.empty() && file == File::stat) {
+        close(entry);
+        open(entry);
+
+        if (entry.fds[index] >= 0)
+            text = Parser::read_fd(entry.fds[index], buffer);
+    }
+
+    return text;
+}
+
+auto Gossip::ProcessCache::renew(Entry& entry, std::uint64_t starttime)
+    -> void
+{
+    entry.starttime = starttime;
+    entry.comm.clear();
+    entry.values.clear();
+}
+
+auto Gossip::ProcessCache::release(Entry& entry, File file) -> void
+{
+    auto& fd = entry.fds[static_cast<std::size_t>(file)];
+
+    if (fd < 0)
+        return;
+
+    ::close(fd);
+    fd = -1;
+    budget++;
+}
+
+auto Gossip::ProcessCache::open(Entry& entry) -> void
+{
+    long wanted = static_cast<long>(kept);
+
+    /* Out of budget, this entry will open its files on every read */
+    if (budget.fetch_sub(wanted) < wanted) {
+        budget += wanted;
+        return;
+    }
+
+    for (std::size_t i = 0; i < kept; i++) {
+        entry.fds[i] = openat(entry.pid, file_names[i]);
+
+        if (entry.fds[i] < 0)
+            budget++;
+    }
+}
+
+auto Gossip::ProcessCache::close(Entry& entry) -> void
+{
+    for (auto& fd : entry.fds) {
+        if (fd < 0)
+            continue;
+
+        ::close(fd);
+        fd = -1;
+        budget++;
+    }
+}
+
+auto Gossip::ProcessCache::openat(int pid, std::string_view name) -> int
+{
+    /* "<pid>/<name>", built on the stack to keep path handling cheap */
+    char path[64];
+    auto end = std::to_chars(path, path + 16, pid).ptr;
+
+    *end++ = '/';
+    end = std::copy(name.begin(), name.end(), end);
+    *end = '\0';
+
+    Stats::Timer timer { Stats::Phase::open };
+
+    return ::openat(procfs_fd, path, O_RDONLY | O_CLOEXEC);
+}
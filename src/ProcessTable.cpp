@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * ProcessTable - What was last seen of each process, by PID and starttime
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <ProcessTable.hpp>
+
+namespace {
+/* Always a power of two, never more than half full */
+constexpr std::size_t initial_capacity = 1024;
+};
+
+Gossip::ProcessTable::ProcessTable()
+    : keys(initial_capacity)
+    , states(initial_capacity)
+    , count(0)
+    , seen(0)
+    , tick(0)
+{
+}
+
+/* Where the key is, or the empty slot it would go in */
+auto Gossip::ProcessTable::slot(int pid, std::uint64_t starttime) const
+    -> std::size_t
+{
+    auto mask = keys.size() - 1;
+
+    /* PIDs are mostly sequential already, starttime spreads reuses apart */
+    auto hash = (starttime ^ static_cast<std::uint64_t>(pid))
+        * 0x9e3779b97f4a7c15ull;
+    auto index = static_cast<std::size_t>(hash >> 32) & mask;
+
+    while (keys[index].pid >= 0
+        && (keys[index].pid != pid || keys[index].starttime != starttime))
+        index = (index + 1) & mask;
+
+    return index;
+}
+
+auto Gossip::ProcessTable::find(int pid, std::uint64_t starttime) const
+    -> const State*
+{
+    auto index = slot(pid, starttime);
+
+    return keys[index].pid < 0 ? nullptr : &states[index];
+}
+
+auto Gossip::ProcessTable::insert(int pid, std::uint64_t starttime)
+    -> std::pair<State*, bool>
+{
+    if (2 * (count + 1) > keys.size())
+        rebuild(2 * keys.size(), false);
+
+    auto index = slot(pid, starttime);
+    auto& key = keys[index];
+    bool found = key.pid >= 0;
+
+    if (!found) {
+        key = { pid, tick, starttime };
+        states[index] = {};
+        count++;
+        seen++;
+    } else if (key.tick != tick) {
+        key.tick = tick;
+        seen++;
+    }
+
+    return { &states[index], found };
+}
+
+/*
+ * Into a table of `capacity' slots, leaving out what wasn't seen this
+ * tick if `seen_only'. Probing needs no tombstones this way.
+ */
+auto Gossip::ProcessTable::rebuild(std::size_t capacity, bool seen_only)
+    -> void
+{
+    spare_keys.assign(capacity, Key {});
+    spare_states.resize(capacity);
+    spare_keys.swap(keys);
+    spare_states.swap(states);
+
+    count = 0;
+
+    for (std::size_t i = 0; i < spare_keys.size(); i++) {
+        auto& key = spare_keys[i];
+
+        if (key.pid < 0 || (seen_only && key.tick != tick))
+            continue;
+
+        auto index = slot(key.pid, key.starttime);
+
+        keys[index] = key;
+        states[index] = std::move(spare_states[i]);
+        count++;
+    }
+
+    if (seen_only)
+        seen = 0;
+}
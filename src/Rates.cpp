@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Rates - How each process changed since the last tick
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Fields.hpp>
+#include <Rates.hpp>
+#include <algorithm>
+#include <iomanip>
+#include <unistd.h>
+
+namespace {
+auto value(const Gossip::Sample& sample, int column) -> std::uint64_t
+{
+    if (column < 0 || static_cast<std::size_t>(column) >= sample.num_values)
+        return 0;
+
+    return sample.values[static_cast<std::size_t>(column)];
+}
+
+/* kB per second, shrinking ones negative */
+auto rate(std::uint64_t now, std::uint64_t before, double seconds) -> double
+{
+    return (static_cast<double>(now) - static_cast<double>(before)) / seconds;
+}
+};
+
+Gossip::Rates::Rates(std::span<const std::string_view> fields,
+    std::ostream* rate_output, std::ostream* event_output)
+    : rate_output(rate_output)
+    , event_output(event_output)
+    , rss_column(-1)
+    , pss_column(-1)
+    , clock_ticks(static_cast<double>(sysconf(_SC_CLK_TCK)))
+    , first(true)
+{
+    if (auto index = Fields::value_index(fields, "Rss"))
+        rss_column = static_cast<int>(*index);
+
+    if (auto index = Fields::value_index(fields, "Pss"))
+        pss_column = static_cast<int>(*index);
+
+    if (rate_output) {
+        /* Fixed notation, tiny rates would otherwise turn scientific */
+        *rate_output << std::fixed << std::setprecision(1);
+        *rate_output << "# PID,Comm,Start_Time,CPU_Percent,Rss_Rate,Pss_Rate,"
+                        "Timestamp"
+                     << std::endl;
+    }
+
+    if (event_output)
+        *event_output << "# PID,Comm,Start_Time,Event,Timestamp" << std::endl;
+}
+
+auto Gossip::Rates::write(const Tick& tick) -> void
+{
+    auto timestamp = tick.timestamp();
+
+    table.begin_tick();
+
+    for (auto& sample : tick.samples) {
+        auto [state, known] = table.insert(sample.pid, sample.starttime);
+        auto rss = value(sample, rss_column);
+        auto pss = value(sample, pss_column);
+
+        if (!known && !first && event_output) {
+            *event_output << sample.pid << "," << sample.comm << ","
+                          << sample.starttime << ",start," << timestamp
+                          << '\n';
+        }
+
+        if (known && rate_output && tick.start > state->time) {
+            auto seconds = static_cast<double>(tick.start - state->time) / 1e9;
+            auto used = static_cast<double>(sample.total_time
+                            - std::min(state->total_time, sample.total_time))
+                / clock_ticks;
+
+            *rate_output << sample.pid << "," << sample.comm << ","
+                         << sample.starttime << "," << 100 * used / seconds
+                         << ",";
+
+            if (rss_column >= 0)
+                *rate_output << rate(rss, state->rss, seconds);
+
+            *rate_output << ",";
+
+            if (pss_column >= 0)
+                *rate_output << rate(pss, state->pss, seconds);
+
+            *rate_output << "," << timestamp << '\n';
+        }
+
+        state->total_time = sample.total_time;
+        state->rss = rss;
+        state->pss = pss;
+        state->time = tick.start;
+
+        if (!known && event_output)
+            state->comm = sample.comm;
+    }
+
+    table.end_tick([&](int pid, std::uint64_t starttime, auto& state) {
+        if (event_output) {
+            *event_output << pid << "," << state.comm << "," << starttime
+                          << ",exit," << timestamp << '\n';
+        }
+    });
+
+    first = false;
+
+    if (rate_output)
+        rate_output->flush();
+
+    if (event_output)
+        event_output->flush();
+}
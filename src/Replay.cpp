@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Replay - Plays a capture back through the usual extractors
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Process.hpp>
+#include <Replay.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+/* What the capture was taken for, all of it if nothing was left out */
+auto select(std::span<const std::string_view> names)
+    -> Gossip::Fields::Selection
+{
+    auto all = Gossip::Fields::Selection::all();
+
+    if (std::ranges::equal(names, all.names()))
+        return all;
+
+    std::string list;
+
+    for (auto name : names) {
+        if (!list.empty())
+            list += ",";
+
+        list += name;
+    }
+
+    return Gossip::Fields::Selection::parse(list);
+}
+
+/* Private to us, and never a name someone else already picked */
+auto make_scratch(const std::filesystem::path& parent)
+    -> std::filesystem::path
+{
+    auto name = (parent / "gossip-decode-XXXXXX").string();
+
+    if (!::mkdtemp(name.data()))
+        throw std::runtime_error { "Can't make a scratch directory in `"
+            + parent.string() + "'" };
+
+    return name;
+}
+};
+
+Gossip::Replay::Replay(
+    CaptureReader& reader, const std::filesystem::path& parent)
+    : reader(reader)
+    , selection(select(reader.fields()))
+    , captured_system(false)
+{
+    scratch = make_scratch(parent);
+    directory.assign(scratch);
+    system_snapshot.emplace(directory);
+}
+
+Gossip::Replay::~Replay()
+{
+    std::error_code error;
+
+    std::filesystem::remove_all(scratch, error);
+}
+
+auto Gossip::Replay::next(Tick& tick) -> bool
+{
+    if (!reader.next(tick, records))
+        return false;
+
+    /* Nothing of the last tick's processes may linger */
+    for (auto pid : pids)
+        std::filesystem::remove_all(scratch / std::to_string(pid));
+
+    pids.clear();
+    captured_system = false;
+
+    for (auto& record : records) {
+        auto path = scratch;
+
+        if (record.pid) {
+            path /= std::to_string(record.pid);
+            std::filesystem::create_directory(path);
+            pids.push_back(record.pid);
+        } else if (record.file == Capture::File::stat) {
+            captured_system = true;
+        }
+
+        path /= Capture::file_names[static_cast<std::size_t>(record.file)];
+
+        std::ofstream { path, std::ios::binary }.write(record.bytes.data(),
+            static_cast<std::streamsize>(record.bytes.size()));
+    }
+
+    /* In PID order, as a live run writes them */
+    std::sort(pids.begin(), pids.end());
+    pids.erase(std::unique(pids.begin(), pids.end()), pids.end());
+
+    samples.clear();
+
+    for (auto pid : pids) {
+        std::filesystem::directory_entry entry { scratch
+            / std::to_string(pid) };
+        Process process { entry };
+
+        process.select(selection);
+
+        try {
+            /* Kernel threads are left out */
+            if (process.extract())
+                samples.push_back(process.sample());
+        } catch (const std::runtime_error& err) {
+            /* Exited while it was being captured */
+        }
+    }
+
+    if (captured_system)
+        system_snapshot->extract();
+
+    tick.samples = samples;
+
+    return true;
+}
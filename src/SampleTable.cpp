@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * SampleTable - Rows of samples, reused from tick to tick
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <SampleTable.hpp>
+#include <utility>
+
+auto Gossip::SampleTable::reset(std::size_t count) -> void
+{
+    if (table.size() < count)
+        table.resize(count);
+
+    used = count;
+
+    for (std::size_t i = 0; i < used; i++)
+        table[i].pid = -1;
+}
+
+auto Gossip::SampleTable::compact() -> void
+{
+    std::size_t kept = 0;
+
+    for (std::size_t i = 0; i < used; i++) {
+        if (table[i].pid < 0)
+            continue;
+
+        if (i != kept)
+            std::swap(table[kept], table[i]);
+
+        kept++;
+    }
+
+    used = kept;
+}
+
+auto Gossip::SampleTable::trim() -> void
+{
+    table.resize(used);
+    table.shrink_to_fit();
+}
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Scanner - Lists the PIDs in procfs
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Scanner.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+/* Large enough to list a few thousand PIDs per system call */
+constexpr std::size_t buffer_size = 64 * 1024;
+
+/* As the kernel lays them out; not every libc declares it */
+struct linux_dirent64 {
+    std::uint64_t d_ino;
+    std::int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+auto parse_pid(const char* name, int& pid) -> bool
+{
+    auto end = name + std::strlen(name);
+
+    /* from_chars() takes a leading '-', PIDs never have one */
+    if (name == end || *name < '0' || *name > '9')
+        return false;
+
+    auto [ptr, ec] = std::from_chars(name, end, pid);
+
+    return ec == std::errc {} && ptr == end && pid > 0;
+}
+};
+
+Gossip::Scanner::Scanner(const std::filesystem::path& procfs)
+    : buffer(buffer_size)
+{
+    fd = ::open(procfs.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (fd < 0) {
+        throw std::runtime_error { "Can't open " + procfs.string() };
+    }
+}
+
+Gossip::Scanner::~Scanner() { ::close(fd); }
+
+auto Gossip::Scanner::scan() -> const std::vector<int>&
+{
+    std::swap(current, last);
+    current.clear();
+
+    if (::lseek(fd, 0, SEEK_SET) < 0)
+        throw std::runtime_error { "Can't rewind procfs" };
+
+    for (;;) {
+        auto size = ::syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+
+        if (size < 0 && errno == EINTR)
+            continue;
+
+        if (size < 0)
+            throw std::runtime_error { "Can't list procfs" };
+
+        if (size == 0)
+            break;
+
+        for (long offset = 0; offset < size;) {
+            auto* entry
+                = reinterpret_cast<linux_dirent64*>(buffer.data() + offset);
+            int pid;
+
+            offset += entry->d_reclen;
+
+            /* Some filesystems leave d_type for us to find out */
+            if (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN)
+                continue;
+
+            if (parse_pid(entry->d_name, pid))
+                current.push_back(pid);
+        }
+    }
+
+    /* procfs lists PIDs in order already, other trees might not */
+    if (!std::is_sorted(current.begin(), current.end()))
+        std::sort(current.begin(), current.end());
+
+    return current;
+}
@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Scheduler - Fixed-rate tick deadlines on the monotonic clock
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Scheduler.hpp>
+#include <cerrno>
+#include <cmath>
+#include <ctime>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+constexpr std::int64_t nanoseconds_per_second = 1000000000;
+};
+
+Gossip::Scheduler::Scheduler(std::chrono::nanoseconds period)
+    : period(period.count())
+    , deadline(0)
+    , started(false)
+    , num_overruns(0)
+    , num_skipped(0)
+{
+    if (this->period <= 0)
+        throw std::invalid_argument { "Interval must be positive" };
+}
+
+auto Gossip::Scheduler::now() -> std::int64_t
+{
+    timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * nanoseconds_per_second + ts.tv_nsec;
+}
+
+auto Gossip::Scheduler::parse_interval(const std::string& text)
+    -> std::chrono::milliseconds
+{
+    std::size_t end = 0;
+    double value = std::stod(text, &end);
+    std::string_view unit { text.data() + end, text.size() - end };
+    double milliseconds;
+
+    if (unit.empty() || unit == "s")
+        milliseconds = value * 1000;
+    else if (unit == "ms")
+        milliseconds = value;
+    else
+        throw std::invalid_argument { "Unknown unit in interval `" + text
+            + "'" };
+
+    /* Written so NaN fails too */
+    if (!(milliseconds >= 1 && milliseconds < 1e12))
+        throw std::invalid_argument { "Interval must be at least 1ms" };
+
+    return std::chrono::milliseconds { std::llround(milliseconds) };
+}
+
+auto Gossip::Scheduler::wait() -> std::uint32_t
+{
+    auto current = now();
+
+    if (!started) {
+        started = true;
+        deadline = current;
+
+        return 0;
+    }
+
+    auto missed = advance(current);
+
+    timespec ts {};
+
+    ts.tv_sec = deadline / nanoseconds_per_second;
+    ts.tv_nsec = deadline % nanoseconds_per_second;
+
+    /* Absolute deadlines, so being interrupted doesn't push them back */
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr)
+        == EINTR)
+        ;
+
+    return missed;
+}
+
+auto Gossip::Scheduler::wait(std::span<pollfd> fds) -> std::uint32_t
+{
+    for (auto& fd : fds)
+        fd.revents = 0;
+
+    if (!started || fds.empty())
+        return wait();
+
+    auto missed = advance(now());
+
+    /* ppoll() only takes a timeout, worked out again after every wakeup */
+    for (;;) {
+        auto left = deadline - now();
+
+        if (left <= 0)
+            return missed;
+
+        timespec ts {};
+
+        ts.tv_sec = left / nanoseconds_per_second;
+        ts.tv_nsec = left % nanoseconds_per_second;
+
+        auto ready = ppoll(fds.data(), fds.size(), &ts, nullptr);
+
+        if (ready > 0) {
+            deadline = now();
+            return missed;
+        }
+
+        if (ready < 0 && errno != EINTR)
+            throw std::runtime_error { "Can't wait for triggers" };
+    }
+}
+
+auto Gossip::Scheduler::retime(std::chrono::nanoseconds period) -> void
+{
+    if (period.count() <= 0)
+        throw std::invalid_argument { "Interval must be positive" };
+
+    this->period = period.count();
+}
+
+auto Gossip::Scheduler::advance(std::int64_t current) -> std::uint32_t
+{
+    deadline += period;
+
+    std::uint32_t missed = 0;
+
+    if (current > deadline) {
+        missed = static_cast<std::uint32_t>((current - deadline) / period + 1);
+        deadline += missed * period;
+
+        num_overruns++;
+        num_skipped += missed;
+    }
+
+    return missed;
+}
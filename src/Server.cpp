@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Server - Answers queries about the History over a Unix socket
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Server.hpp>
+#include <Writer.hpp>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+/* Longer requests are cut short, none of ours comes close */
+constexpr std::size_t max_request = 256;
+
+/* How long a client may take to send its request */
+constexpr timeval request_timeout { 1, 0 };
+
+/* And to read all of the reply */
+constexpr std::chrono::milliseconds reply_timeout { 5000 };
+
+/*
+ * Gives up on a client that doesn't keep reading, and as soon as `wake'
+ * says we are shutting down, rather than blocking either forever.
+ */
+auto send_all(int fd, int wake, std::string_view data) -> void
+{
+    auto deadline = std::chrono::steady_clock::now() + reply_timeout;
+
+    while (!data.empty()) {
+        auto sent = ::send(
+            fd, data.data(), data.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+
+        if (sent > 0) {
+            data.remove_prefix(static_cast<std::size_t>(sent));
+            continue;
+        }
+
+        /* The client went away, nobody left to tell */
+        if (sent == 0 || (errno != EINTR && errno != EAGAIN))
+            return;
+
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+
+        if (left.count() <= 0)
+            return;
+
+        pollfd fds[] = { { fd, POLLOUT, 0 }, { wake, POLLIN, 0 } };
+
+        if (::poll(fds, 2, static_cast<int>(left.count())) < 0
+            && errno != EINTR)
+            return;
+
+        /* Left unread, for serve() to see too */
+        if (fds[1].revents)
+            return;
+    }
+}
+
+/* Nothing listens at `address', as connecting to it tells */
+auto abandoned(const sockaddr_un& address) -> bool
+{
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (fd < 0)
+        return false;
+
+    auto connected = ::connect(fd,
+        reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    auto refused = connected < 0 && errno == ECONNREFUSED;
+
+    ::close(fd);
+
+    return refused;
+}
+};
+
+Gossip::Server::Server(const std::filesystem::path& path, History& history,
+    std::span<const std::string_view> fields)
+    : path(path)
+    , history(history)
+    , fields(fields)
+{
+    sockaddr_un address {};
+
+    if (path.native().size() >= sizeof(address.sun_path))
+        throw std::runtime_error { "Socket path too long: " + path.string() };
+
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str());
+
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (listen_fd < 0)
+        throw std::runtime_error { "Can't create socket" };
+
+    /*
+     * Left behind by a run that didn't get to clean up after itself, if
+     * nobody answers on it any more. Never take over one still running.
+     */
+    if (std::filesystem::is_socket(path)) {
+        if (!abandoned(address)) {
+            ::close(listen_fd);
+            throw std::runtime_error { path.string() + " is already in use" };
+        }
+
+        std::filesystem::remove(path);
+    }
+
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&address),
+            sizeof(address))
+            < 0
+        || ::listen(listen_fd, 16) < 0
+        || ::pipe2(wake, O_CLOEXEC) < 0) {
+        ::close(listen_fd);
+        throw std::runtime_error { "Can't listen on " + path.string() };
+    }
+
+    thread = std::thread { [this] { serve(); } };
+}
+
+Gossip::Server::~Server()
+{
+    char byte = 0;
+
+    if (::write(wake[1], &byte, 1) == 1)
+        thread.join();
+    else
+        thread.detach();
+
+    ::close(wake[0]);
+    ::close(wake[1]);
+    ::close(listen_fd);
+
+    std::error_code ignored;
+    std::filesystem::remove(path, ignored);
+}
+
+auto Gossip::Server::answer(std::string_view request, std::ostream& reply)
+    -> void
+{
+    std::istringstream words { std::string { request } };
+    std::string command;
+
+    words >> command;
+
+    if (command == "ticks") {
+        history.list(reply);
+    } else if (command == "tick") {
+        std::uint64_t number;
+
+        if (!(words >> number)) {
+            reply << "error: Expecting a tick number\n";
+            return;
+        }
+
+        /* No header unless there is a tick to go with it */
+        std::ostringstream rows;
+        CsvWriter writer { rows, fields };
+
+        if (history.replay(number, writer))
+            reply << rows.str();
+        else
+            reply << "error: Tick " << number << " isn't kept\n";
+    } else if (command == "pid") {
+        int pid;
+        std::int64_t seconds = 0;
+        bool valid = static_cast<bool>(words >> pid);
+
+        if (valid && !(words >> std::ws).eof())
+            valid = (words >> seconds) && (words >> std::ws).eof();
+
+        if (!valid) {
+            reply << "error: Expecting a PID and, optionally, seconds\n";
+            return;
+        }
+
+        CsvWriter writer { reply, fields };
+
+        history.replay(pid, seconds, writer);
+    } else {
+        reply << "error: Unknown request `" << command << "'\n";
+    }
+}
+
+auto Gossip::Server::serve() -> void
+{
+    pollfd fds[] = { { listen_fd, POLLIN, 0 }, { wake[0], POLLIN, 0 } };
+
+    for (;;) {
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+
+            return;
+        }
+
+        if (fds[1].revents)
+            return;
+
+        int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+
+        if (fd < 0)
+            continue;
+
+        handle(fd);
+        ::close(fd);
+    }
+}
+
+auto Gossip::Server::handle(int fd) -> void
+{
+    char buffer[max_request];
+    std::size_t length = 0;
+
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &request_timeout,
+        sizeof(request_timeout));
+
+    /* Up to the end of the first line, or until the client stops writing */
+    while (length < sizeof(buffer)) {
+        auto received = ::recv(fd, buffer + length, sizeof(buffer) - length, 0);
+
+        if (received < 0 && errno == EINTR)
+            continue;
+
+        if (received <= 0)
+            break;
+
+        length += static_cast<std::size_t>(received);
+
+        if (std::memchr(buffer, '\n', length))
+            break;
+    }
+
+    std::string_view request { buffer, length };
+    std::ostringstream reply;
+
+    answer(request.substr(0, request.find('\n')), reply);
+    send_all(fd, wake[0], reply.str());
+}
@@ -0,0 +1,230 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Sink - Output file written from a thread of its own
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Sink.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+auto open_output(const std::filesystem::path& path) -> int
+{
+    int fd = ::open(
+        path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    if (fd < 0)
+        throw std::runtime_error { "Can't open `" + path.string()
+            + "': " + std::strerror(errno) };
+
+    return fd;
+}
+};
+
+Gossip::Sink::Sink(
+    const std::filesystem::path& path, Policy policy, std::size_t depth)
+    : Sink(open_output(path), policy, depth)
+{
+}
+
+Gossip::Sink::Sink(int fd, Policy policy, std::size_t depth)
+    : fd(fd)
+    , policy(policy)
+    , depth(depth)
+    , stopping(false)
+    , closed(false)
+    , error(0)
+    , num_dropped(0)
+{
+    if (depth == 0) {
+        ::close(fd);
+        throw std::invalid_argument { "Sink depth must be positive" };
+    }
+
+    reset_put_area();
+
+    writer = std::thread(&Sink::writer_main, this);
+}
+
+Gossip::Sink::~Sink()
+{
+    try {
+        close();
+    } catch (const std::runtime_error& err) {
+        /* Nobody left to tell */
+    }
+}
+
+auto Gossip::Sink::close() -> void
+{
+    if (closed)
+        return;
+
+    /* The last of it, often all there is of a summary */
+    enqueue(false);
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+
+    ready.notify_one();
+    writer.join();
+
+    ::close(fd);
+    closed = true;
+
+    if (error)
+        throw std::runtime_error { std::string { "Writing output: " }
+            + std::strerror(error) };
+}
+
+auto Gossip::Sink::overflow(int_type c) -> int_type
+{
+    auto used = pptr() - pbase();
+
+    current.resize(current.size() * 2);
+    setp(current.data(), current.data() + current.size());
+    pbump(static_cast<int>(used));
+
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(c);
+}
+
+auto Gossip::Sink::sync() -> int
+{
+    enqueue(policy == Policy::drop);
+
+    return 0;
+}
+
+auto Gossip::Sink::enqueue(bool may_drop) -> void
+{
+    auto used = static_cast<std::size_t>(pptr() - pbase());
+
+    if (used == 0)
+        return;
+
+    std::unique_lock<std::mutex> guard(lock);
+
+    if (queued.size() >= depth) {
+        if (may_drop) {
+            guard.unlock();
+
+            num_dropped++;
+            reset_put_area();
+
+            if (dropped_hook)
+                dropped_hook();
+
+            return;
+        }
+
+        space.wait(guard, [this] { return queued.size() < depth; });
+    }
+
+    current.resize(used);
+    queued.push_back(std::move(current));
+
+    current.clear();
+
+    if (!spare.empty()) {
+        current = std::move(spare.back());
+        spare.pop_back();
+    }
+
+    guard.unlock();
+    ready.notify_one();
+
+    reset_put_area();
+}
+
+auto Gossip::Sink::reset_put_area() -> void
+{
+    current.resize(std::max(current.capacity(), buffer_size));
+    setp(current.data(), current.data() + current.size());
+}
+
+auto Gossip::Sink::writer_main() -> void
+{
+    std::vector<std::vector<char>> batch;
+    std::unique_lock<std::mutex> guard(lock);
+
+    for (;;) {
+        ready.wait(guard, [this] { return stopping || !queued.empty(); });
+
+        if (queued.empty())
+            break;
+
+        /* Take everything queued, it all goes out in a single writev() */
+        while (!queued.empty()) {
+            batch.push_back(std::move(queued.front()));
+            queued.pop_front();
+        }
+
+        guard.unlock();
+        space.notify_one();
+
+        /* After a failed write, keep draining so nobody blocks forever */
+        int failed = error ? 0 : write_all(batch) ? 0 : errno;
+
+        guard.lock();
+
+        if (failed)
+            error = failed;
+
+        for (auto& buffer : batch)
+            spare.push_back(std::move(buffer));
+
+        batch.clear();
+    }
+}
+
+auto Gossip::Sink::write_all(std::vector<std::vector<char>>& batch) -> bool
+{
+    std::vector<iovec> iov;
+
+    for (auto& buffer : batch)
+        iov.push_back({ buffer.data(), buffer.size() });
+
+    std::size_t first = 0;
+
+    while (first < iov.size()) {
+        auto count = std::min<std::size_t>(iov.size() - first, IOV_MAX);
+        auto written = ::writev(fd, &iov[first], static_cast<int>(count));
+
+        if (written < 0 && errno == EINTR)
+            continue;
+
+        if (written < 0)
+            return false;
+
+        /* Partial writes leave us somewhere in the middle of a buffer */
+        auto left = static_cast<std::size_t>(written);
+
+        while (first < iov.size() && left >= iov[first].iov_len) {
+            left -= iov[first].iov_len;
+            first++;
+        }
+
+        if (left) {
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + left;
+            iov[first].iov_len -= left;
+        }
+    }
+
+    return true;
+}
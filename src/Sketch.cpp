@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Sketch - Online statistics in bounded memory
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Sketch.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr double ratio
+    = (1 + Gossip::Sketch::accuracy) / (1 - Gossip::Sketch::accuracy);
+
+const double log_ratio = std::log(ratio);
+
+auto index_of(double value) -> int
+{
+    return static_cast<int>(std::ceil(std::log(value) / log_ratio));
+}
+
+/* Halfway between the bounds of the bucket, relatively speaking */
+auto value_of(int index) -> double
+{
+    return 2 * std::pow(ratio, index) / (ratio + 1);
+}
+};
+
+auto Gossip::Moments::add(double value) -> void
+{
+    if (n == 0 || value < low)
+        low = value;
+
+    if (n == 0 || value > high)
+        high = value;
+
+    n++;
+
+    auto delta = value - average;
+
+    average += delta / static_cast<double>(n);
+    m2 += delta * (value - average);
+}
+
+auto Gossip::Moments::merge(const Moments& other) -> void
+{
+    if (other.n == 0)
+        return;
+
+    if (n == 0) {
+        *this = other;
+        return;
+    }
+
+    /* Chan et al., for two partial results */
+    auto count = static_cast<double>(n + other.n);
+    auto delta = other.average - average;
+
+    m2 += other.m2
+        + delta * delta * static_cast<double>(n) * static_cast<double>(other.n)
+            / count;
+    average += delta * static_cast<double>(other.n) / count;
+    low = std::min(low, other.low);
+    high = std::max(high, other.high);
+    n += other.n;
+}
+
+auto Gossip::Moments::variance() const -> double
+{
+    return n < 2 ? 0 : m2 / static_cast<double>(n - 1);
+}
+
+auto Gossip::Sketch::add(double value) -> void
+{
+    total++;
+
+    if (!(value >= 1)) {
+        zeros++;
+        return;
+    }
+
+    auto index = index_of(value);
+
+    grow(index);
+    buckets[static_cast<std::size_t>(std::max(index, first) - first)]++;
+    collapse();
+}
+
+auto Gossip::Sketch::merge(const Sketch& other) -> void
+{
+    total += other.total;
+    zeros += other.zeros;
+
+    if (other.buckets.empty())
+        return;
+
+    grow(other.first);
+    grow(other.first + static_cast<int>(other.buckets.size()) - 1);
+
+    for (std::size_t i = 0; i < other.buckets.size(); i++) {
+        auto index = std::max(other.first + static_cast<int>(i), first);
+
+        buckets[static_cast<std::size_t>(index - first)] += other.buckets[i];
+    }
+
+    collapse();
+}
+
+auto Gossip::Sketch::quantile(double q) const -> double
+{
+    if (total == 0)
+        return 0;
+
+    /* Rank of the value we're after, counting from zero */
+    auto rank = static_cast<std::uint64_t>(
+        std::clamp(q, 0.0, 1.0) * static_cast<double>(total - 1));
+
+    if (rank < zeros)
+        return 0;
+
+    rank -= zeros;
+
+    for (std::size_t i = 0; i < buckets.size(); i++) {
+        if (rank < buckets[i])
+            return value_of(first + static_cast<int>(i));
+
+        rank -= buckets[i];
+    }
+
+    return value_of(first + static_cast<int>(buckets.size()) - 1);
+}
+
+/* Make room for bucket `index', unless it's below the folded ones */
+auto Gossip::Sketch::grow(int index) -> void
+{
+    if (buckets.empty()) {
+        first = index;
+        buckets.resize(1);
+        return;
+    }
+
+    auto last = first + static_cast<int>(buckets.size()) - 1;
+
+    if (index > last) {
+        buckets.resize(buckets.size() + static_cast<std::size_t>(index - last));
+    } else if (index < first && buckets.size() < max_buckets) {
+        auto missing = std::min(static_cast<std::size_t>(first - index),
+            max_buckets - buckets.size());
+
+        buckets.insert(buckets.begin(), missing, 0);
+        first -= static_cast<int>(missing);
+    }
+}
+
+auto Gossip::Sketch::collapse() -> void
+{
+    if (buckets.size() <= max_buckets)
+        return;
+
+    auto extra = buckets.size() - max_buckets;
+    std::uint64_t folded = 0;
+
+    for (std::size_t i = 0; i <= extra; i++)
+        folded += buckets[i];
+
+    buckets.erase(buckets.begin(),
+        buckets.begin() + static_cast<std::ptrdiff_t>(extra));
+    buckets.front() = folded;
+    first += static_cast<int>(extra);
+}
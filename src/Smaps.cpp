@@ -0,0 +1,252 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Smaps - Per-mapping memory usage from /proc/$PID/smaps
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Smaps.hpp>
+#include <Stats.hpp>
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+constexpr auto npos = std::string_view::npos;
+
+/* Bytes looked at by each match() */
+constexpr std::size_t block = 16;
+
+auto is_hex(char c) -> bool
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+}
+
+/* Bit i is set if `at[i]' is `c', for the `block' bytes from `at' */
+auto match(const char* at, char c) -> std::uint32_t
+{
+#if defined(__SSE2__)
+    auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(at));
+    auto equal = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(c));
+
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(equal));
+#else
+    std::uint32_t mask = 0;
+
+    for (std::size_t i = 0; i < block; i++)
+        mask |= static_cast<std::uint32_t>(at[i] == c) << i;
+
+    return mask;
+#endif
+}
+
+/* Where the first `c' at or after `from' is, or npos */
+auto find(std::string_view text, char c, std::size_t from = 0)
+    -> std::size_t
+{
+    auto i = from;
+
+    for (; i + block <= text.size(); i += block) {
+        if (auto mask = match(text.data() + i, c))
+            return i + static_cast<std::size_t>(std::countr_zero(mask));
+    }
+
+    for (; i < text.size(); i++) {
+        if (text[i] == c)
+            return i;
+    }
+
+    return npos;
+}
+};
+
+auto Gossip::Smaps::read(int fd) -> bool
+{
+    /* Keep every path around, they are likely to show up again */
+    for (auto& [path, mapping] : totals)
+        mapping = {};
+
+    current = nullptr;
+    truncated = false;
+    next = 0;
+
+    std::size_t kept = 0;
+    bool found = false;
+
+    for (;;) {
+        ssize_t len;
+
+        {
+            Stats::Timer timer { Stats::Phase::read };
+
+            len = ::read(fd, buffer.data() + kept, buffer.size() - kept);
+        }
+
+        if (len < 0 && errno == EINTR)
+            continue;
+
+        if (len <= 0)
+            break;
+
+        found = true;
+
+        Stats::Timer timer { Stats::Phase::parse_smaps };
+        std::string_view text { buffer.data(),
+            kept + static_cast<std::size_t>(len) };
+        auto used = consume(text);
+
+        /* A single line filled the whole buffer */
+        if (used == 0 && text.size() == buffer.size()) {
+            if (!truncated)
+                parse_line(text);
+
+            truncated = true;
+            used = text.size();
+        }
+
+        /* The last line is only partly read, finish it with the next chunk */
+        kept = text.size() - used;
+        std::memmove(buffer.data(), buffer.data() + used, kept);
+    }
+
+    if (kept && !truncated)
+        parse_line({ buffer.data(), kept });
+
+    std::erase_if(totals, [](auto& it) { return it.second.count == 0; });
+
+    return found;
+}
+
+/*
+ * Parse every complete line in `text', finding where they end 16 bytes
+ * at a time. Returns how much of `text' was used up.
+ */
+auto Gossip::Smaps::consume(std::string_view text) -> std::size_t
+{
+    std::size_t start = 0;
+    std::size_t i = 0;
+
+    auto end_of_line = [&](std::size_t end) {
+        if (truncated)
+            truncated = false;
+        else
+            parse_line(text.substr(start, end - start));
+
+        start = end + 1;
+    };
+
+    for (; i + block <= text.size(); i += block) {
+        for (auto mask = match(text.data() + i, '\n'); mask; mask &= mask - 1)
+            end_of_line(i + static_cast<std::size_t>(std::countr_zero(mask)));
+    }
+
+    for (; i < text.size(); i++) {
+        if (text[i] == '\n')
+            end_of_line(i);
+    }
+
+    return start;
+}
+
+auto Gossip::Smaps::parse_line(std::string_view line) -> void
+{
+    if (line.empty())
+        return;
+
+    /*
+     * A new mapping starts with its address range, in lowercase hex:
+     * "start-end perms offset dev inode    path", where path is missing
+     * for anonymous memory. Value lines start with a capitalized key.
+     */
+    if (is_hex(line.front())) {
+        std::size_t at = 0;
+
+        for (int field = 0; field < 5 && at != npos; field++) {
+            at = find(line, ' ', at);
+
+            if (at != npos)
+                at++;
+        }
+
+        std::string_view path;
+
+        if (at != npos) {
+            path = line.substr(at);
+            path.remove_prefix(std::min(path.find_first_not_of(' '),
+                path.size()));
+        }
+
+        if (path.empty())
+            path = "[anon]";
+
+        auto it = totals.find(path);
+
+        if (it == totals.end())
+            it = totals.emplace(path, Mapping {}).first;
+
+        current = &it->second;
+        current->count++;
+        next = 0;
+
+        return;
+    }
+
+    if (!current)
+        return;
+
+    auto colon = find(line, ':');
+
+    if (colon == npos)
+        return;
+
+    auto key = line.substr(0, colon);
+
+    /* Same as Parser::parse_meminfo(), keys come in the order we list them */
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        auto k = (next + i) % keys.size();
+
+        if (keys[k] != key)
+            continue;
+
+        auto rest = line.substr(colon + 1);
+        std::uint64_t value = 0;
+
+        rest.remove_prefix(std::min(rest.find_first_not_of(' '), rest.size()));
+        std::from_chars(rest.data(), rest.data() + rest.size(), value);
+
+        current->values[k] += value;
+        next = k + 1;
+
+        return;
+    }
+}
+
+auto Gossip::Smaps::write_header(std::ostream& os) -> void
+{
+    os << "# PID,Mapping,Count";
+
+    for (auto key : keys)
+        os << "," << key;
+
+    os << ",Timestamp" << std::endl;
+}
+
+auto Gossip::Smaps::write(std::ostream& os, int pid,
+    std::string_view timestamp) const -> void
+{
+    for (auto& [path, mapping] : totals) {
+        os << pid << "," << path << "," << mapping.count;
+
+        for (auto value : mapping.values)
+            os << "," << value;
+
+        os << "," << timestamp << '\n';
+    }
+}
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Stats - Where gossip itself spends its time
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Scheduler.hpp>
+#include <Stats.hpp>
+#include <algorithm>
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+using Gossip::Stats::counter_names;
+using Gossip::Stats::phase_names;
+
+/* Bucket i counts latencies of i significant bits, i.e. below 2^i ns */
+struct Histogram {
+    std::array<std::uint64_t, 65> buckets {};
+    std::uint64_t count = 0;
+    std::uint64_t total = 0;
+    std::uint64_t max = 0;
+
+    auto add(std::uint64_t nanoseconds) -> void
+    {
+        buckets[std::bit_width(nanoseconds)]++;
+        count++;
+        total += nanoseconds;
+        max = std::max(max, nanoseconds);
+    }
+
+    auto merge(const Histogram& other) -> void
+    {
+        for (std::size_t i = 0; i < buckets.size(); i++)
+            buckets[i] += other.buckets[i];
+
+        count += other.count;
+        total += other.total;
+        max = std::max(max, other.max);
+    }
+
+    /* Upper bound of the bucket holding the quantile, never above max */
+    auto quantile(double q) const -> std::uint64_t
+    {
+        auto rank = static_cast<std::uint64_t>(q * count);
+        std::uint64_t seen = 0;
+
+        for (std::size_t i = 0; i < buckets.size(); i++) {
+            seen += buckets[i];
+
+            if (seen > rank)
+                return i < 64 ? std::min(max, (std::uint64_t { 1 } << i) - 1)
+                              : max;
+        }
+
+        return max;
+    }
+};
+
+/* Each thread records into its own, merged when a tick is written */
+struct Shard {
+    std::array<Histogram, phase_names.size()> phases;
+    std::array<std::uint64_t, counter_names.size()> counters {};
+};
+
+std::mutex registry_lock;
+std::vector<std::unique_ptr<Shard>> registry;
+
+auto local() -> Shard&
+{
+    thread_local Shard* shard = nullptr;
+
+    if (!shard) {
+        std::lock_guard<std::mutex> guard(registry_lock);
+
+        registry.push_back(std::make_unique<Shard>());
+        shard = registry.back().get();
+    }
+
+    return *shard;
+}
+};
+
+auto Gossip::Stats::enable() -> void { enabled = true; }
+
+auto Gossip::Stats::record(Phase phase, std::int64_t nanoseconds) -> void
+{
+    local().phases[static_cast<std::size_t>(phase)].add(
+        static_cast<std::uint64_t>(std::max<std::int64_t>(nanoseconds, 0)));
+}
+
+auto Gossip::Stats::add(Counter counter) -> void
+{
+    local().counters[static_cast<std::size_t>(counter)]++;
+}
+
+auto Gossip::Stats::Timer::now() -> std::int64_t { return Scheduler::now(); }
+
+auto Gossip::Stats::write_header(std::ostream& os) -> void
+{
+    os << "# Tick_Start,";
+
+    for (auto name : counter_names)
+        os << name << ",";
+
+    for (auto name : phase_names) {
+        os << name << "_Count," << name << "_Total_ns," << name << "_P50_ns,"
+           << name << "_P90_ns," << name << "_P99_ns," << name << "_Max_ns,";
+    }
+
+    os << "Timestamp" << std::endl;
+}
+
+auto Gossip::Stats::write(std::ostream& os, const Tick& tick) -> void
+{
+    Shard total;
+
+    {
+        std::lock_guard<std::mutex> guard(registry_lock);
+
+        for (auto& shard : registry) {
+            for (std::size_t i = 0; i < total.phases.size(); i++)
+                total.phases[i].merge(shard->phases[i]);
+
+            for (std::size_t i = 0; i < total.counters.size(); i++)
+                total.counters[i] += shard->counters[i];
+
+            *shard = Shard {};
+        }
+    }
+
+    os << tick.start << ",";
+
+    for (auto value : total.counters)
+        os << value << ",";
+
+    for (auto& phase : total.phases) {
+        os << phase.count << "," << phase.total << "," << phase.quantile(0.5)
+           << "," << phase.quantile(0.9) << "," << phase.quantile(0.99) << ","
+           << phase.max << ",";
+    }
+
+    os << tick.timestamp() << std::endl;
+}
@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Summary - Per-process statistics instead of every sample
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Fields.hpp>
+#include <Summary.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <unistd.h>
+
+namespace {
+constexpr std::size_t cpu = 3;
+constexpr std::array<double, 3> quantiles { 0.5, 0.95, 0.99 };
+};
+
+Gossip::Summary::Summary(std::ostream& output,
+    std::span<const std::string_view> fields, unsigned interval)
+    : output(output)
+    , interval(interval)
+    , ticks(0)
+    , summarized(0)
+    , time(0)
+    , utc_offset(0)
+    , clock_ticks(static_cast<double>(sysconf(_SC_CLK_TCK)))
+{
+    columns.fill(-1);
+
+    for (std::size_t i = 0; i < cpu; i++) {
+        if (auto index = Fields::value_index(fields, metrics[i]))
+            columns[i] = static_cast<int>(*index);
+    }
+
+    for (auto field : fields) {
+        if (field == "Total_Process_Time")
+            columns[cpu] = 0;
+    }
+
+    /* Fixed notation, large values would otherwise turn scientific */
+    output << std::fixed << std::setprecision(1);
+    output << "# PID,Comm,Start_Time,Metric,Count,Min,Max,Mean,Stddev,P50,P95,"
+              "P99,Timestamp"
+           << std::endl;
+}
+
+auto Gossip::Summary::write(const Tick& tick) -> void
+{
+    ticks++;
+    time = tick.time;
+    utc_offset = tick.utc_offset;
+
+    for (auto& sample : tick.samples) {
+        auto& process = processes[{ sample.pid, sample.starttime }];
+
+        if (process.comm.empty())
+            process.comm = sample.comm;
+
+        for (std::size_t i = 0; i < cpu; i++) {
+            auto column = columns[i];
+
+            if (column < 0
+                || static_cast<std::size_t>(column) >= sample.num_values)
+                continue;
+
+            auto value = static_cast<double>(sample.values[column]);
+
+            process.moments[i].add(value);
+            process.sketches[i].add(value);
+        }
+
+        /* Percent of one CPU since the previous tick it was seen in */
+        if (columns[cpu] >= 0 && process.last_seen
+            && tick.start > process.start) {
+            auto used = static_cast<double>(
+                            sample.total_time - process.total_time)
+                / clock_ticks;
+            auto elapsed = static_cast<double>(tick.start - process.start)
+                / 1e9;
+
+            process.moments[cpu].add(100 * used / elapsed);
+            process.sketches[cpu].add(100 * used / elapsed);
+        }
+
+        process.total_time = sample.total_time;
+        process.start = tick.start;
+        process.last_seen = ticks;
+    }
+
+    if (interval && ticks % interval == 0)
+        summarize();
+}
+
+auto Gossip::Summary::finish() -> void
+{
+    if (ticks > summarized)
+        summarize();
+}
+
+auto Gossip::Summary::summarize() -> void
+{
+    Tick tick;
+
+    tick.time = time;
+    tick.utc_offset = utc_offset;
+
+    auto timestamp = tick.timestamp();
+
+    for (auto& [key, process] : processes) {
+        if (process.last_seen <= summarized)
+            continue;
+
+        for (std::size_t i = 0; i < metrics.size(); i++) {
+            auto& moments = process.moments[i];
+            auto& sketch = process.sketches[i];
+
+            if (!moments.count())
+                continue;
+
+            output << key.first << "," << process.comm << "," << key.second
+                   << "," << metrics[i] << "," << moments.count() << ","
+                   << moments.min() << "," << moments.max() << ","
+                   << moments.mean() << "," << std::sqrt(moments.variance());
+
+            /* Bucket midpoints may fall outside of what was seen */
+            for (auto q : quantiles)
+                output << ","
+                       << std::clamp(sketch.quantile(q), moments.min(),
+                              moments.max());
+
+            output << "," << timestamp << '\n';
+        }
+    }
+
+    output.flush();
+
+    /* Those not in the last tick exited, and were just written out */
+    std::erase_if(processes,
+        [this](auto& it) { return it.second.last_seen < ticks; });
+
+    summarized = ticks;
+}
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * System - System-wide snapshot, taken once per tick
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Parser.hpp>
+#include <Stats.hpp>
+#include <System.hpp>
+
+auto Gossip::System::extract() -> void
+{
+    {
+        Stats::Timer timer { Stats::Phase::cpu };
+
+        cpu.extract();
+    }
+
+    get_loadavg();
+    get_meminfo();
+}
+
+auto Gossip::System::write_header(std::ostream& os, bool bursts) const
+    -> void
+{
+    os << "# Total_CPU_Time,CPU_Threads,Load_1,Load_5,Load_15,"
+          "Runnable,Threads,";
+
+    for (auto key : meminfo_keys) {
+        os << key << ",";
+    }
+
+    for (auto& online : cpu.online()) {
+        os << "CPU" << online.id << "_Time,CPU" << online.id << "_Idle,";
+    }
+
+    os << "Tick_Start,Tick_End,Skipped," << (bursts ? "Burst," : "")
+       << "Timestamp\n";
+}
+
+auto Gossip::System::get_loadavg() -> void
+{
+    auto text = Parser::read_file(loadavg_path, Parser::scratch());
+
+    if (!Parser::parse_loadavg(text, loadavg))
+        loadavg = {};
+}
+
+auto Gossip::System::get_meminfo() -> void
+{
+    auto text = Parser::read_file(meminfo_path, Parser::scratch());
+
+    meminfo.fill(0);
+    Parser::parse_meminfo(text, meminfo_keys, meminfo);
+}
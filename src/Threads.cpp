@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Threads - Per-thread CPU time of one process
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Parser.hpp>
+#include <Stats.hpp>
+#include <Threads.hpp>
+#include <stdexcept>
+
+Gossip::Threads::Threads(const std::filesystem::path& procfs, int pid)
+    : process(pid)
+    , task(procfs / std::to_string(pid) / "task")
+{
+}
+
+auto Gossip::Threads::scan() -> std::size_t
+{
+    list.clear();
+
+    try {
+        if (!scanner) {
+            scanner.emplace(task);
+            cache.emplace(task, false);
+        }
+
+        auto& tids = scanner->scan();
+
+        list.resize(tids.size());
+
+        for (std::size_t i = 0; i < tids.size(); i++)
+            list[i].tid = tids[i];
+    } catch (const std::runtime_error& err) {
+        /* Not there yet, or gone */
+    }
+
+    /*
+     * A task directory that vanished under us reads as empty; open it
+     * again next time, in case its PID went to a new process.
+     */
+    if (list.empty()) {
+        scanner.reset();
+        cache.reset();
+
+        return 0;
+    }
+
+    cache->begin_tick();
+
+    return list.size();
+}
+
+auto Gossip::Threads::extract(std::size_t index) -> void
+{
+    auto& thread = list[index];
+    auto& entry = cache->acquire(thread.tid);
+    auto text = cache->read(entry, ProcessCache::File::stat, Parser::scratch());
+    Parser::Stat stat;
+    bool valid;
+
+    {
+        Stats::Timer timer { Stats::Phase::parse_stat };
+
+        valid = Parser::parse_stat(text, stat);
+    }
+
+    if (!valid) {
+        Stats::count(Stats::Counter::vanished);
+        thread.tid = -1;
+
+        return;
+    }
+
+    /* Thread names fit in 16 bytes, short enough to never allocate */
+    thread.name = stat.comm;
+    thread.total_time = stat.utime + stat.stime;
+
+    if (entry.starttime != stat.starttime)
+        cache->renew(entry, stat.starttime);
+}
+
+auto Gossip::Threads::finish() -> void
+{
+    if (cache)
+        cache->end_tick();
+}
+
+auto Gossip::Threads::write_header(std::ostream& os) -> void
+{
+    os << "# PID,TID,Name,Total_Thread_Time,Timestamp" << std::endl;
+}
+
+auto Gossip::Threads::write(std::ostream& os, std::string_view timestamp)
+    const -> void
+{
+    for (auto& thread : list) {
+        if (thread.tid < 0)
+            continue;
+
+        os << process << "," << thread.tid << "," << thread.name << ","
+           << thread.total_time << "," << timestamp << '\n';
+    }
+}
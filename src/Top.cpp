@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Top - The heaviest processes of each tick
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Top.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace {
+/* smaps_rollup key of each memory metric */
+constexpr std::array<std::string_view, 3> keys { "Rss", "Pss", "Swap" };
+
+auto lighter(const std::pair<std::uint64_t, Gossip::Sample>& a,
+    const std::pair<std::uint64_t, Gossip::Sample>& b) -> bool
+{
+    return a.first > b.first;
+}
+};
+
+Gossip::Top::Top(std::size_t count, std::string_view metric,
+    const Fields::Selection& fields)
+    : count(count)
+    , column(0)
+    , page_kb(static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE)) / 1024)
+{
+    auto it = std::find(metric_names.begin(), metric_names.end(), metric);
+
+    if (it == metric_names.end())
+        throw std::invalid_argument { "Unknown metric: "
+            + std::string { metric } };
+
+    this->metric = static_cast<Metric>(it - metric_names.begin());
+
+    if (this->metric == Metric::cpu)
+        return;
+
+    auto key = keys[static_cast<std::size_t>(this->metric)];
+    auto index = fields.index_of(key);
+
+    if (!index)
+        throw std::invalid_argument { "Ranking by " + std::string { metric }
+            + " needs the " + std::string { key } + " field" };
+
+    column = *index;
+}
+
+auto Gossip::Top::candidate(const Process& process) const -> Candidate
+{
+    auto& sample = process.sample();
+    Candidate result { sample.pid, sample.starttime, sample.total_time, 0 };
+    auto resident = static_cast<std::uint64_t>(
+                        std::max<std::int64_t>(process.resident(), 0))
+        * page_kb;
+
+    switch (metric) {
+    case Metric::rss:
+    case Metric::pss:
+        result.bound = resident;
+        break;
+    case Metric::swap:
+        result.bound = process.virtual_size() / 1024
+            - std::min(resident, process.virtual_size() / 1024);
+        break;
+    case Metric::cpu:
+        result.bound = sample.total_time;
+
+        if (auto* state = times.find(sample.pid, sample.starttime))
+            result.bound -= std::min(state->total_time, sample.total_time);
+
+        break;
+    }
+
+    return result;
+}
+
+auto Gossip::Top::rank(std::vector<Candidate>& candidates) -> void
+{
+    std::erase_if(
+        candidates, [](auto& candidate) { return candidate.pid < 0; });
+
+    /* Ties in PID order, so the same processes win whatever the jobs */
+    std::sort(candidates.begin(), candidates.end(), [](auto& a, auto& b) {
+        return a.bound > b.bound || (a.bound == b.bound && a.pid < b.pid);
+    });
+
+    heap.clear();
+
+    if (metric != Metric::cpu)
+        return;
+
+    times.begin_tick();
+
+    for (auto& candidate : candidates)
+        times.insert(candidate.pid, candidate.starttime).first->total_time
+            = candidate.total_time;
+
+    times.end_tick([](int, std::uint64_t, auto&) {});
+}
+
+auto Gossip::Top::offer(const Sample& sample, const Candidate& candidate)
+    -> void
+{
+    std::uint64_t value = candidate.bound;
+
+    if (metric != Metric::cpu)
+        value = column < sample.num_values ? sample.values[column] : 0;
+
+    if (heap.size() == count) {
+        if (value <= heap.front().first)
+            return;
+
+        std::pop_heap(heap.begin(), heap.end(), lighter);
+        heap.pop_back();
+    }
+
+    heap.emplace_back(value, sample);
+    std::push_heap(heap.begin(), heap.end(), lighter);
+}
+
+auto Gossip::Top::take(SampleTable& samples) -> void
+{
+    std::sort(heap.begin(), heap.end(),
+        [](auto& a, auto& b) { return a.second.pid < b.second.pid; });
+
+    samples.reset(heap.size());
+
+    for (std::size_t i = 0; i < heap.size(); i++)
+        samples[i] = std::move(heap[i].second);
+
+    heap.clear();
+}
@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Trigger - What sets off a burst of fast sampling
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Fields.hpp>
+#include <Parser.hpp>
+#include <Trigger.hpp>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+Gossip::PressureTrigger::PressureTrigger(
+    const std::filesystem::path& path, const std::string& spec)
+    : descriptor(::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC))
+    , pending(false)
+{
+    if (descriptor < 0)
+        throw std::runtime_error { "Can't open `" + path.string()
+            + "': " + std::strerror(errno) };
+
+    /* The kernel wants the terminating null too */
+    if (::write(descriptor, spec.c_str(), spec.size() + 1) < 0) {
+        auto error = errno;
+
+        ::close(descriptor);
+
+        throw std::runtime_error { "Can't set up pressure trigger `" + spec
+            + "': " + std::strerror(error) };
+    }
+}
+
+Gossip::PressureTrigger::~PressureTrigger() { ::close(descriptor); }
+
+auto Gossip::PressureTrigger::fired(const Tick&) -> bool
+{
+    auto fired = pending;
+
+    pending = false;
+
+    return fired;
+}
+
+Gossip::MemoryTrigger::MemoryTrigger(
+    const std::filesystem::path& procfs, std::uint64_t kb)
+    : meminfo_path(procfs / "meminfo")
+    , threshold(kb)
+{
+}
+
+auto Gossip::MemoryTrigger::fired(const Tick&) -> bool
+{
+    constexpr std::array<std::string_view, 1> keys { "MemAvailable" };
+    std::array<std::uint64_t, 1> values {};
+
+    auto text = Parser::read_file(meminfo_path, Parser::scratch());
+
+    /* Before 3.14 there's no telling, which is no reason to burst */
+    if (Parser::parse_meminfo(text, keys, values) == 0)
+        return false;
+
+    return values[0] < threshold;
+}
+
+Gossip::GrowthTrigger::GrowthTrigger(
+    std::span<const std::string_view> fields, std::uint64_t kb)
+    : column(0)
+    , threshold(kb)
+{
+    auto index = Fields::value_index(fields, "Rss");
+
+    if (!index)
+        throw std::invalid_argument { "Growth triggers need the Rss field" };
+
+    column = *index;
+}
+
+auto Gossip::GrowthTrigger::fired(const Tick& tick) -> bool
+{
+    bool grown = false;
+
+    table.begin_tick();
+
+    for (auto& sample : tick.samples) {
+        auto [state, known] = table.insert(sample.pid, sample.starttime);
+        auto rss = column < sample.num_values ? sample.values[column] : 0;
+
+        /* Newcomers had nothing to grow from */
+        if (known && rss >= state->rss + threshold)
+            grown = true;
+
+        state->rss = rss;
+    }
+
+    table.end_tick([](int, std::uint64_t, auto&) {});
+
+    return grown;
+}
@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Uring - Minimal io_uring submission and completion rings
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Uring.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#define GOSSIP_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#endif
+
+#ifdef GOSSIP_HAVE_IO_URING
+static_assert(sizeof(io_uring_cqe) == 16);
+
+Gossip::Uring::Uring(unsigned entries)
+    : ring_fd(-1)
+    , sq_entries(0)
+    , pending(0)
+    , sq_ring(MAP_FAILED)
+    , cq_ring(MAP_FAILED)
+    , sqes(MAP_FAILED)
+{
+    io_uring_params params;
+
+    std::memset(&params, 0, sizeof(params));
+
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+
+    if (fd < 0)
+        return;
+
+    ring_fd = fd;
+    sq_entries = params.sq_entries;
+
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size
+        = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+
+    if (single_mmap) {
+        sq_ring_size = std::max(sq_ring_size, cq_ring_size);
+        cq_ring_size = sq_ring_size;
+    }
+
+    sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+
+    if (sq_ring == MAP_FAILED) {
+        teardown();
+        return;
+    }
+
+    cq_ring = single_mmap
+        ? sq_ring
+        : mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+
+    sqes = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+
+    if (cq_ring == MAP_FAILED || sqes == MAP_FAILED) {
+        teardown();
+        return;
+    }
+
+    auto* sq = static_cast<char*>(sq_ring);
+    auto* cq = static_cast<char*>(cq_ring);
+
+    sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<Completion*>(cq + params.cq_off.cqes);
+
+    /* IORING_OP_READ only showed up in 5.6 */
+    if (!supports_read())
+        teardown();
+}
+
+Gossip::Uring::~Uring() { teardown(); }
+
+auto Gossip::Uring::read(int fd, void* buffer, std::size_t len,
+    std::uint64_t offset, std::uint64_t user_data) -> bool
+{
+    unsigned tail = *sq_tail;
+    unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+
+    if (tail - head >= sq_entries)
+        return false;
+
+    unsigned index = tail & *sq_mask;
+    auto& sqe = static_cast<io_uring_sqe*>(sqes)[index];
+
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_READ;
+    sqe.fd = fd;
+    sqe.addr = reinterpret_cast<std::uint64_t>(buffer);
+    sqe.len = static_cast<std::uint32_t>(len);
+    sqe.off = offset;
+    sqe.user_data = user_data;
+
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    pending++;
+
+    return true;
+}
+
+auto Gossip::Uring::submit(unsigned wait) -> bool
+{
+    for (;;) {
+        long ret = syscall(__NR_io_uring_enter, ring_fd, pending, wait,
+            wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+
+        if (ret < 0 && errno == EINTR)
+            continue;
+
+        if (ret < 0)
+            return false;
+
+        pending -= static_cast<unsigned>(ret);
+
+        return true;
+    }
+}
+
+auto Gossip::Uring::supports_read() -> bool
+{
+    constexpr unsigned num_ops = 256;
+
+    auto size = sizeof(io_uring_probe) + num_ops * sizeof(io_uring_probe_op);
+    auto memory = std::make_unique<char[]>(size);
+    auto* probe = reinterpret_cast<io_uring_probe*>(memory.get());
+
+    std::memset(probe, 0, size);
+
+    if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe,
+            num_ops)
+        < 0)
+        return false;
+
+    return probe->last_op >= IORING_OP_READ
+        && probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED;
+}
+
+auto Gossip::Uring::teardown() -> void
+{
+    if (sqes != MAP_FAILED)
+        munmap(sqes, sqes_size);
+
+    if (cq_ring != MAP_FAILED && cq_ring != sq_ring)
+        munmap(cq_ring, cq_ring_size);
+
+    if (sq_ring != MAP_FAILED)
+        munmap(sq_ring, sq_ring_size);
+
+    if (ring_fd >= 0)
+        ::close(ring_fd);
+
+    sq_ring = cq_ring = sqes = MAP_FAILED;
+    ring_fd = -1;
+}
+#else
+/* No io_uring on this platform, callers always take the syscall path */
+Gossip::Uring::Uring(unsigned)
+    : ring_fd(-1)
+    , sq_entries(0)
+    , pending(0)
+{
+}
+
+Gossip::Uring::~Uring() { }
+
+auto Gossip::Uring::read(
+    int, void*, std::size_t, std::uint64_t, std::uint64_t) -> bool
+{
+    return false;
+}
+
+auto Gossip::Uring::submit(unsigned) -> bool { return false; }
+
+auto Gossip::Uring::supports_read() -> bool { return false; }
+
+auto Gossip::Uring::teardown() -> void { }
+#endif
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Writer - Output formats for process samples
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#include <Writer.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+auto Gossip::Tick::now() -> Tick
+{
+    std::time_t now = std::chrono::system_clock::to_time_t(
+        std::chrono::system_clock::now());
+    std::tm tm;
+    Tick tick;
+
+    localtime_r(&now, &tm);
+
+    tick.time = now;
+    tick.utc_offset = static_cast<std::int32_t>(tm.tm_gmtoff);
+
+    return tick;
+}
+
+auto Gossip::Tick::timestamp() const -> Timestamp
+{
+    /*
+     * Only the offset is recorded, not the zone, so the local time is
+     * rebuilt from UTC. That way a binary capture converted elsewhere
+     * still shows the time of the machine it was taken on.
+     */
+    std::time_t local = time + utc_offset;
+    std::tm tm;
+
+    gmtime_r(&local, &tm);
+
+    Timestamp stamp;
+    auto* buffer = stamp.text.data();
+    auto size = stamp.text.size();
+    auto length = std::strftime(buffer, size, "%F %T", &tm);
+    auto offset = utc_offset < 0 ? -utc_offset : utc_offset;
+    auto zone = std::snprintf(buffer + length, size - length, " %c%02d%02d",
+        utc_offset < 0 ? '-' : '+', offset / 3600, offset / 60 % 60);
+
+    stamp.length = std::min(length + static_cast<std::size_t>(zone), size - 1);
+
+    return stamp;
+}
+
+Gossip::CsvWriter::CsvWriter(
+    std::ostream& output, std::span<const std::string_view> fields)
+    : output(output)
+{
+    output << "# ";
+
+    for (std::size_t i = 0; i < fields.size(); i++) {
+        output << (i ? "," : "") << fields[i];
+    }
+
+    output << std::endl;
+
+    for (auto field : fields) {
+        auto column = Column::unknown;
+
+        if (field == "PID")
+            column = Column::pid;
+        else if (field == "Comm")
+            column = Column::comm;
+        else if (Fields::is_value(field))
+            column = Column::value;
+        else if (field == "Total_Process_Time")
+            column = Column::total_time;
+        else if (field == "Fresh")
+            column = Column::fresh;
+        else if (field == "Timestamp")
+            column = Column::timestamp;
+
+        columns.push_back(column);
+    }
+
+    value_columns = static_cast<std::size_t>(
+        std::count(columns.begin(), columns.end(), Column::value));
+}
+
+auto Gossip::CsvWriter::write(const Tick& tick) -> void
+{
+    auto timestamp = tick.timestamp();
+
+    for (auto& sample : tick.samples) {
+        std::size_t value = 0;
+        std::size_t seen = 0;
+        const char* separator = "";
+
+        for (auto column : columns) {
+            if (column == Column::value) {
+                /*
+                 * Values go in order. Older kernels report fewer of them,
+                 * leaving the row short; newer ones more, which all go in
+                 * place of the last value column.
+                 */
+                auto end = ++seen == value_columns
+                    ? sample.num_values
+                    : std::min(value + 1, sample.num_values);
+
+                for (; value < end; value++) {
+                    output << separator << sample.values[value];
+                    separator = ",";
+                }
+
+                continue;
+            }
+
+            output << separator;
+            separator = ",";
+
+            switch (column) {
+            case Column::pid:
+                output << sample.pid;
+                break;
+            case Column::comm:
+                output << sample.comm;
+                break;
+            case Column::total_time:
+                output << sample.total_time;
+                break;
+            case Column::fresh:
+                output << (sample.freshness != Sample::Freshness::carried);
+                break;
+            case Column::timestamp:
+                output << timestamp;
+                break;
+            case Column::value:
+            case Column::unknown:
+                break;
+            }
+        }
+
+        output << '\n';
+    }
+
+    output.flush();
+}
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * gossip-convert - Turn binary gossip output back into CSV
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Binary.hpp>
+#include <Delta.hpp>
+#include <Writer.hpp>
+#include <argparse/argparse.hpp>
+#include <fstream>
+#include <memory>
+
+auto main(int argc, char* argv[]) -> int
+{
+    constexpr auto program_name = "gossip-convert";
+
+    argparse::ArgumentParser program(program_name, GOSSIP_VERSION);
+
+    try {
+        program.add_argument("-i", "--input")
+            .help("File written by gossip --format binary or delta")
+            .default_value(std::string("output.bin"));
+
+        program.add_argument("-o", "--output")
+            .help("Output file name")
+            .default_value(std::string("output.csv"));
+
+        program.parse_args(argc, argv);
+
+        auto input = program.get<std::string>("--input");
+        auto output = program.get<std::string>("--output");
+
+        std::ifstream input_file(input, std::ios::binary);
+
+        if (!input_file)
+            throw std::runtime_error { "Can't open `" + input + "'" };
+
+        /* Both formats start with an eight byte magic */
+        std::string magic(Gossip::Binary::magic.size(), '\0');
+
+        input_file.read(magic.data(), magic.size());
+        input_file.clear();
+        input_file.seekg(0);
+
+        std::unique_ptr<Gossip::Reader> reader;
+
+        if (magic == Gossip::Delta::magic)
+            reader = std::make_unique<Gossip::DeltaReader>(input_file);
+        else
+            reader = std::make_unique<Gossip::BinaryReader>(input_file);
+
+        std::ofstream output_file(output);
+        Gossip::CsvWriter writer { output_file, reader->fields() };
+        Gossip::Tick tick;
+
+        while (reader->next(tick))
+            writer.write(tick);
+    } catch (const std::exception& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << program << std::endl;
+        std::exit(1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * gossip-decode - Turn a gossip capture into the usual CSV
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Capture.hpp>
+#include <Replay.hpp>
+#include <Writer.hpp>
+#include <argparse/argparse.hpp>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+auto main(int argc, char* argv[]) -> int
+{
+    constexpr auto program_name = "gossip-decode";
+
+    argparse::ArgumentParser program(program_name, GOSSIP_VERSION);
+
+    try {
+        program.add_argument("-i", "--input")
+            .help("File written by gossip --capture")
+            .default_value(std::string("capture.bin"));
+
+        program.add_argument("-o", "--output")
+            .help("Output file name")
+            .default_value(std::string("output.csv"));
+
+        program.add_argument("-s", "--system-output")
+            .help("System-wide output file name, none if empty")
+            .default_value(std::string("system.csv"));
+
+        program.add_argument("--scratch")
+            .help("Directory to lay each tick's files out in, under a new "
+                  "one of their own, the temporary directory if empty")
+            .default_value(std::string(""));
+
+        program.parse_args(argc, argv);
+
+        auto input = program.get<std::string>("--input");
+        auto output = program.get<std::string>("--output");
+        auto system_output = program.get<std::string>("--system-output");
+        std::filesystem::path scratch = program.get<std::string>("--scratch");
+
+        if (scratch.empty())
+            scratch = std::filesystem::temp_directory_path();
+
+        std::ifstream input_file(input, std::ios::binary);
+
+        if (!input_file)
+            throw std::runtime_error { "Can't open `" + input + "'" };
+
+        Gossip::CaptureReader capture { input_file };
+        Gossip::Replay replay { capture, scratch };
+
+        std::ofstream output_file(output);
+        Gossip::CsvWriter writer { output_file, replay.fields() };
+        std::unique_ptr<std::ofstream> system_file;
+        Gossip::Tick tick;
+
+        if (!system_output.empty())
+            system_file = std::make_unique<std::ofstream>(system_output);
+
+        while (replay.next(tick)) {
+            writer.write(tick);
+
+            auto* system = replay.system();
+
+            if (!system || !system_file)
+                continue;
+
+            /* The same lines a live run writes */
+            if (system->changed())
+                system->write_header(*system_file, capture.bursts());
+
+            *system_file << *system << tick.start << "," << tick.end << ","
+                         << tick.skipped << ",";
+
+            if (capture.bursts())
+                *system_file << capture.burst() << ",";
+
+            *system_file << tick.timestamp() << std::endl;
+        }
+    } catch (const std::exception& err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << program << std::endl;
+        std::exit(1);
+    }
+
+    return 0;
+}
@@ -4,61 +4,479 @@
  *
  * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
  */
+#include <Binary.hpp>
 #include <Collector.hpp>
+#include <Delta.hpp>
+#include <Governor.hpp>
+#include <History.hpp>
+#include <Scheduler.hpp>
+#include <Server.hpp>
+#include <Sink.hpp>
+#include <Summary.hpp>
+#include <Writer.hpp>
 #include <argparse/argparse.hpp>
-#include <fstream>
+#include <csignal>
+#include <cstdint>
+#include <memory>
+#include <pthread.h>
+#include <string>
+#include <thread>
+#include <vector>
 
 auto main(int argc, char* argv[]) -> int
 {
     constexpr auto program_name = "gossip";
     constexpr auto default_num_samples = 10;
-    constexpr auto default_interval = 1;
+    constexpr auto default_interval = "1";
+    constexpr auto default_jobs = 1;
 
     argparse::ArgumentParser program(program_name, GOSSIP_VERSION);
 
     try {
         program.add_argument("-i", "--interval")
-            .help("Sampling interval in seconds")
-            .default_value(default_interval)
-            .scan<'i', int>();
+            .help("Sampling interval in seconds, or milliseconds with ms")
+            .default_value(std::string(default_interval));
 
         program.add_argument("-n", "--num-samples")
             .help("Stop after these many samples")
             .default_value(default_num_samples)
             .scan<'i', int>();
 
+        program.add_argument("-j", "--jobs")
+            .help("Number of threads collecting process data")
+            .default_value(default_jobs)
+            .scan<'i', int>();
+
+        program.add_argument("--io-uring")
+            .help("Batch reads through io_uring when available")
+            .default_value(false)
+            .implicit_value(true);
+
         program.add_argument("-p", "--pids")
             .help("Comma separated list of PIDs to track")
             .default_value(std::string(""));
 
+        program.add_argument("--adaptive")
+            .help("Read smaps_rollup only for processes that changed")
+            .default_value(false)
+            .implicit_value(true);
+
+        program.add_argument("--rss-threshold")
+            .help("Resident set change, in kB, that calls for a new read")
+            .default_value(256)
+            .scan<'i', int>();
+
+        program.add_argument("--cpu-threshold")
+            .help("CPU time, in milliseconds, that calls for a new read")
+            .default_value(100)
+            .scan<'i', int>();
+
+        program.add_argument("--max-age")
+            .help("Samples values may be carried over for")
+            .default_value(10)
+            .scan<'i', int>();
+
+        program.add_argument("--top")
+            .help("Only write this many of the heaviest processes, 0 for all")
+            .default_value(0)
+            .scan<'i', int>();
+
+        program.add_argument("--by")
+            .help("What --top ranks processes by: pss, rss, swap or cpu")
+            .default_value(std::string("pss"));
+
+        program.add_argument("--procfs")
+            .help("Where procfs is mounted")
+            .default_value(std::string("/proc"));
+
         program.add_argument("-o", "--output")
-            .help("Output file name")
+            .help("Output file name, no process is collected if empty")
             .default_value(std::string("output.csv"));
 
+        program.add_argument("-f", "--format")
+            .help("Output format: csv, binary or delta")
+            .default_value(std::string("csv"));
+
+        program.add_argument("--backpressure")
+            .help("When storage falls behind: block, or drop ticks")
+            .default_value(std::string("block"));
+
+        program.add_argument("--fields")
+            .help("Comma separated columns to write, all of them if empty")
+            .default_value(std::string(""));
+
+        program.add_argument("--capture")
+            .help("Archive /proc files here unparsed, for gossip-decode")
+            .default_value(std::string(""));
+
+        program.add_argument("-s", "--system-output")
+            .help("System-wide output file name, none if empty")
+            .default_value(std::string("system.csv"));
+
+        program.add_argument("--per-mapping")
+            .help("Write the memory of --pids per mapping to this file")
+            .default_value(std::string(""));
+
+        program.add_argument("--threads")
+            .help("Write the CPU time of each thread of --pids to this file")
+            .default_value(std::string(""));
+
+        program.add_argument("--rates")
+            .help("Write CPU usage and memory growth of each process to this "
+                  "file")
+            .default_value(std::string(""));
+
+        program.add_argument("--events")
+            .help("Write processes starting and exiting to this file")
+            .default_value(std::string(""));
+
+        program.add_argument("--cgroups")
+            .help("Write the memory and CPU of every cgroup to this file")
+            .default_value(std::string(""));
+
+        program.add_argument("--cgroup-root")
+            .help("Where the cgroup v2 hierarchy is mounted")
+            .default_value(std::string("/sys/fs/cgroup"));
+
+        program.add_argument("--cgroup")
+            .help("Only collect the processes in this cgroup")
+            .default_value(std::string(""));
+
+        program.add_argument("--cpu-budget")
+            .help("Back off above this percent of one CPU, 0 for no limit")
+            .default_value(0.0)
+            .scan<'g', double>();
+
+        program.add_argument("--rss-budget")
+            .help("Back off above this resident set, in kB, 0 for no limit")
+            .default_value(0)
+            .scan<'i', int>();
+
+        program.add_argument("--governor-log")
+            .help("Write every back off to this file, stderr if empty")
+            .default_value(std::string(""));
+
+        program.add_argument("--idle")
+            .help("Run at SCHED_IDLE priority")
+            .default_value(false)
+            .implicit_value(true);
+
+        program.add_argument("--pin")
+            .help("Run on this CPU alone, -1 for any")
+            .default_value(-1)
+            .scan<'i', int>();
+
+        program.add_argument("--burst-interval")
+            .help("Sample this often while a trigger fires, never if empty")
+            .default_value(std::string(""));
+
+        program.add_argument("--burst-window")
+            .help("Keep bursting this long after a trigger last fired")
+            .default_value(std::string("10s"));
+
+        program.add_argument("--burst-limit")
+            .help("Never burst longer than this, nor again as soon after")
+            .default_value(std::string("60s"));
+
+        program.add_argument("--burst-pressure")
+            .help("Burst on this memory PSI trigger, e.g. 'some 150000 "
+                  "1000000'")
+            .default_value(std::string(""));
+
+        program.add_argument("--burst-free")
+            .help("Burst while MemAvailable is below this many kB, 0 for "
+                  "never")
+            .default_value(0)
+            .scan<'i', int>();
+
+        program.add_argument("--burst-growth")
+            .help("Burst when a process's Rss grows this many kB in a tick, "
+                  "0 for never")
+            .default_value(0)
+            .scan<'i', int>();
+
+        program.add_argument("--summary")
+            .help("Write statistics of each process instead of every sample")
+            .default_value(false)
+            .implicit_value(true);
+
+        program.add_argument("--summary-interval")
+            .help("Samples between summaries, 0 to only write one at the end")
+            .default_value(0)
+            .scan<'i', int>();
+
+        program.add_argument("--daemon")
+            .help("Keep sampling, answering queries on this Unix socket")
+            .default_value(std::string(""));
+
+        program.add_argument("--history")
+            .help("Samples kept in memory in daemon mode")
+            .default_value(3600)
+            .scan<'i', int>();
+
+        program.add_argument("--self-stats")
+            .help("Write gossip's own per-phase timings to this file")
+            .default_value(std::string(""));
+
         program.parse_args(argc, argv);
 
-        auto interval = program.get<int>("--interval");
-        auto num_samples = program.get<int>("--num-samples");
-        auto pids = program.get<std::string>("--pids");
+        Gossip::Collector::Options options;
+
+        options.interval = Gossip::Scheduler::parse_interval(
+            program.get<std::string>("--interval"));
+        options.num_samples = program.get<int>("--num-samples");
+        options.jobs = program.get<int>("--jobs");
+        options.io_uring = program.get<bool>("--io-uring");
+        options.pids = program.get<std::string>("--pids");
+        options.procfs = program.get<std::string>("--procfs");
+        options.adaptive = program.get<bool>("--adaptive");
+
+        auto rss_threshold = program.get<int>("--rss-threshold");
+        auto cpu_threshold = program.get<int>("--cpu-threshold");
+        auto max_age = program.get<int>("--max-age");
+
+        if (rss_threshold < 0 || cpu_threshold < 0 || max_age < 0)
+            throw std::invalid_argument { "Thresholds can't be negative" };
+
+        options.rss_threshold_kb = static_cast<std::uint64_t>(rss_threshold);
+        options.cpu_threshold = std::chrono::milliseconds { cpu_threshold };
+        options.max_age = static_cast<unsigned>(max_age);
+
+        auto fields = program.get<std::string>("--fields");
+
+        /* Adaptive mode adds a column telling carried over rows apart */
+        options.fields = fields.empty()
+            ? Gossip::Fields::Selection::all(options.adaptive)
+            : Gossip::Fields::Selection::parse(fields);
+
+        auto top = program.get<int>("--top");
+
+        if (top < 0)
+            throw std::invalid_argument { "Top can't be negative" };
+
+        options.top = static_cast<std::size_t>(top);
+        options.by = program.get<std::string>("--by");
+
         auto output = program.get<std::string>("--output");
+        auto format = program.get<std::string>("--format");
+        auto backpressure = program.get<std::string>("--backpressure");
+        auto system_output = program.get<std::string>("--system-output");
+
+        options.system = !system_output.empty();
+        auto capture = program.get<std::string>("--capture");
+        auto self_stats = program.get<std::string>("--self-stats");
+        auto per_mapping = program.get<std::string>("--per-mapping");
+        auto per_thread = program.get<std::string>("--threads");
+        auto per_rate = program.get<std::string>("--rates");
+        auto per_event = program.get<std::string>("--events");
+        auto per_cgroup = program.get<std::string>("--cgroups");
+
+        options.cgroup_root = program.get<std::string>("--cgroup-root");
+        options.cgroup = program.get<std::string>("--cgroup");
+
+        auto cpu_budget = program.get<double>("--cpu-budget");
+        auto rss_budget = program.get<int>("--rss-budget");
+        auto governor_log = program.get<std::string>("--governor-log");
+
+        /* Written so NaN fails too */
+        if (!(cpu_budget >= 0) || rss_budget < 0)
+            throw std::invalid_argument { "Budgets can't be negative" };
+
+        options.budget.cpu = cpu_budget;
+        options.budget.rss_kb = static_cast<std::uint64_t>(rss_budget);
+
+        auto burst_interval = program.get<std::string>("--burst-interval");
+        auto burst_free = program.get<int>("--burst-free");
+        auto burst_growth = program.get<int>("--burst-growth");
+
+        if (burst_free < 0 || burst_growth < 0)
+            throw std::invalid_argument { "Burst thresholds can't be "
+                                          "negative" };
+
+        options.pressure = program.get<std::string>("--burst-pressure");
+        options.free_kb = static_cast<std::uint64_t>(burst_free);
+        options.growth_kb = static_cast<std::uint64_t>(burst_growth);
+        options.burst_window = Gossip::Scheduler::parse_interval(
+            program.get<std::string>("--burst-window"));
+        options.burst_limit = Gossip::Scheduler::parse_interval(
+            program.get<std::string>("--burst-limit"));
+
+        if (!burst_interval.empty())
+            options.burst_interval
+                = Gossip::Scheduler::parse_interval(burst_interval);
+
+        auto triggers = !options.pressure.empty() || burst_free || burst_growth;
+
+        if (burst_interval.empty() == triggers)
+            throw std::invalid_argument { "Bursts need both an interval and "
+                                          "a trigger" };
+
+        /* Inherited by every thread, so before any is created */
+        Gossip::Governor::confine(
+            program.get<bool>("--idle"), program.get<int>("--pin"));
+
+        auto daemon = program.get<std::string>("--daemon");
+        auto history_size = program.get<int>("--history");
+        auto summary_interval = program.get<int>("--summary-interval");
+
+        if (summary_interval < 0)
+            throw std::invalid_argument { "Summary interval can't be "
+                                          "negative" };
+
+        /* Neither has anything to go on without parsing */
+        if (!capture.empty()
+            && (!daemon.empty() || program.get<bool>("--summary")))
+            throw std::invalid_argument { "Captures can't be combined with "
+                                          "daemon or summary mode" };
 
-        auto seconds = std::chrono::seconds(interval);
-        std::ofstream output_file(output, std::ios::ate);
+        sigset_t signals;
 
-        output_file << "# "
-                       "Total_CPU_Time,CPU_Threads,PID,Comm,Rss,Pss,Pss_Anon,"
-                       "Pss_File,Pss_Shmem,Shared_"
-                       "Clean,Shared_Dirty,"
-                       "Private_Clean,Private_Dirty,Referenced,Anonymous,"
-                       "LazyFree,AnonHugePages,"
-                       "ShmemPmdMapped,FilePmdMapped,Shared_Hugetlb,Private_"
-                       "Hugetlb,Swap,SwapPss,"
-                       "Locked,Total_Process_Time,Timestamp"
-                    << std::endl;
+        /*
+         * A daemon runs until told to stop, and writes nothing but what
+         * it's asked to. Signals are blocked before any thread is created
+         * so that only the one waiting for them gets them.
+         */
+        if (!daemon.empty()) {
+            if (history_size <= 0)
+                throw std::invalid_argument { "History must be positive" };
 
-        Gossip::Collector collector { pids, seconds, num_samples, output_file };
+            options.num_samples = 0;
+            options.system = false;
+
+            sigemptyset(&signals);
+            sigaddset(&signals, SIGINT);
+            sigaddset(&signals, SIGTERM);
+            pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        }
+
+        Gossip::Sink::Policy policy;
+
+        if (backpressure == "block") {
+            policy = Gossip::Sink::Policy::block;
+        } else if (backpressure == "drop") {
+            policy = Gossip::Sink::Policy::drop;
+        } else {
+            throw std::invalid_argument { "Unknown backpressure policy `"
+                + backpressure + "'" };
+        }
+
+        /* Outlives the sinks, which may call back into it */
+        std::unique_ptr<Gossip::Writer> writer;
+
+        /* Every file written goes through a Sink of its own */
+        std::vector<std::unique_ptr<Gossip::Sink>> sinks;
+        std::vector<std::unique_ptr<std::ostream>> files;
+
+        /* Null, for the Collector to leave it out, if `path' is empty */
+        auto open_sink = [&sinks, &files, policy](const std::string& path)
+            -> std::ostream* {
+            if (path.empty())
+                return nullptr;
+
+            sinks.push_back(std::make_unique<Gossip::Sink>(path, policy));
+            files.push_back(std::make_unique<std::ostream>(sinks.back().get()));
+
+            return files.back().get();
+        };
+
+        /* Stands in for the output and system-wide files when left out */
+        std::ostream discard(nullptr);
+
+        auto or_discard = [&discard](std::ostream* file) -> std::ostream& {
+            return file ? *file : discard;
+        };
+
+        /*
+         * Without an output file, no process is looked at. A capture
+         * takes the place of both the output and system-wide files.
+         */
+        auto& output_file = or_discard(
+            open_sink(daemon.empty() && capture.empty() ? output : ""));
+
+        /* Null when it went to `discard' */
+        auto* output_sink = static_cast<Gossip::Sink*>(output_file.rdbuf());
+
+        options.processes = !daemon.empty() || !output.empty();
+
+        auto& system_file = or_discard(
+            open_sink(options.system && capture.empty() ? system_output : ""));
+
+        Gossip::Collector::Outputs outputs {
+            .stats = open_sink(self_stats),
+            .mapping = open_sink(per_mapping),
+            .thread = open_sink(per_thread),
+            .rate = open_sink(per_rate),
+            .event = open_sink(per_event),
+            .cgroup = open_sink(per_cgroup),
+            .governor = open_sink(governor_log),
+            .capture = open_sink(capture),
+        };
+
+        if (!outputs.governor)
+            outputs.governor = &std::cerr;
+
+        auto columns = options.fields.names();
+        std::unique_ptr<Gossip::Server> server;
+        Gossip::Summary* summary = nullptr;
+
+        if (!daemon.empty()) {
+            auto history = std::make_unique<Gossip::History>(
+                static_cast<std::size_t>(history_size));
+
+            server
+                = std::make_unique<Gossip::Server>(daemon, *history, columns);
+            writer = std::move(history);
+        } else if (program.get<bool>("--summary")) {
+            auto summaries = std::make_unique<Gossip::Summary>(output_file,
+                columns, static_cast<unsigned>(summary_interval));
+
+            summary = summaries.get();
+            writer = std::move(summaries);
+        } else if (format == "csv") {
+            writer = std::make_unique<Gossip::CsvWriter>(output_file, columns);
+        } else if (format == "binary") {
+            writer
+                = std::make_unique<Gossip::BinaryWriter>(output_file, columns);
+        } else if (format == "delta") {
+            writer
+                = std::make_unique<Gossip::DeltaWriter>(output_file, columns);
+        } else {
+            throw std::invalid_argument { "Unknown format `" + format + "'" };
+        }
+
+        if (output_sink)
+            output_sink->on_drop([&writer] { writer->restart(); });
+
+        Gossip::Collector collector { options, *writer, system_file,
+            outputs };
+
+        /* Done with `collector' by the time collect_data() returns */
+        if (server) {
+            std::thread { [&signals, &collector] {
+                int signal;
+
+                sigwait(&signals, &signal);
+                collector.stop();
+            } }.detach();
+        }
 
         collector.collect_data();
+
+        if (summary)
+            summary->finish();
+
+        server.reset();
+
+        std::uint64_t dropped = 0;
+
+        for (auto& sink : sinks) {
+            sink->close();
+            dropped += sink->dropped();
+        }
+
+        if (dropped)
+            std::cerr << "Storage couldn't keep up, dropped " << dropped
+                      << " writes" << std::endl;
     } catch (const std::exception& err) {
         std::cerr << err.what() << std::endl;
         std::cerr << program << std::endl;
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Helpers - What the test cases build samples and read CSV with
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+
+#ifndef __HELPERS_HPP
+#define __HELPERS_HPP
+
+#include <Sample.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Test {
+/* What a sample is made of, anything left out as a fresh Sample has it */
+struct Process {
+    int pid = 1;
+    std::uint64_t starttime = 0;
+
+    /* `process<pid>' if empty */
+    std::string comm;
+
+    /* In the order of the value columns being written */
+    std::vector<std::uint64_t> values;
+
+    std::uint64_t total_time = 0;
+};
+
+inline auto make_sample(const Process& process) -> Gossip::Sample
+{
+    Gossip::Sample sample;
+
+    sample.pid = process.pid;
+    sample.starttime = process.starttime;
+    sample.comm = process.comm.empty()
+        ? "process" + std::to_string(process.pid)
+        : process.comm;
+    sample.num_values = process.values.size();
+    sample.total_time = process.total_time;
+
+    std::copy(process.values.begin(), process.values.end(),
+        sample.values.begin());
+
+    return sample;
+}
+
+/* `count' values counting up from `first', for a row of every field */
+inline auto counting(std::uint64_t first, std::size_t count)
+    -> std::vector<std::uint64_t>
+{
+    std::vector<std::uint64_t> values(count);
+
+    for (std::size_t v = 0; v < count; v++)
+        values[v] = first + v;
+
+    return values;
+}
+
+inline auto lines(const std::string& text) -> std::vector<std::string>
+{
+    std::vector<std::string> result;
+    std::istringstream stream { text };
+    std::string line;
+
+    while (std::getline(stream, line))
+        result.push_back(line);
+
+    return result;
+}
+
+/* The columns of one line of CSV */
+inline auto split(const std::string& line) -> std::vector<std::string>
+{
+    std::vector<std::string> columns;
+    std::istringstream stream { line };
+    std::string column;
+
+    while (std::getline(stream, column, ','))
+        columns.push_back(column);
+
+    return columns;
+}
+
+/* Every line of `text', split into columns */
+inline auto rows(const std::string& text)
+    -> std::vector<std::vector<std::string>>
+{
+    std::vector<std::vector<std::string>> result;
+
+    for (auto& line : lines(text))
+        result.push_back(split(line));
+
+    return result;
+}
+};
+
+#endif /* __HELPERS_HPP */
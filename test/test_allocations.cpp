@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Collector.hpp>
+#include <Writer.hpp>
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <string>
+
+/*
+ * Every allocation in the test binary goes through here. Counting is all
+ * it does, the rest is up to malloc.
+ */
+namespace {
+std::atomic<std::size_t> allocations { 0 };
+
+/* Swallows whatever is written, without buffering anything */
+class Discard : public std::streambuf {
+protected:
+    auto overflow(int c) -> int override { return c; }
+
+    auto xsputn(const char*, std::streamsize count) -> std::streamsize override
+    {
+        return count;
+    }
+};
+};
+
+auto operator new(std::size_t size) -> void*
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (auto* pointer = std::malloc(size ? size : 1))
+        return pointer;
+
+    throw std::bad_alloc {};
+}
+
+auto operator delete(void* pointer) noexcept -> void { std::free(pointer); }
+
+auto operator delete(void* pointer, std::size_t) noexcept -> void
+{
+    std::free(pointer);
+}
+
+TEST_CASE("Steady state ticks don't allocate", "[Allocations]")
+{
+    const std::filesystem::path root {
+        std::filesystem::temp_directory_path() / "gossip-allocations"
+    };
+
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+
+    std::ofstream { root / "cpuinfo" } << "processor\n" << std::endl;
+    std::ofstream { root / "stat" } << "cpu  1 2 3 4 5 6 7 8 9 10\n"
+                                       "cpu0 1 2 3 4 5 6 7 8 9 10\n"
+                                    << std::endl;
+    std::ofstream { root / "loadavg" } << "0.5 0.25 2 1/99 1234" << std::endl;
+    std::ofstream { root / "meminfo" } << "MemTotal: 1000 kB" << std::endl;
+
+    /* Names past what std::string keeps inline */
+    for (int pid = 100; pid < 300; pid++) {
+        auto base = root / std::to_string(pid);
+
+        std::filesystem::create_directories(base);
+
+        std::ofstream { base / "cmdline" }
+            << "/usr/lib/a-rather-long-process-name-" << pid;
+        std::ofstream { base / "stat" }
+            << pid << " (process) S 1 1 1 0 -1 4194560 0 0 0 0 " << pid
+            << " 0 0 0 20 0 1 0 100 0 25" << std::endl;
+        std::ofstream { base / "smaps_rollup" }
+            << "56011b60e000-7ffcff7ca000 ---p 00000000 00:00 0 [rollup]\n"
+               "Rss:                   100 kB\n"
+               "Pss:                   50 kB\n"
+               "Swap:                  0 kB"
+            << std::endl;
+    }
+
+    Discard discard;
+    std::ostream output { &discard };
+    std::ostream system { &discard };
+
+    Gossip::Collector::Options options;
+
+    options.procfs = root;
+
+    SECTION("one job") { options.jobs = 1; }
+    SECTION("several jobs") { options.jobs = 4; }
+    SECTION("adaptive")
+    {
+        options.adaptive = true;
+        options.fields = Gossip::Fields::Selection::all(true);
+    }
+
+    Gossip::CsvWriter writer { output, options.fields.names() };
+    Gossip::Collector collector { options, writer, system };
+
+    /* The first ones grow everything to its working size */
+    for (int i = 0; i < 3; i++)
+        collector.collect_tick();
+
+    auto before = allocations.load();
+
+    for (int i = 0; i < 5; i++)
+        collector.collect_tick();
+
+    REQUIRE(allocations.load() - before == 0);
+
+    std::filesystem::remove_all(root);
+}
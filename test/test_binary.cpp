@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include "Helpers.hpp"
+#include <Binary.hpp>
+#include <Writer.hpp>
+#include <catch2/catch.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+auto make_samples(std::size_t count) -> std::vector<Gossip::Sample>
+{
+    std::vector<Gossip::Sample> samples;
+
+    for (std::size_t i = 0; i < count; i++) {
+        /* Older kernels report fewer smaps_rollup fields */
+        auto pid = static_cast<int>(i * 7 + 1);
+
+        samples.push_back(Test::make_sample({ .pid = pid,
+            .values = Test::counting(i << 32, i % 3 ? 20 : 17),
+            .total_time = i * 1000 }));
+    }
+
+    return samples;
+}
+};
+
+TEST_CASE("Binary output converts back to the same CSV", "[Binary]")
+{
+    std::ostringstream expected;
+    std::ostringstream binary;
+
+    Gossip::CsvWriter csv { expected };
+    Gossip::BinaryWriter writer { binary };
+
+    auto first = make_samples(10);
+    auto second = make_samples(3);
+
+    /* Both sides of UTC, and a tick where every process was skipped */
+    std::vector<Gossip::Tick> ticks {
+        { 1650000000, 3600, 5000, 9000, 0, first },
+        { 1650000001, -(5 * 3600 + 30 * 60), 1005000, 1007000, 0, second },
+        { 1650000002, 0, 3005000, 3006000, 1, {} },
+    };
+
+    for (auto& tick : ticks) {
+        csv.write(tick);
+        writer.write(tick);
+    }
+
+    std::istringstream input { binary.str() };
+    std::ostringstream output;
+
+    Gossip::BinaryReader reader { input };
+    Gossip::CsvWriter converted { output, reader.fields() };
+    Gossip::Tick tick;
+    int count = 0;
+
+    while (reader.next(tick)) {
+        auto& written = ticks[count];
+
+        REQUIRE(tick.start == written.start);
+        REQUIRE(tick.end == written.end);
+        REQUIRE(tick.skipped == written.skipped);
+
+        converted.write(tick);
+        count++;
+    }
+
+    REQUIRE(count == 3);
+    REQUIRE(output.str() == expected.str());
+
+    SECTION("timestamps keep the offset of the capture")
+    {
+        REQUIRE(ticks[0].timestamp() == "2022-04-15 06:20:00 +0100");
+        REQUIRE(ticks[1].timestamp() == "2022-04-14 23:50:01 -0530");
+    }
+
+    SECTION("truncated files are rejected")
+    {
+        auto data = binary.str();
+
+        std::istringstream truncated { data.substr(0, data.size() - 50) };
+        Gossip::BinaryReader partial { truncated };
+
+        REQUIRE(partial.next(tick));
+        REQUIRE_THROWS_AS(partial.next(tick), std::runtime_error);
+    }
+
+    SECTION("CSV is not mistaken for binary")
+    {
+        std::istringstream text { expected.str() };
+
+        REQUIRE_THROWS_AS(Gossip::BinaryReader { text }, std::runtime_error);
+    }
+}
+
+TEST_CASE("Binary output tells fresh values from carried ones", "[Binary]")
+{
+    using Freshness = Gossip::Sample::Freshness;
+
+    std::ostringstream expected;
+    std::ostringstream binary;
+
+    Gossip::CsvWriter csv { expected, Gossip::Sample::adaptive_fields };
+    Gossip::BinaryWriter writer { binary, Gossip::Sample::adaptive_fields };
+
+    auto samples = make_samples(5);
+
+    for (std::size_t i = 0; i < samples.size(); i++)
+        samples[i].freshness = i % 2 ? Freshness::carried : Freshness::fresh;
+
+    Gossip::Tick tick { 1650000000, 0, 5000, 9000, 0, samples };
+
+    csv.write(tick);
+    writer.write(tick);
+
+    std::istringstream input { binary.str() };
+    std::ostringstream output;
+
+    Gossip::BinaryReader reader { input };
+    Gossip::CsvWriter converted { output, reader.fields() };
+
+    REQUIRE(reader.next(tick));
+
+    converted.write(tick);
+
+    REQUIRE_FALSE(reader.next(tick));
+    REQUIRE(output.str() == expected.str());
+    REQUIRE(output.str().find(",1000,0,2022-04-15") != std::string::npos);
+}
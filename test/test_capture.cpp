@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Capture.hpp>
+#include <Replay.hpp>
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+constexpr std::array<std::string_view, 3> fields { "PID", "Comm", "Rss" };
+
+auto stat(int pid, std::uint64_t flags = 4194560) -> std::string
+{
+    return std::to_string(pid) + " (p" + std::to_string(pid) + ") S 1 1 1 0 -1 "
+        + std::to_string(flags) + " 0 0 0 0 5 0 0 0 20 0 1 0 100 0 25\n";
+}
+
+auto smaps_rollup(std::uint64_t rss) -> std::string
+{
+    return "56011b60e000-7ffcff7ca000 ---p 00000000 00:00 0 [rollup]\n"
+           "Rss:                   "
+        + std::to_string(rss) + " kB\n";
+}
+
+auto tick_at(std::int64_t time) -> Gossip::Tick
+{
+    Gossip::Tick tick;
+
+    tick.time = time;
+    tick.utc_offset = 3600;
+    tick.start = time * 1000;
+    tick.end = time * 1000 + 5;
+    tick.skipped = 1;
+
+    return tick;
+}
+};
+
+TEST_CASE("Capture keeps files as they were read", "[Capture]")
+{
+    using File = Gossip::Capture::File;
+
+    std::stringstream archive;
+    Gossip::CaptureWriter writer { archive, fields };
+    std::vector<std::vector<char>> blocks(2);
+
+    writer.append(blocks[1], 7, File::stat, "7 (seven) R"sv);
+    writer.append(blocks[0], 0, File::loadavg, "0.5 0.25 2 1/99 1234\n"sv);
+    writer.append(blocks[0], 3, File::smaps_rollup, ""sv);
+    writer.write(blocks, tick_at(1000));
+
+    REQUIRE(blocks[0].empty());
+    REQUIRE(blocks[1].empty());
+
+    writer.append(blocks[0], 9, File::cmdline, "sh\0-c\0"sv);
+    writer.write(blocks, tick_at(2000));
+
+    Gossip::CaptureReader reader { archive };
+    std::vector<Gossip::CaptureReader::Record> records;
+    Gossip::Tick tick;
+
+    REQUIRE(std::ranges::equal(reader.fields(), fields));
+
+    REQUIRE(reader.next(tick, records));
+    REQUIRE(tick.time == 1000);
+    REQUIRE(tick.utc_offset == 3600);
+    REQUIRE(tick.start == 1000000);
+    REQUIRE(tick.end == 1000005);
+    REQUIRE(tick.skipped == 1);
+    REQUIRE(records.size() == 3);
+    REQUIRE(records[0].pid == 0);
+    REQUIRE(records[0].file == File::loadavg);
+    REQUIRE(records[0].bytes == "0.5 0.25 2 1/99 1234\n");
+    REQUIRE(records[1].pid == 3);
+    REQUIRE(records[1].bytes.empty());
+    REQUIRE(records[2].pid == 7);
+    REQUIRE(records[2].bytes == "7 (seven) R");
+
+    REQUIRE(reader.next(tick, records));
+    REQUIRE(tick.time == 2000);
+    REQUIRE(records.size() == 1);
+    REQUIRE(records[0].bytes == "sh\0-c\0"sv);
+
+    REQUIRE_FALSE(reader.next(tick, records));
+
+    SECTION("a tick cut short is left out")
+    {
+        auto text = archive.str();
+
+        std::istringstream truncated { text.substr(0, text.size() - 10) };
+        Gossip::CaptureReader cut { truncated };
+
+        REQUIRE(cut.next(tick, records));
+        REQUIRE_FALSE(cut.next(tick, records));
+    }
+
+    SECTION("anything else is rejected")
+    {
+        std::istringstream binary { "GOSSIPBN\3\0\0\0\0\0\0\0"s };
+
+        REQUIRE_THROWS_AS(
+            Gossip::CaptureReader { binary }, std::runtime_error);
+
+        auto text = archive.str();
+
+        /* The file of the first record */
+        text[Gossip::Capture::magic.size() + 8 + 3 * 2 + 4 + 4 + 3 + 1 + 4]
+            = 99;
+
+        std::istringstream corrupt { text };
+        Gossip::CaptureReader reader { corrupt };
+
+        REQUIRE_THROWS_AS(reader.next(tick, records), std::runtime_error);
+    }
+}
+
+TEST_CASE("Capture marks the burst of every tick", "[Capture]")
+{
+    std::stringstream archive;
+    Gossip::CaptureWriter writer { archive, fields, true };
+    std::vector<std::vector<char>> blocks(1);
+
+    writer.write(blocks, tick_at(1000));
+    writer.write(blocks, tick_at(2000), "memory");
+
+    Gossip::CaptureReader reader { archive };
+    std::vector<Gossip::CaptureReader::Record> records;
+    Gossip::Tick tick;
+
+    REQUIRE(reader.bursts());
+
+    REQUIRE(reader.next(tick, records));
+    REQUIRE(reader.burst().empty());
+
+    REQUIRE(reader.next(tick, records));
+    REQUIRE(tick.skipped == 1);
+    REQUIRE(reader.burst() == "memory");
+
+    SECTION("version 1 has none")
+    {
+        std::istringstream old { "GOSSIPRC\1\0\0\0\0\0\0\0"
+                                 "\0\0\0\0\0\0\0\0\0\40\0\0\0"
+                                 "\1\0\0\0\0\0\0\0\0\0\0\0"
+                                 "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0"
+                                 "\2\0\0\0"s };
+        Gossip::CaptureReader v1 { old };
+
+        REQUIRE_FALSE(v1.bursts());
+        REQUIRE(v1.next(tick, records));
+        REQUIRE(tick.time == 1);
+        REQUIRE(tick.skipped == 2);
+        REQUIRE(v1.burst().empty());
+        REQUIRE_FALSE(v1.next(tick, records));
+    }
+}
+
+TEST_CASE("Replay parses a capture like procfs", "[Capture]")
+{
+    using File = Gossip::Capture::File;
+
+    std::stringstream archive;
+    Gossip::CaptureWriter writer { archive, fields };
+    std::vector<std::vector<char>> blocks(1);
+    auto& block = blocks[0];
+
+    writer.append(block, 9, File::stat, stat(9));
+    writer.append(block, 9, File::cmdline, "/bin/nine\0"sv);
+    writer.append(block, 9, File::smaps_rollup, smaps_rollup(900));
+    writer.append(block, 2, File::stat, stat(2, 0x00200000));
+    writer.append(block, 2, File::smaps_rollup, ""sv);
+    writer.append(block, 4, File::stat, stat(4));
+    writer.append(block, 4, File::cmdline, "four\0"sv);
+    writer.append(block, 4, File::smaps_rollup, smaps_rollup(400));
+    writer.write(blocks, tick_at(1000));
+
+    /* 9 exited, 4 is left without smaps_rollup */
+    writer.append(block, 4, File::stat, stat(4));
+    writer.append(block, 4, File::cmdline, "four\0"sv);
+    writer.write(blocks, tick_at(2000));
+
+    Gossip::CaptureReader reader { archive };
+    Gossip::Tick tick;
+    std::filesystem::path scratch;
+
+    {
+        Gossip::Replay replay { reader };
+
+        scratch = replay.path();
+        REQUIRE(std::filesystem::is_directory(scratch));
+
+        REQUIRE(replay.next(tick));
+        REQUIRE(replay.system() == nullptr);
+        REQUIRE(tick.time == 1000);
+        REQUIRE(tick.samples.size() == 2);
+        REQUIRE(tick.samples[0].pid == 4);
+        REQUIRE(tick.samples[0].comm == "four");
+        REQUIRE(tick.samples[0].num_values == 1);
+        REQUIRE(tick.samples[0].values[0] == 400);
+        REQUIRE(tick.samples[1].pid == 9);
+        REQUIRE(tick.samples[1].comm == "/bin/nine");
+        REQUIRE(tick.samples[1].values[0] == 900);
+
+        REQUIRE(replay.next(tick));
+        REQUIRE(tick.samples.empty());
+        REQUIRE_FALSE(std::filesystem::exists(scratch / "9"));
+
+        REQUIRE_FALSE(replay.next(tick));
+    }
+
+    REQUIRE_FALSE(std::filesystem::exists(scratch));
+}
+
+TEST_CASE("Replay only removes what it made", "[Capture]")
+{
+    auto parent = std::filesystem::temp_directory_path() / "gossip-scratch";
+    std::stringstream archive;
+    Gossip::CaptureWriter writer { archive, fields };
+
+    std::filesystem::remove_all(parent);
+    std::filesystem::create_directories(parent);
+    std::ofstream { parent / "keep" } << "mine" << std::endl;
+
+    {
+        Gossip::CaptureReader reader { archive };
+        Gossip::Replay first { reader, parent };
+        Gossip::Replay second { reader, parent };
+
+        REQUIRE(first.path().parent_path() == parent);
+        REQUIRE(first.path() != second.path());
+    }
+
+    REQUIRE(std::filesystem::exists(parent / "keep"));
+    REQUIRE(std::distance(std::filesystem::directory_iterator { parent },
+                std::filesystem::directory_iterator {})
+        == 1);
+
+    std::filesystem::remove_all(parent);
+
+    std::istringstream again { archive.str() };
+    Gossip::CaptureReader reader { again };
+
+    REQUIRE_THROWS_AS((Gossip::Replay { reader, parent }), std::runtime_error);
+}
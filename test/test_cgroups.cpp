@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Cgroups.hpp>
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+auto write_cgroup(const std::filesystem::path& directory,
+    std::uint64_t current, std::uint64_t usage) -> void
+{
+    std::filesystem::create_directories(directory);
+
+    std::ofstream { directory / "memory.current" } << current << std::endl;
+    std::ofstream { directory / "memory.stat" }
+        << "anon " << current / 2 << "\nfile " << current / 4
+        << "\nkernel 8192\npgfault 77\npgmajfault 3" << std::endl;
+    std::ofstream { directory / "cpu.stat" }
+        << "usage_usec " << usage << "\nuser_usec " << usage / 2
+        << "\nsystem_usec " << usage / 2
+        << "\nnr_periods 10\nnr_throttled 2\nthrottled_usec 500" << std::endl;
+    std::ofstream { directory / "memory.pressure" }
+        << "some avg10=2.50 avg60=1.00 avg300=0.50 total=1000\n"
+           "full avg10=0.25 avg60=0.10 avg300=0.05 total=100"
+        << std::endl;
+    std::ofstream { directory / "cgroup.procs" };
+}
+};
+
+TEST_CASE("Cgroups reads every cgroup in the hierarchy", "[Cgroups]")
+{
+    const std::filesystem::path root { std::filesystem::temp_directory_path()
+        / "gossip-cgroups" };
+
+    std::filesystem::remove_all(root);
+
+    /* The root has no memory.current */
+    write_cgroup(root, 0, 9000);
+    std::filesystem::remove(root / "memory.current");
+
+    write_cgroup(root / "system.slice", 4 << 20, 4000);
+    write_cgroup(root / "system.slice" / "foo.service", 2 << 20, 3000);
+    write_cgroup(root / "user.slice", 1 << 20, 1000);
+
+    std::ofstream { root / "system.slice" / "foo.service" / "cgroup.procs" }
+        << "42\n7\n300\n";
+
+    Gossip::Cgroups cgroups { root };
+
+    cgroups.extract();
+
+    auto list = cgroups.cgroups();
+
+    REQUIRE(list.size() == 4);
+    REQUIRE(list[0].path == "/");
+    REQUIRE(list[0].current == 0);
+    REQUIRE(list[0].cpu[0] == 9000);
+    REQUIRE(list[1].path == "/system.slice");
+    REQUIRE(list[2].path == "/system.slice/foo.service");
+    REQUIRE(list[3].path == "/user.slice");
+
+    auto& foo = list[2];
+
+    /* Sizes in kB, counts as they are */
+    REQUIRE(foo.current == 2048);
+    REQUIRE(foo.memory[0] == 1024);
+    REQUIRE(foo.memory[1] == 512);
+    REQUIRE(foo.memory[2] == 8);
+    REQUIRE(foo.memory[3] == 0);
+    REQUIRE(foo.memory[7] == 77);
+    REQUIRE(foo.memory[8] == 3);
+    REQUIRE(foo.cpu[0] == 3000);
+    REQUIRE(foo.cpu[3] == 2);
+    REQUIRE(foo.cpu[4] == 500);
+    REQUIRE(foo.pressure.some_avg10 == Approx(2.5));
+    REQUIRE(foo.pressure.full_total == 100);
+
+    std::ostringstream output;
+
+    Gossip::Cgroups::write_header(output);
+    cgroups.write(output, "now");
+
+    std::string header;
+    std::string line;
+    std::istringstream lines { output.str() };
+
+    std::getline(lines, header);
+
+    for (int i = 0; i < 3; i++)
+        std::getline(lines, line);
+
+    REQUIRE(header.starts_with("# Cgroup,Memory_Current,Anon,"));
+    REQUIRE(line
+        == "/system.slice/foo.service,2048,1024,512,8,0,0,0,0,77,3,3000,1500,"
+           "1500,2,500,2.50,1000,0.25,100,now");
+
+    SECTION("processes of one cgroup, in order")
+    {
+        std::vector<int> pids;
+
+        REQUIRE(cgroups.processes("/system.slice/foo.service", pids));
+        REQUIRE(pids == std::vector<int> { 7, 42, 300 });
+        REQUIRE(cgroups.processes("user.slice", pids));
+        REQUIRE(pids.empty());
+        REQUIRE_FALSE(cgroups.processes("/nowhere", pids));
+    }
+
+    SECTION("cgroups come and go")
+    {
+        std::filesystem::remove_all(root / "user.slice");
+        write_cgroup(root / "system.slice" / "bar.service", 0, 0);
+
+        cgroups.extract();
+
+        REQUIRE(cgroups.cgroups().size() == 4);
+        REQUIRE(cgroups.cgroups()[3].path == "/system.slice/foo.service");
+        REQUIRE(cgroups.cgroups()[2].path == "/system.slice/bar.service");
+    }
+
+    std::filesystem::remove_all(root);
+}
@@ -0,0 +1,915 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include "Helpers.hpp"
+#include <Collector.hpp>
+#include <Replay.hpp>
+#include <Scheduler.hpp>
+#include <Writer.hpp>
+#include <algorithm>
+#include <array>
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using Test::lines;
+
+namespace {
+auto make_procfs(std::string name) -> std::filesystem::path
+{
+    const std::filesystem::path root { std::filesystem::temp_directory_path()
+        / name };
+
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+
+    std::ofstream { root / "cpuinfo" } << "processor\n" << std::endl;
+    std::ofstream { root / "stat" } << "cpu  1 2 3 4 5 6 7 8 9 10\n"
+                                       "cpu0 1 2 3 4 5 6 7 8 9 10\n"
+                                    << std::endl;
+    std::ofstream { root / "loadavg" } << "0.5 0.25 2 1/99 1234" << std::endl;
+    std::ofstream { root / "meminfo" } << "MemTotal: 1000 kB" << std::endl;
+
+    return root;
+}
+
+/* `rss' goes to smaps_rollup in kB, `pages' to stat */
+auto write_process(const std::filesystem::path& root, int pid,
+    std::uint64_t rss, std::uint64_t utime, std::uint64_t pages) -> void
+{
+    auto base = root / std::to_string(pid);
+
+    std::filesystem::create_directories(base);
+
+    std::ofstream { base / "cmdline" } << "process" << pid;
+    std::ofstream { base / "stat" }
+        << pid << " (process" << pid << ") S 1 1 1 0 -1 4194560 0 0 0 0 "
+        << utime << " 0 0 0 20 0 1 0 100 0 " << pages << std::endl;
+    std::ofstream { base / "smaps_rollup" }
+        << "56011b60e000-7ffcff7ca000 ---p 00000000 00:00 0 [rollup]\n"
+           "Rss:                   "
+        << rss << " kB" << std::endl;
+}
+};
+
+TEST_CASE("Collector reads from any procfs root", "[Collector]")
+{
+    const std::filesystem::path root { std::filesystem::temp_directory_path()
+        / "gossip-procfs" };
+
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+
+    std::ofstream { root / "cpuinfo" } << "processor\n" << std::endl;
+    std::ofstream { root / "stat" } << "cpu  1 2 3 4 5 6 7 8 9 10\n"
+                                       "cpu0 1 2 3 4 5 6 7 8 9 10\n"
+                                    << std::endl;
+    std::ofstream { root / "loadavg" } << "0.5 0.25 2 1/99 1234" << std::endl;
+    std::ofstream { root / "meminfo" } << "MemTotal:       1000 kB" << std::endl;
+
+    for (int pid : { 7, 11 }) {
+        auto base = root / std::to_string(pid);
+
+        std::filesystem::create_directory(base);
+
+        std::ofstream { base / "cmdline" } << "process" << pid;
+        std::ofstream { base / "stat" }
+            << pid << " (process" << pid << ") S 1 1 1 0 -1 4194560 0 0 0 0 "
+            << "10 20 0 0 20 0 1 0 100 0 0" << std::endl;
+        std::ofstream { base / "smaps_rollup" }
+            << "56011b60e000-7ffcff7ca000 ---p 00000000 00:00 0 [rollup]\n"
+               "Rss:                   "
+            << pid << " kB" << std::endl;
+    }
+
+    /* A kernel thread, with nothing to report */
+    std::filesystem::create_directory(root / "2");
+    std::ofstream { root / "2" / "cmdline" };
+    std::ofstream { root / "2" / "smaps_rollup" };
+    std::ofstream { root / "2" / "stat" }
+        << "2 (kthreadd) S 0 0 0 0 -1 2129984 0 0 0 0 0 0 0 0 20 0 1 0 1 0 0"
+        << std::endl;
+
+    Gossip::Collector::Options options;
+    std::ostringstream output;
+    std::ostringstream system;
+
+    options.procfs = root;
+
+    Gossip::CsvWriter writer { output };
+    Gossip::Collector collector { options, writer, system };
+
+    collector.collect_tick();
+
+    std::istringstream lines { output.str() };
+    std::string header, first, second, rest;
+
+    std::getline(lines, header);
+    std::getline(lines, first);
+    std::getline(lines, second);
+
+    REQUIRE(first.rfind("7,process7,", 0) == 0);
+    REQUIRE(second.rfind("11,process11,", 0) == 0);
+    REQUIRE_FALSE(std::getline(lines, rest));
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Collector only reads what the fields need", "[Collector]")
+{
+    auto root = make_procfs("gossip-fields");
+
+    write_process(root, 7, 7, 10, 2);
+
+    std::ofstream { root / "7" / "smaps_rollup" }
+        << "56011b60e000-7ffcff7ca000 ---p 00000000 00:00 0 [rollup]\n"
+           "Rss:                   7 kB\n"
+           "Pss:                   5 kB\n"
+           "Swap:                  3 kB"
+        << std::endl;
+
+    Gossip::Collector::Options options;
+    std::ostringstream output;
+    std::ostringstream system;
+
+    options.procfs = root;
+    options.system = false;
+
+    SECTION("CPU time alone never touches smaps_rollup")
+    {
+        options.fields
+            = Gossip::Fields::Selection::parse("PID,Total_Process_Time");
+
+        /* Which would make the process look like a kernel thread */
+        std::filesystem::remove(root / "7" / "smaps_rollup");
+
+        Gossip::CsvWriter writer { output, options.fields.names() };
+        Gossip::Collector collector { options, writer, system };
+
+        collector.collect_tick();
+
+        REQUIRE(lines(output.str()).at(1) == "7,10");
+    }
+
+    SECTION("smaps_rollup values by name")
+    {
+        options.fields
+            = Gossip::Fields::Selection::parse("Swap,PID,Rss,Locked");
+
+        Gossip::CsvWriter writer { output, options.fields.names() };
+        Gossip::Collector collector { options, writer, system };
+
+        collector.collect_tick();
+
+        REQUIRE(lines(output.str()).at(1) == "3,7,7,0");
+    }
+
+    REQUIRE(system.str().empty());
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Collector breaks listed PIDs down per mapping", "[Collector]")
+{
+    auto root = make_procfs("gossip-mappings");
+
+    write_process(root, 7, 7, 10, 2);
+    write_process(root, 11, 11, 10, 3);
+
+    std::ofstream { root / "7" / "smaps" }
+        << "556023a1c000-556023a3d000 rw-p 00000000 00:00 0 [heap]\n"
+           "Rss:                   7 kB"
+        << std::endl;
+
+    Gossip::Collector::Options options;
+    std::ostringstream output;
+    std::ostringstream system;
+    std::ostringstream mappings;
+
+    options.procfs = root;
+    options.system = false;
+
+    SECTION("only those in --pids")
+    {
+        options.pids = "7,11";
+
+        Gossip::CsvWriter writer { output };
+        Gossip::Collector collector { options, writer, system,
+            { .mapping = &mappings } };
+
+        collector.collect_tick();
+
+        auto rows = lines(mappings.str());
+
+        /* PID 11 has no smaps to read */
+        REQUIRE(rows.size() == 2);
+        REQUIRE(rows[0].rfind("# PID,Mapping,Count,Size,Rss,", 0) == 0);
+        REQUIRE(rows[1].rfind("7,[heap],1,0,7,", 0) == 0);
+    }
+
+    SECTION("which can't be left empty")
+    {
+        Gossip::CsvWriter writer { output };
+
+        REQUIRE_THROWS_AS((Gossip::Collector { options, writer, system,
+                              { .mapping = &mappings } }),
+            std::invalid_argument);
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Adaptive mode reads smaps_rollup when stat moves", "[Collector]")
+{
+    auto root = make_procfs("gossip-adaptive");
+
+    write_process(root, 7, 100, 10, 25);
+
+    Gossip::Collector::Options options;
+    std::ostringstream output;
+    std::ostringstream system;
+
+    options.procfs = root;
+    options.adaptive = true;
+    options.rss_threshold_kb = 1024;
+    options.cpu_threshold = std::chrono::milliseconds { 1000 };
+    options.max_age = 3;
+
+    Gossip::CsvWriter writer { output, Gossip::Sample::adaptive_fields };
+    Gossip::Collector collector { options, writer, system };
+
+    /* Every value after Rss, missing from smaps_rollup, reads as zero */
+    std::string zeros;
+
+    for (std::size_t i = 1; i < options.fields.keys().size(); i++)
+        zeros += "0,";
+
+    auto tick = [&]() {
+        output.str("");
+        collector.collect_tick();
+
+        auto row = lines(output.str()).at(0);
+
+        /* Leave the timestamp out */
+        return row.substr(0, row.rfind(',') + 1);
+    };
+
+    collector.collect_tick();
+
+    REQUIRE(lines(output.str()).at(1).rfind(
+                "7,process7,100," + zeros + "10,1,", 0)
+        == 0);
+
+    /* smaps_rollup alone changing goes unnoticed */
+    write_process(root, 7, 150, 10, 25);
+
+    REQUIRE(tick() == "7,process7,100," + zeros + "10,0,");
+
+    SECTION("small changes in stat are carried over")
+    {
+        write_process(root, 7, 150, 11, 26);
+
+        REQUIRE(tick() == "7,process7,100," + zeros + "11,0,");
+    }
+
+    SECTION("resident set growing past the threshold")
+    {
+        write_process(root, 7, 2000, 10, 500);
+
+        REQUIRE(tick() == "7,process7,2000," + zeros + "10,1,");
+        REQUIRE(tick() == "7,process7,2000," + zeros + "10,0,");
+    }
+
+    SECTION("CPU time past the threshold")
+    {
+        write_process(root, 7, 150, 10 + sysconf(_SC_CLK_TCK), 25);
+
+        REQUIRE(tick().ends_with(",150," + zeros
+            + std::to_string(10 + sysconf(_SC_CLK_TCK)) + ",1,"));
+    }
+
+    SECTION("values get too old")
+    {
+        REQUIRE(tick() == "7,process7,100," + zeros + "10,0,");
+        REQUIRE(tick() == "7,process7,100," + zeros + "10,0,");
+        REQUIRE(tick() == "7,process7,150," + zeros + "10,1,");
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Collector writes the heaviest processes alone", "[Collector]")
+{
+    auto root = make_procfs("gossip-top");
+    auto page_kb = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE)) / 1024;
+
+    write_process(root, 7, 400, 10, 400 / page_kb);
+    write_process(root, 8, 800, 50, 800 / page_kb);
+    write_process(root, 9, 1200, 20, 1200 / page_kb);
+
+    /* Too small a resident set in stat to be read at all */
+    write_process(root, 10, 99999, 30, 1);
+
+    Gossip::Collector::Options options;
+    std::ostringstream output;
+    std::ostringstream system;
+
+    options.procfs = root;
+    options.system = false;
+    options.top = 2;
+    options.fields
+        = Gossip::Fields::Selection::parse("PID,Rss,Total_Process_Time");
+
+    Gossip::CsvWriter writer { output, options.fields.names() };
+
+    SECTION("by resident set, in PID order")
+    {
+        options.by = "rss";
+
+        Gossip::Collector collector { options, writer, system };
+
+        collector.collect_tick();
+
+        REQUIRE(lines(output.str())
+            == std::vector<std::string> {
+                "# PID,Rss,Total_Process_Time", "8,800,50", "9,1200,20" });
+    }
+
+    SECTION("by CPU time since the last tick")
+    {
+        options.by = "cpu";
+
+        Gossip::Collector collector { options, writer, system };
+
+        collector.collect_tick();
+
+        REQUIRE(lines(output.str()).at(1) == "8,800,50");
+        REQUIRE(lines(output.str()).at(2) == "10,99999,30");
+
+        write_process(root, 7, 400, 100, 400 / page_kb);
+        write_process(root, 9, 1200, 21, 1200 / page_kb);
+        output.str("");
+        collector.collect_tick();
+
+        REQUIRE(lines(output.str())
+            == std::vector<std::string> { "7,400,100", "9,1200,21" });
+    }
+
+    SECTION("by a value that isn't collected")
+    {
+        options.by = "swap";
+
+        REQUIRE_THROWS_AS((Gossip::Collector { options, writer, system }),
+            std::invalid_argument);
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Collector ranks by Swap with every field", "[Collector]")
+{
+    auto root = make_procfs("gossip-top-swap");
+
+    /* As 6.x kernels have it, with Pss_Dirty and KSM among the rest */
+    auto write_rollup = [&](int pid, std::uint64_t hugetlb,
+                            std::uint64_t swap) {
+        write_process(root, pid, 0, 10, 1);
+
+        std::ofstream { root / std::to_string(pid) / "stat" }
+            << pid << " (process" << pid << ") S 1 1 1 0 -1 4194560 0 0 0 0 "
+            << "10 0 0 0 20 0 1 0 100 " << 64 * 1024 * 1024 << " 1"
+            << std::endl;
+        std::ofstream { root / std::to_string(pid) / "smaps_rollup" }
+            << "56011b60e000-7ffcff7ca000 ---p 00000000 00:00 0 [rollup]\n"
+               "Rss: 1320 kB\nPss: 448 kB\nPss_Dirty: 100 kB\n"
+               "Pss_Anon: 100 kB\nPss_File: 348 kB\nPss_Shmem: 0 kB\n"
+               "Shared_Clean: 1180 kB\nShared_Dirty: 0 kB\n"
+               "Private_Clean: 40 kB\nPrivate_Dirty: 100 kB\n"
+               "Referenced: 1320 kB\nAnonymous: 100 kB\nKSM: 0 kB\n"
+               "LazyFree: 0 kB\nAnonHugePages: 0 kB\nShmemPmdMapped: 0 kB\n"
+               "FilePmdMapped: 0 kB\nShared_Hugetlb: "
+            << hugetlb << " kB\nPrivate_Hugetlb: 0 kB\nSwap: " << swap
+            << " kB\nSwapPss: 0 kB\nLocked: 0 kB" << std::endl;
+    };
+
+    write_rollup(7, 0, 5000);
+    write_rollup(8, 9000, 100);
+
+    Gossip::Collector::Options options;
+    std::ostringstream output;
+    std::ostringstream system;
+
+    options.procfs = root;
+    options.system = false;
+    options.top = 1;
+    options.by = "swap";
+
+    Gossip::CsvWriter writer { output, options.fields.names() };
+    Gossip::Collector collector { options, writer, system };
+
+    collector.collect_tick();
+
+    auto rows = lines(output.str());
+
+    REQUIRE(rows.size() == 2);
+    REQUIRE(rows[1].starts_with("7,process7,1320,448,100,348,0,1180,0,40,100,"
+                                "1320,100,0,0,0,0,0,0,5000,0,0,10,"));
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Collector reads cgroups instead of processes", "[Collector]")
+{
+    auto root = make_procfs("gossip-cgroup-procfs");
+    auto cgroup_root = std::filesystem::temp_directory_path()
+        / "gossip-cgroup-root";
+    auto service = cgroup_root / "system.slice" / "foo.service";
+
+    std::filesystem::remove_all(cgroup_root);
+    std::filesystem::create_directories(service);
+    std::ofstream { service / "memory.current" } << 1048576 << std::endl;
+    std::ofstream { service / "cgroup.procs" } << "11\n" << std::endl;
+
+    write_process(root, 7, 7, 10, 2);
+    write_process(root, 11, 11, 10, 3);
+
+    Gossip::Collector::Options options;
+    std::ostringstream output;
+    std::ostringstream system;
+    std::ostringstream cgroups;
+
+    options.procfs = root;
+    options.system = false;
+    options.cgroup_root = cgroup_root;
+    options.fields = Gossip::Fields::Selection::parse("PID,Rss");
+
+    Gossip::CsvWriter writer { output, options.fields.names() };
+
+    SECTION("no processes at all")
+    {
+        options.processes = false;
+
+        Gossip::Collector collector { options, writer, system,
+            { .cgroup = &cgroups } };
+
+        collector.collect_tick();
+
+        REQUIRE(lines(output.str()).size() == 1);
+        REQUIRE(lines(cgroups.str()).size() == 4);
+        REQUIRE(lines(cgroups.str()).at(3).starts_with(
+            "/system.slice/foo.service,1024,"));
+    }
+
+    SECTION("only the processes of one cgroup")
+    {
+        options.cgroup = "system.slice/foo.service";
+
+        Gossip::Collector collector { options, writer, system };
+
+        collector.collect_tick();
+
+        REQUIRE(lines(output.str())
+            == std::vector<std::string> { "# PID,Rss", "11,11" });
+    }
+
+    SECTION("a cgroup that isn't there")
+    {
+        options.cgroup = "system.slice/bar.service";
+
+        REQUIRE_THROWS_AS((Gossip::Collector { options, writer, system }),
+            std::invalid_argument);
+    }
+
+    std::filesystem::remove_all(cgroup_root);
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Collector backs off when over budget", "[Collector]")
+{
+    auto root = make_procfs("gossip-governed");
+
+    write_process(root, 7, 100, 10, 25);
+
+    /* gossip itself, busy with a second of CPU time every tick */
+    write_process(root, 42, 0, 0, 1);
+    std::filesystem::create_directory_symlink(root / "42", root / "self");
+
+    auto busy = [&, utime = std::uint64_t { 0 }]() mutable {
+        utime += static_cast<std::uint64_t>(sysconf(_SC_CLK_TCK));
+        write_process(root, 42, 0, utime, 1);
+    };
+
+    Gossip::Collector::Options options;
+    std::ostringstream output;
+    std::ostringstream system;
+    std::ostringstream governor;
+
+    options.procfs = root;
+    options.pids = "7";
+    options.system = false;
+    options.fields = Gossip::Fields::Selection::parse("PID,Rss");
+    options.budget.cpu = 1;
+
+    Gossip::CsvWriter writer { output, options.fields.names() };
+    Gossip::Collector collector { options, writer, system,
+        { .governor = &governor } };
+
+    /* A baseline, then five ticks to settle in */
+    for (int i = 0; i < 5; i++) {
+        busy();
+        collector.collect_tick();
+    }
+
+    REQUIRE(lines(governor.str()).size() == 1);
+
+    write_process(root, 7, 150, 10, 25);
+    busy();
+    collector.collect_tick();
+
+    REQUIRE(lines(output.str()).back() == "7,150");
+    REQUIRE(lines(governor.str()).size() == 2);
+    REQUIRE(lines(governor.str()).at(1).starts_with("1,cpu,"));
+
+    /* smaps_rollup is read once more to remember, then carried over */
+    write_process(root, 7, 200, 10, 25);
+    collector.collect_tick();
+
+    REQUIRE(lines(output.str()).back() == "7,200");
+
+    write_process(root, 7, 250, 10, 25);
+    collector.collect_tick();
+
+    REQUIRE(lines(output.str()).back() == "7,200");
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Collector turns lean when over its memory budget", "[Collector]")
+{
+    auto root = make_procfs("gossip-lean");
+
+    write_process(root, 7, 100, 10, 25);
+
+    /* gossip itself, well over a 1kB budget */
+    write_process(root, 42, 0, 0, 1024);
+    std::filesystem::create_directory_symlink(root / "42", root / "self");
+
+    Gossip::Collector::Options options;
+    std::ostringstream output;
+    std::ostringstream system;
+    std::ostringstream governor;
+
+    options.procfs = root;
+    options.pids = "7";
+    options.system = false;
+    options.fields = Gossip::Fields::Selection::parse("PID,Rss");
+    options.budget.rss_kb = 1;
+
+    Gossip::CsvWriter writer { output, options.fields.names() };
+    Gossip::Collector collector { options, writer, system,
+        { .governor = &governor } };
+
+    for (int i = 0; i < 6; i++)
+        collector.collect_tick();
+
+    REQUIRE(lines(governor.str()).size() == 2);
+    REQUIRE(lines(governor.str()).at(1).starts_with("0,rss,"));
+
+    /* Nothing is carried over nor spread out, every tick reads afresh */
+    for (std::uint64_t rss : { 200, 300 }) {
+        write_process(root, 7, rss, 10, 25);
+        collector.collect_tick();
+
+        REQUIRE(lines(output.str()).back() == "7," + std::to_string(rss));
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Collector captures what a replay decodes", "[Collector]")
+{
+    auto root = make_procfs("gossip-captured");
+
+    write_process(root, 7, 100, 10, 25);
+    write_process(root, 11, 300, 20, 75);
+
+    Gossip::Collector::Options options;
+    std::ostringstream live;
+    std::ostringstream live_system;
+    std::stringstream archive;
+
+    options.procfs = root;
+    options.jobs = 2;
+    options.fields = Gossip::Fields::Selection::parse(
+        "PID,Comm,Rss,Total_Process_Time");
+
+    Gossip::CsvWriter live_writer { live, options.fields.names() };
+    Gossip::Collector direct { options, live_writer, live_system };
+
+    std::ostringstream unused;
+    std::ostringstream unused_system;
+    Gossip::CsvWriter unused_writer { unused, options.fields.names() };
+    Gossip::Collector capturing { options, unused_writer, unused_system,
+        { .capture = &archive } };
+
+    direct.collect_tick();
+    capturing.collect_tick();
+
+    write_process(root, 11, 350, 30, 80);
+    std::filesystem::remove_all(root / "7");
+
+    direct.collect_tick();
+    capturing.collect_tick();
+
+    /* Neither gets a thing while capturing */
+    REQUIRE(lines(unused.str()).size() == 1);
+    REQUIRE(unused_system.str().empty());
+
+    Gossip::CaptureReader reader { archive };
+    Gossip::Replay replay { reader };
+    std::ostringstream decoded;
+    Gossip::CsvWriter writer { decoded, replay.fields() };
+    Gossip::Tick tick;
+    int ticks = 0;
+
+    while (replay.next(tick)) {
+        writer.write(tick);
+        ticks++;
+
+        std::ostringstream system;
+
+        REQUIRE(replay.system());
+        system << *replay.system();
+
+        /* Same as the live line, but for the times and timestamp */
+        REQUIRE(lines(live_system.str()).at(ticks)
+                    .starts_with(system.str()));
+    }
+
+    REQUIRE(ticks == 2);
+    REQUIRE(decoded.str() == live.str());
+    REQUIRE(lines(decoded.str()).size() == 4);
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Collector captures /proc/stat whole", "[Collector]")
+{
+    auto root = make_procfs("gossip-captured-stat");
+    Gossip::Collector::Options options;
+    std::ostringstream output;
+    std::ostringstream system;
+    std::stringstream archive;
+
+    /* One `intr' per interrupt: well past 64KiB on large machines */
+    std::string stat = "cpu  1 2 3 4 5 6 7 8 9 10\nintr 1";
+
+    while (stat.size() < 200 * 1024)
+        stat += " 0";
+
+    stat += "\nctxt 42\n";
+    std::ofstream { root / "stat" } << stat;
+
+    options.procfs = root;
+    options.fields = Gossip::Fields::Selection::parse("PID,Rss");
+
+    Gossip::CsvWriter writer { output, options.fields.names() };
+    Gossip::Collector collector { options, writer, system,
+        { .capture = &archive } };
+
+    collector.collect_tick();
+
+    /* Read again through the same descriptor, as it is now */
+    stat.replace(stat.find("ctxt 42"), 7, "ctxt 43");
+    std::ofstream { root / "stat" } << stat;
+
+    collector.collect_tick();
+
+    Gossip::CaptureReader reader { archive };
+    Gossip::Tick tick;
+    std::vector<Gossip::CaptureReader::Record> records;
+    int ticks = 0;
+
+    while (reader.next(tick, records)) {
+        auto found = std::find_if(records.begin(), records.end(),
+            [](const auto& record) {
+                return record.file == Gossip::Capture::File::stat;
+            });
+
+        REQUIRE(found != records.end());
+        REQUIRE(found->bytes.size() == stat.size());
+        REQUIRE(found->bytes.ends_with(ticks ? "ctxt 43\n" : "ctxt 42\n"));
+        ticks++;
+    }
+
+    REQUIRE(ticks == 2);
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Collector captures nothing it would have to parse", "[Collector]")
+{
+    auto root = make_procfs("gossip-capture-alone");
+    Gossip::Collector::Options options;
+    std::ostringstream output;
+    std::ostringstream system;
+    std::ostringstream archive;
+
+    options.procfs = root;
+    options.top = 3;
+
+    Gossip::CsvWriter writer { output, options.fields.names() };
+
+    REQUIRE_THROWS_AS((Gossip::Collector { options, writer, system,
+                          { .capture = &archive } }),
+        std::invalid_argument);
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Collector bursts while a trigger fires", "[Collector]")
+{
+    /* Fires once its pipe had something written to it */
+    class Standin : public Gossip::Trigger {
+    public:
+        explicit Standin(int fd)
+            : descriptor(fd)
+            , pending(false)
+        {
+        }
+
+        auto name() const -> std::string_view override { return "standin"; }
+        auto fd() const -> int override { return descriptor; }
+
+        auto notify() -> void override
+        {
+            char byte;
+
+            pending = ::read(descriptor, &byte, 1) == 1;
+        }
+
+        auto fired(const Gossip::Tick&) -> bool override
+        {
+            auto fired = pending;
+
+            pending = false;
+
+            return fired;
+        }
+
+    private:
+        int descriptor;
+        bool pending;
+    };
+
+    auto root = make_procfs("gossip-burst");
+
+    write_process(root, 7, 100, 10, 25);
+
+    Gossip::Collector::Options options;
+    std::ostringstream output;
+    std::ostringstream system;
+    std::array<int, 2> pipe;
+
+    REQUIRE(::pipe(pipe.data()) == 0);
+
+    options.procfs = root;
+    options.num_samples = 6;
+    options.interval = std::chrono::milliseconds { 10000 };
+    options.burst_interval = std::chrono::milliseconds { 10 };
+    options.burst_window = std::chrono::milliseconds { 1000 };
+    options.fields = Gossip::Fields::Selection::parse("PID,Rss");
+
+    Gossip::CsvWriter writer { output, options.fields.names() };
+    Gossip::Collector collector { options, writer, system };
+
+    collector.add_trigger(std::make_unique<Standin>(pipe[0]));
+
+    ssize_t written = 0;
+    std::thread fire { [&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds { 50 });
+        written = ::write(pipe[1], "x", 1);
+    } };
+
+    auto start = Gossip::Scheduler::now();
+
+    collector.collect_data();
+    fire.join();
+
+    auto elapsed = Gossip::Scheduler::now() - start;
+    auto rows = lines(system.str());
+
+    REQUIRE(written == 1);
+    REQUIRE(elapsed < 5000000000);
+    REQUIRE(rows.size() == 7);
+    REQUIRE(rows.at(0).ends_with("Skipped,Burst,Timestamp"));
+    REQUIRE(rows.at(1).find(",0,,") != std::string::npos);
+
+    for (std::size_t row = 2; row < rows.size(); row++)
+        REQUIRE(rows.at(row).find(",standin,") != std::string::npos);
+
+    REQUIRE(collector.burst() == "standin");
+
+    ::close(pipe[0]);
+    ::close(pipe[1]);
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Collector cuts bursts short that never end", "[Collector]")
+{
+    /* Like MemAvailable staying low */
+    class Always : public Gossip::Trigger {
+    public:
+        auto name() const -> std::string_view override { return "always"; }
+        auto fired(const Gossip::Tick&) -> bool override { return true; }
+    };
+
+    auto root = make_procfs("gossip-burst-limit");
+
+    Gossip::Collector::Options options;
+    std::ostringstream output;
+    std::ostringstream system;
+
+    options.procfs = root;
+    options.burst_interval = std::chrono::milliseconds { 10 };
+    options.burst_window = std::chrono::milliseconds { 10000 };
+    options.burst_limit = std::chrono::milliseconds { 200 };
+    options.fields = Gossip::Fields::Selection::parse("PID,Rss");
+
+    Gossip::CsvWriter writer { output, options.fields.names() };
+    Gossip::Collector collector { options, writer, system };
+
+    collector.add_trigger(std::make_unique<Always>());
+
+    auto start = Gossip::Scheduler::now();
+    auto since = [start] {
+        return std::chrono::nanoseconds { Gossip::Scheduler::now() - start };
+    };
+
+    collector.collect_tick();
+    REQUIRE(collector.burst() == "always");
+
+    /* Firing all along doesn't keep it going past the limit */
+    std::this_thread::sleep_for(std::chrono::milliseconds { 250 });
+    collector.collect_tick();
+    REQUIRE(collector.burst().empty());
+
+    /* Nor does it start over while resting */
+    collector.collect_tick();
+
+    if (since() < std::chrono::milliseconds { 450 })
+        REQUIRE(collector.burst().empty());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds { 250 });
+    collector.collect_tick();
+    REQUIRE(collector.burst() == "always");
+
+    options.burst_limit = std::chrono::milliseconds { 0 };
+
+    REQUIRE_THROWS_AS((Gossip::Collector { options, writer, system }),
+        std::invalid_argument);
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Collector only bursts where bursts are marked", "[Collector]")
+{
+    auto root = make_procfs("gossip-burst-marked");
+
+    Gossip::Collector::Options options;
+    std::ostringstream output;
+    std::ostringstream system;
+    std::stringstream archive;
+
+    options.procfs = root;
+    options.burst_interval = std::chrono::milliseconds { 10 };
+    options.free_kb = 1;
+
+    Gossip::CsvWriter writer { output, options.fields.names() };
+
+    options.system = false;
+
+    REQUIRE_THROWS_AS((Gossip::Collector { options, writer, system }),
+        std::invalid_argument);
+
+    /* Captures carry them along, but have no samples to grow */
+    REQUIRE_NOTHROW((Gossip::Collector { options, writer, system,
+                        { .capture = &archive } }));
+
+    options.growth_kb = 1024;
+
+    REQUIRE_THROWS_AS((Gossip::Collector { options, writer, system,
+                          { .capture = &archive } }),
+        std::invalid_argument);
+
+    std::filesystem::remove_all(root);
+}
@@ -9,6 +9,7 @@
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <string>
 
 TEST_CASE("CPU can extract its data", "[Cpu]")
 {
@@ -131,5 +132,80 @@ TEST_CASE("CPU can extract its data", "[Cpu]")
         REQUIRE(output.str() == expected.str());
     }
 
+    SECTION("per-CPU lines are extracted and cpuinfo is only read once")
+    {
+        const std::filesystem::path cpuinfo { proc / "cpuinfo" };
+        const std::filesystem::path stat { proc / "stat" };
+
+        std::ofstream cpuinfo_stream { cpuinfo };
+        std::ofstream stat_stream { stat };
+
+        cpuinfo_stream << "processor\nprocessor\n" << std::endl;
+        stat_stream << "cpu  2 4 6 8 10\ncpu0 1 2 3 4 5\ncpu1 1 2 3 4 5\n"
+                       "intr 12345 0 0"
+                    << std::endl;
+
+        Gossip::Cpu cpu { procdir };
+        std::ostringstream output {};
+
+        cpu.extract();
+
+        REQUIRE(cpu.changed());
+        REQUIRE(cpu.online().size() == 2);
+        REQUIRE(cpu.online()[1].id == 1);
+        REQUIRE(cpu.online()[1].total_time == 15);
+        REQUIRE(cpu.online()[1].idle_time == 9);
+
+        /* Not re-read unless CPUs come or go */
+        std::ofstream { cpuinfo } << "processor\n" << std::endl;
+
+        cpu.extract();
+        output << cpu;
+
+        REQUIRE_FALSE(cpu.changed());
+        REQUIRE(output.str() == "30,2,");
+
+        /* cpu1 went offline */
+        std::ofstream { stat } << "cpu  2 4 6 8 10\ncpu0 1 2 3 4 5\n"
+                               << std::endl;
+
+        output.str("");
+        cpu.extract();
+        output << cpu;
+
+        REQUIRE(cpu.changed());
+        REQUIRE(cpu.online().size() == 1);
+        REQUIRE(output.str() == "30,1,");
+    }
+
+    SECTION("every CPU is seen however long /proc/stat gets")
+    {
+        const std::filesystem::path cpuinfo { proc / "cpuinfo" };
+        const std::filesystem::path stat { proc / "stat" };
+
+        constexpr int num_cpus = 4096;
+        std::string lines = "cpu  1 2 3 4 5 6 7 8 9 10\n";
+
+        for (int id = 0; id < num_cpus; id++)
+            lines += "cpu" + std::to_string(id) + " 1 2 3 4 5 6 7 8 9 10\n";
+
+        /* Past what one read of the initial buffer takes in */
+        REQUIRE(lines.size() > 65536);
+
+        std::ofstream { cpuinfo } << "processor\n" << std::endl;
+        std::ofstream { stat } << lines << "intr 12345 0 0" << std::endl;
+
+        Gossip::Cpu cpu { procdir };
+
+        cpu.extract();
+
+        REQUIRE(cpu.online().size() == num_cpus);
+        REQUIRE(cpu.online().back().id == num_cpus - 1);
+
+        cpu.extract();
+
+        REQUIRE_FALSE(cpu.changed());
+    }
+
     std::filesystem::remove_all("proc");
 }
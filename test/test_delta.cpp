@@ -0,0 +1,192 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include "Helpers.hpp"
+#include <Binary.hpp>
+#include <Delta.hpp>
+#include <Writer.hpp>
+#include <catch2/catch.hpp>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+/* A row of every field */
+auto make_sample(int pid, std::string comm) -> Gossip::Sample
+{
+    return Test::make_sample({ .pid = pid,
+        .comm = std::move(comm),
+        .values = Test::counting(static_cast<std::uint64_t>(pid) * 100, 20),
+        .total_time = 100 });
+}
+
+/* Ten ticks in which processes come and go, change or stay the same */
+auto make_ticks() -> std::vector<std::vector<Gossip::Sample>>
+{
+    std::vector<std::vector<Gossip::Sample>> ticks;
+    std::vector<Gossip::Sample> samples { make_sample(1, "init"),
+        make_sample(42, "shell"), make_sample(100, "daemon") };
+
+    for (int i = 0; i < 10; i++) {
+        samples[0].total_time += 3;
+        samples[1].values[0] += i;
+
+        /* Memory going down gives negative deltas */
+        samples[2].values[1] -= i;
+
+        if (i == 3)
+            samples.push_back(make_sample(200, "worker"));
+
+        /* The worker exits and its PID is reused */
+        if (i == 5)
+            samples[3] = make_sample(200, "other");
+
+        /* Older kernels report fewer smaps_rollup fields */
+        if (i == 6)
+            samples[3].num_values = 17;
+
+        if (i == 7)
+            samples[1].values[4] = std::numeric_limits<std::uint64_t>::max();
+
+        if (i == 8)
+            samples.erase(samples.begin() + 1);
+
+        ticks.push_back(samples);
+    }
+
+    return ticks;
+}
+};
+
+TEST_CASE("Delta output converts back to the same CSV", "[Delta]")
+{
+    auto samples = make_ticks();
+
+    std::ostringstream expected;
+    std::ostringstream delta;
+    std::ostringstream binary;
+
+    Gossip::CsvWriter csv { expected };
+    Gossip::DeltaWriter writer { delta, Gossip::Sample::fields, 4 };
+    Gossip::BinaryWriter columns { binary };
+
+    for (std::size_t i = 0; i < samples.size(); i++) {
+        auto start = static_cast<std::int64_t>(i) * 1000000000 + 123456;
+
+        /* Tick 6 ran late, so tick 7 comes after a skipped deadline */
+        Gossip::Tick tick { 1650000000 + static_cast<std::int64_t>(i), 3600,
+            start, start + (i == 6 ? 1500000000 : 4000000),
+            i == 7 ? 1u : 0u, samples[i] };
+
+        csv.write(tick);
+        writer.write(tick);
+        columns.write(tick);
+    }
+
+    std::istringstream input { delta.str() };
+    std::ostringstream output;
+
+    Gossip::DeltaReader reader { input };
+    Gossip::CsvWriter converted { output, reader.fields() };
+    Gossip::Tick tick;
+
+    for (int i = 0; reader.next(tick); i++) {
+        REQUIRE(tick.skipped == (i == 7 ? 1 : 0));
+        REQUIRE(tick.end - tick.start == (i == 6 ? 1500000000 : 4000000));
+
+        converted.write(tick);
+    }
+
+    REQUIRE(output.str() == expected.str());
+
+    SECTION("unchanged fields take no space")
+    {
+        REQUIRE(delta.str().size() * 4 < binary.str().size());
+    }
+
+    SECTION("readers can seek to keyframes")
+    {
+        std::istringstream input { delta.str() };
+        Gossip::DeltaReader reader { input };
+
+        /* Keyframes are ticks 0, 4 and 8 */
+        REQUIRE(reader.seek(1650000001));
+        REQUIRE(reader.next(tick));
+        REQUIRE(tick.time == 1650000004);
+        REQUIRE(tick.samples.size() == 4);
+        REQUIRE(tick.samples[3].comm == "worker");
+
+        REQUIRE(reader.next(tick));
+        REQUIRE(tick.time == 1650000005);
+        REQUIRE(tick.start == 5000123456);
+        REQUIRE(tick.end == 5004123456);
+
+        REQUIRE(reader.seek(1650000008));
+        REQUIRE(reader.next(tick));
+        REQUIRE(tick.time == 1650000008);
+        REQUIRE(tick.samples.size() == 3);
+        REQUIRE(tick.start == 8000123456);
+
+        REQUIRE_FALSE(reader.seek(1650000009));
+    }
+
+    SECTION("truncated files are rejected")
+    {
+        auto data = delta.str();
+
+        std::istringstream truncated { data.substr(0, data.size() - 1) };
+        Gossip::DeltaReader partial { truncated };
+
+        REQUIRE_THROWS_AS(
+            [&] {
+                while (partial.next(tick))
+                    ;
+            }(),
+            std::runtime_error);
+    }
+}
+
+TEST_CASE("Delta output tells fresh values from carried ones", "[Delta]")
+{
+    using Freshness = Gossip::Sample::Freshness;
+
+    std::ostringstream expected;
+    std::ostringstream delta;
+
+    Gossip::CsvWriter csv { expected, Gossip::Sample::adaptive_fields };
+    Gossip::DeltaWriter writer { delta, Gossip::Sample::adaptive_fields, 3 };
+
+    std::vector<Gossip::Sample> samples { make_sample(1, "init"),
+        make_sample(42, "shell") };
+
+    for (int i = 0; i < 7; i++) {
+        /* Values only change when they are read again */
+        samples[0].freshness = i % 2 ? Freshness::carried : Freshness::fresh;
+        samples[1].freshness = i == 4 ? Freshness::fresh : Freshness::carried;
+
+        if (i == 4)
+            samples[1].values[0] += 4096;
+
+        Gossip::Tick tick { 1650000000 + i, 0, i, i + 1, 0, samples };
+
+        csv.write(tick);
+        writer.write(tick);
+    }
+
+    std::istringstream input { delta.str() };
+    std::ostringstream output;
+
+    Gossip::DeltaReader reader { input };
+    Gossip::CsvWriter converted { output, reader.fields() };
+    Gossip::Tick tick;
+
+    while (reader.next(tick))
+        converted.write(tick);
+
+    REQUIRE(output.str() == expected.str());
+    REQUIRE(output.str().find(",Fresh,") != std::string::npos);
+}
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Fields.hpp>
+#include <Sample.hpp>
+#include <catch2/catch.hpp>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+using Gossip::Fields::Selection;
+using Gossip::Fields::Source;
+
+namespace {
+auto to_vector(std::span<const std::string_view> names)
+    -> std::vector<std::string_view>
+{
+    return { names.begin(), names.end() };
+}
+};
+
+TEST_CASE("Field selection defaults to every column", "[Fields]")
+{
+    auto selection = Selection::all();
+
+    REQUIRE(to_vector(selection.names()) == to_vector(Gossip::Sample::fields));
+    REQUIRE(selection.keys().size() == 20);
+    REQUIRE(selection.keys().front() == "Rss");
+    REQUIRE(selection.keys().back() == "Locked");
+    REQUIRE(selection.index_of("Swap") == 17);
+    REQUIRE(selection.needs(Source::stat));
+    REQUIRE(selection.needs(Source::cmdline));
+    REQUIRE(selection.needs(Source::smaps_rollup));
+
+    SECTION("adaptive mode adds Fresh")
+    {
+        auto adaptive = Selection::all(true);
+
+        REQUIRE(to_vector(adaptive.names())
+            == to_vector(Gossip::Sample::adaptive_fields));
+    }
+}
+
+TEST_CASE("Field selection reads only what it needs", "[Fields]")
+{
+    SECTION("CPU time alone")
+    {
+        auto selection = Selection::parse("PID,Total_Process_Time,Timestamp");
+
+        REQUIRE(selection.names().size() == 3);
+        REQUIRE(selection.needs(Source::stat));
+        REQUIRE_FALSE(selection.needs(Source::cmdline));
+        REQUIRE_FALSE(selection.needs(Source::smaps_rollup));
+    }
+
+    SECTION("some smaps_rollup values, in the order given")
+    {
+        auto selection = Selection::parse("Swap,PID,Rss,Pss");
+
+        REQUIRE(to_vector(selection.names())
+            == std::vector<std::string_view> { "Swap", "PID", "Rss", "Pss" });
+        REQUIRE(to_vector(selection.keys())
+            == std::vector<std::string_view> { "Swap", "Rss", "Pss" });
+        REQUIRE(selection.index_of("Pss") == 2);
+        REQUIRE_FALSE(selection.index_of("PID"));
+        REQUIRE_FALSE(selection.index_of("Locked"));
+        REQUIRE_FALSE(selection.needs(Source::cmdline));
+        REQUIRE(selection.needs(Source::smaps_rollup));
+    }
+
+    SECTION("unknown and repeated fields are rejected")
+    {
+        REQUIRE_THROWS_AS(Selection::parse("PID,Bogus"), std::invalid_argument);
+        REQUIRE_THROWS_AS(Selection::parse("Rss,Rss"), std::invalid_argument);
+        REQUIRE_THROWS_AS(Selection::parse(""), std::invalid_argument);
+    }
+}
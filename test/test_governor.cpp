@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Governor.hpp>
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sched.h>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+constexpr std::int64_t second = 1000000000;
+
+/* `utime' in clock ticks, `pages' resident */
+auto write_self(const std::filesystem::path& root, std::uint64_t utime,
+    std::int64_t pages) -> void
+{
+    std::filesystem::create_directories(root / "self");
+
+    std::ofstream { root / "self" / "stat" }
+        << "42 (gossip) S 1 1 1 0 -1 4194560 0 0 0 0 " << utime
+        << " 0 0 0 20 0 1 0 100 0 " << pages << std::endl;
+}
+};
+
+TEST_CASE("Governor backs off while over budget", "[Governor]")
+{
+    const std::filesystem::path root { std::filesystem::temp_directory_path()
+        / "gossip-governor" };
+    auto clock_ticks = static_cast<std::uint64_t>(sysconf(_SC_CLK_TCK));
+    auto page_kb = sysconf(_SC_PAGESIZE) / 1024;
+
+    std::filesystem::remove_all(root);
+    write_self(root, 0, 1);
+
+    Gossip::Process::Staleness staleness { 64, 10, 10 };
+    Gossip::Governor::Budget budget;
+    std::uint64_t utime = 0;
+    std::int64_t now = 0;
+
+    budget.cpu = 2;
+
+    Gossip::Governor governor { root, budget, staleness };
+
+    /* One tick, `percent' of a CPU busy; returns whether the level changed */
+    auto tick = [&](std::uint64_t percent) {
+        now += second;
+        utime += percent * clock_ticks / 100;
+        write_self(root, utime, 1);
+
+        return governor.update(now);
+    };
+
+    REQUIRE(governor.level() == 0);
+    REQUIRE(governor.stretch() == 1);
+    REQUIRE(governor.staleness() == nullptr);
+
+    /* The first update only sets a baseline */
+    REQUIRE_FALSE(governor.update(now));
+
+    SECTION("one level at a time, letting each settle in")
+    {
+        for (int i = 0; i < 4; i++)
+            REQUIRE_FALSE(tick(10));
+
+        REQUIRE(tick(10));
+        REQUIRE(governor.level() == 1);
+        REQUIRE(governor.stretch() == 1);
+        REQUIRE(governor.staleness() != nullptr);
+        REQUIRE(governor.staleness()->rss == 256);
+        REQUIRE(governor.staleness()->cpu == 40);
+        REQUIRE(governor.staleness()->max_age == 40);
+
+        std::ostringstream output;
+
+        output << 0.125 << ",";
+        Gossip::Governor::write_header(output);
+        governor.write(output, "now");
+        output << 0.125;
+
+        /* Formatting is left as it was found */
+        REQUIRE(output.str()
+            == "0.125,# Level,Reason,Cpu_Percent,Rss,Stretch,Lean,Timestamp\n"
+               "1,cpu,10.00,"
+                + std::to_string(page_kb) + ",1,0,now\n0.125");
+
+        for (int i = 0; i < 30; i++)
+            tick(10);
+
+        REQUIRE(governor.level() == Gossip::Governor::max_level);
+        REQUIRE(governor.stretch() == 8);
+    }
+
+    SECTION("back down once well below budget")
+    {
+        for (int i = 0; i < 10; i++)
+            tick(10);
+
+        REQUIRE(governor.level() == 2);
+        REQUIRE(governor.stretch() == 2);
+
+        /* Below budget, but not by enough to come back down */
+        for (int i = 0; i < 20; i++)
+            tick(1);
+
+        auto level = governor.level();
+
+        REQUIRE(level > 0);
+
+        for (int i = 0; i < 50; i++)
+            REQUIRE_FALSE(tick(1));
+
+        for (int i = 0; i < 50; i++)
+            tick(0);
+
+        REQUIRE(governor.level() == 0);
+    }
+
+    SECTION("resident set")
+    {
+        budget.cpu = 0;
+        budget.rss_kb = 100 * page_kb;
+
+        Gossip::Governor rss { root, budget, staleness };
+
+        /* Returns whether the governor changed its mind */
+        auto update = [&](std::int64_t pages) {
+            now += second;
+            write_self(root, utime, pages);
+
+            return rss.update(now);
+        };
+
+        update(101);
+
+        for (int i = 1; i <= 5; i++)
+            REQUIRE(update(101) == (i == 5));
+
+        /* Spreading ticks out wouldn't lower it, giving memory back does */
+        REQUIRE(rss.lean());
+        REQUIRE(rss.level() == 0);
+        REQUIRE(rss.stretch() == 1);
+
+        /* Under budget, but not by enough to stay there without trimming */
+        for (int i = 0; i < 20; i++)
+            REQUIRE_FALSE(update(80));
+
+        REQUIRE(rss.lean());
+
+        REQUIRE(update(70));
+        REQUIRE_FALSE(rss.lean());
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Governor confines gossip", "[Governor]")
+{
+    REQUIRE_NOTHROW(Gossip::Governor::confine(false, -1));
+    REQUIRE_THROWS_AS(Gossip::Governor::confine(false, CPU_SETSIZE),
+        std::invalid_argument);
+}
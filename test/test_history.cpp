@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include "Helpers.hpp"
+#include <History.hpp>
+#include <Writer.hpp>
+#include <catch2/catch.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+auto make_samples(std::size_t count, std::uint64_t tick)
+    -> std::vector<Gossip::Sample>
+{
+    std::vector<Gossip::Sample> samples;
+
+    for (std::size_t i = 0; i < count; i++) {
+        auto pid = static_cast<int>(i * 7 + 1);
+
+        samples.push_back(Test::make_sample({ .pid = pid,
+            .values = Test::counting((tick << 32) + (i << 8), i % 3 ? 20 : 17),
+            .total_time = tick * 100 + i }));
+    }
+
+    return samples;
+}
+};
+
+TEST_CASE("History replays the ticks it keeps", "[History]")
+{
+    Gossip::History history { 3 };
+    std::vector<std::vector<Gossip::Sample>> samples;
+    std::vector<Gossip::Tick> ticks;
+
+    for (std::uint64_t i = 0; i < 5; i++)
+        samples.push_back(make_samples(i == 2 ? 0 : 10 - i, i));
+
+    for (std::uint64_t i = 0; i < 5; i++) {
+        auto time = static_cast<std::int64_t>(1650000000 + 60 * i);
+
+        ticks.push_back({ time, 3600, 0, 0, 0, samples[i] });
+        history.write(ticks.back());
+    }
+
+    REQUIRE(history.written() == 5);
+
+    SECTION("one tick at a time")
+    {
+        for (std::uint64_t i = 0; i < 5; i++) {
+            std::ostringstream expected;
+            std::ostringstream replayed;
+
+            Gossip::CsvWriter csv { expected };
+            Gossip::CsvWriter writer { replayed };
+
+            /* Only the last three are still kept */
+            REQUIRE(history.replay(i, writer) == (i >= 2));
+
+            if (i >= 2)
+                csv.write(ticks[i]);
+
+            REQUIRE(replayed.str() == expected.str());
+        }
+
+        std::ostringstream output;
+        Gossip::CsvWriter writer { output };
+
+        REQUIRE_FALSE(history.replay(5, writer));
+    }
+
+    SECTION("one process over time")
+    {
+        std::ostringstream expected;
+        std::ostringstream replayed;
+
+        Gossip::CsvWriter csv { expected };
+        Gossip::CsvWriter writer { replayed };
+
+        /* Tick 2 had no processes at all */
+        for (std::uint64_t i = 3; i < 5; i++) {
+            auto tick = ticks[i];
+
+            tick.samples = tick.samples.subspan(1, 1);
+            csv.write(tick);
+        }
+
+        REQUIRE(history.replay(8, 0, writer) == 2);
+        REQUIRE(replayed.str() == expected.str());
+    }
+
+    SECTION("only the last few seconds")
+    {
+        std::ostringstream output;
+        Gossip::CsvWriter writer { output };
+
+        REQUIRE(history.replay(8, 59, writer) == 1);
+        REQUIRE(history.replay(8, 60, writer) == 2);
+        REQUIRE(history.replay(57, 0, writer) == 0);
+    }
+
+    SECTION("listed")
+    {
+        std::ostringstream output;
+
+        history.list(output);
+
+        REQUIRE(output.str()
+            == "# Tick,Processes,Timestamp\n"
+               "2,0,2022-04-15 06:22:00 +0100\n"
+               "3,7,2022-04-15 06:23:00 +0100\n"
+               "4,6,2022-04-15 06:24:00 +0100\n");
+    }
+}
+
+TEST_CASE("History keeps at least one tick", "[History]")
+{
+    REQUIRE_THROWS_AS(Gossip::History { 0 }, std::invalid_argument);
+}
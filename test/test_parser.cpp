@@ -0,0 +1,220 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Parser.hpp>
+#include <array>
+#include <catch2/catch.hpp>
+#include <string_view>
+
+using namespace std::literals;
+
+TEST_CASE("Parser extracts smaps_rollup values", "[Parser]")
+{
+    std::array<std::uint64_t, 4> values {};
+
+    SECTION("header line is skipped")
+    {
+        auto text = "56011b60e000-7ffcff7ca000 ---p 00000000 00:00 0 [rollup]\n"
+                    "Rss:                 400352 kB\n"
+                    "Pss:                 361496 kB\n"
+                    "Pss_Anon:                 0 kB\n"sv;
+
+        REQUIRE(Gossip::Parser::parse_smaps_rollup(text, values) == 3);
+        REQUIRE(values[0] == 400352);
+        REQUIRE(values[1] == 361496);
+        REQUIRE(values[2] == 0);
+    }
+
+    SECTION("extra values are dropped")
+    {
+        auto text = "header\n1\n2\n3\n4\n5\n6"sv;
+
+        REQUIRE(Gossip::Parser::parse_smaps_rollup(text, values) == 4);
+        REQUIRE(values[3] == 4);
+    }
+
+    SECTION("empty body yields no values")
+    {
+        REQUIRE(Gossip::Parser::parse_smaps_rollup(""sv, values) == 0);
+        REQUIRE(Gossip::Parser::parse_smaps_rollup("header\n"sv, values) == 0);
+    }
+
+    SECTION("only the keys asked for")
+    {
+        auto text = "56011b60e000-7ffcff7ca000 ---p 00000000 00:00 0 [rollup]\n"
+                    "Rss:                 400352 kB\n"
+                    "Pss:                 361496 kB\n"
+                    "Swap:                    12 kB\n"
+                    "SwapPss:                  7 kB\n"sv;
+        std::array<std::string_view, 3> keys { "Swap", "Rss", "Locked" };
+
+        REQUIRE(Gossip::Parser::parse_smaps_rollup(text, keys, values) == 2);
+        REQUIRE(values[0] == 12);
+        REQUIRE(values[1] == 400352);
+        REQUIRE(values[2] == 0);
+    }
+}
+
+TEST_CASE("Parser extracts stat fields", "[Parser]")
+{
+    Gossip::Parser::Stat stat;
+
+    SECTION("regular comm")
+    {
+        auto text = "1234 (bash) S 1 1234 1234 34816 1234 4194560 100 0 0 0 "
+                    "17 42 0 0 20 0 3 0 98765 8192000 512 18446744073709551615"
+                    "\n"sv;
+
+        REQUIRE(Gossip::Parser::parse_stat(text, stat));
+        REQUIRE(stat.pid == 1234);
+        REQUIRE(stat.comm == "bash");
+        REQUIRE(stat.state == 'S');
+        REQUIRE(stat.ppid == 1);
+        REQUIRE(stat.flags == 4194560);
+        REQUIRE(stat.utime == 17);
+        REQUIRE(stat.stime == 42);
+        REQUIRE(stat.num_threads == 3);
+        REQUIRE(stat.starttime == 98765);
+        REQUIRE(stat.vsize == 8192000);
+        REQUIRE(stat.rss == 512);
+    }
+
+    SECTION("comm with spaces and parentheses")
+    {
+        auto text = "77 (Web (Content) 1) R 5 77 77 0 -1 64 0 0 0 0 "
+                    "300 200 0 0 20 0 12 0 4242 0 0\n"sv;
+
+        REQUIRE(Gossip::Parser::parse_stat(text, stat));
+        REQUIRE(stat.pid == 77);
+        REQUIRE(stat.comm == "Web (Content) 1");
+        REQUIRE(stat.state == 'R');
+        REQUIRE(stat.utime == 300);
+        REQUIRE(stat.stime == 200);
+        REQUIRE(stat.num_threads == 12);
+        REQUIRE(stat.starttime == 4242);
+    }
+
+    SECTION("truncated stat is rejected")
+    {
+        REQUIRE_FALSE(Gossip::Parser::parse_stat(""sv, stat));
+        REQUIRE_FALSE(Gossip::Parser::parse_stat("1 (init"sv, stat));
+        REQUIRE_FALSE(
+            Gossip::Parser::parse_stat("1 (init) S 0 1 1 0 -1 0\n"sv, stat));
+    }
+}
+
+TEST_CASE("Parser extracts statm fields", "[Parser]")
+{
+    Gossip::Parser::Statm statm;
+
+    REQUIRE(Gossip::Parser::parse_statm("5000 1200 300 40 0 900 0\n"sv, statm));
+    REQUIRE(statm.size == 5000);
+    REQUIRE(statm.resident == 1200);
+    REQUIRE(statm.shared == 300);
+    REQUIRE(statm.text == 40);
+    REQUIRE(statm.data == 900);
+
+    REQUIRE_FALSE(Gossip::Parser::parse_statm("5000 1200"sv, statm));
+}
+
+TEST_CASE("Parser extracts process name from cmdline", "[Parser]")
+{
+    REQUIRE(Gossip::Parser::parse_cmdline("/usr/bin/foo\0--bar\0"sv)
+        == "/usr/bin/foo");
+    REQUIRE(Gossip::Parser::parse_cmdline("foo: worker process\0\0"sv)
+        == "foo:");
+    REQUIRE(Gossip::Parser::parse_cmdline(""sv).empty());
+}
+
+TEST_CASE("Parser extracts cpu lines", "[Parser]")
+{
+    std::array<std::uint64_t, 16> values {};
+    auto text = "cpu  10 20 30 40\ncpu0 1 2 3 4\n"sv;
+
+    auto line = Gossip::Parser::next_line(text);
+
+    REQUIRE(Gossip::Parser::parse_cpu_line(line, values) == 4);
+    REQUIRE(values[3] == 40);
+
+    line = Gossip::Parser::next_line(text);
+
+    REQUIRE(line == "cpu0 1 2 3 4");
+    REQUIRE(Gossip::Parser::parse_cpu_line(line, values) == 4);
+    REQUIRE(values[0] == 1);
+    REQUIRE(text.empty());
+}
+
+TEST_CASE("Parser extracts loadavg", "[Parser]")
+{
+    Gossip::Parser::Loadavg loadavg;
+
+    REQUIRE(Gossip::Parser::parse_loadavg("0.24 1.50 12.03 3/456 7890\n"sv,
+        loadavg));
+    REQUIRE(loadavg.load_1 == Approx(0.24));
+    REQUIRE(loadavg.load_5 == Approx(1.5));
+    REQUIRE(loadavg.load_15 == Approx(12.03));
+    REQUIRE(loadavg.runnable == 3);
+    REQUIRE(loadavg.threads == 456);
+
+    REQUIRE_FALSE(Gossip::Parser::parse_loadavg("0.24 1.50"sv, loadavg));
+}
+
+TEST_CASE("Parser extracts meminfo keys", "[Parser]")
+{
+    constexpr std::array<std::string_view, 3> keys { "MemTotal", "Cached",
+        "Missing" };
+    std::array<std::uint64_t, 3> values {};
+
+    auto text = "MemTotal:       16318412 kB\n"
+                "MemFree:         1290848 kB\n"
+                "Cached:          6453308 kB\n"
+                "SwapCached:            0 kB\n"sv;
+
+    REQUIRE(Gossip::Parser::parse_meminfo(text, keys, values) == 2);
+    REQUIRE(values[0] == 16318412);
+    REQUIRE(values[1] == 6453308);
+    REQUIRE(values[2] == 0);
+}
+
+TEST_CASE("Parser extracts cgroup flat keyed values", "[Parser]")
+{
+    constexpr std::array<std::string_view, 3> keys { "file", "anon",
+        "missing" };
+    std::array<std::uint64_t, 3> values {};
+
+    auto text = "anon 1048576\n"
+                "file 2097152\n"
+                "anon_thp 0\n"
+                "file_mapped 4096\n"sv;
+
+    REQUIRE(Gossip::Parser::parse_flat_keyed(text, keys, values) == 2);
+    REQUIRE(values[0] == 2097152);
+    REQUIRE(values[1] == 1048576);
+    REQUIRE(values[2] == 0);
+}
+
+TEST_CASE("Parser extracts pressure stall information", "[Parser]")
+{
+    Gossip::Parser::Pressure pressure;
+
+    auto text = "some avg10=1.53 avg60=0.87 avg300=0.22 total=123456\n"
+                "full avg10=0.50 avg60=0.10 avg300=0.00 total=789\n"sv;
+
+    REQUIRE(Gossip::Parser::parse_pressure(text, pressure));
+    REQUIRE(pressure.some_avg10 == Approx(1.53));
+    REQUIRE(pressure.some_total == 123456);
+    REQUIRE(pressure.full_avg10 == Approx(0.5));
+    REQUIRE(pressure.full_total == 789);
+
+    /* cpu.pressure of the root had no full line before 5.13 */
+    REQUIRE(Gossip::Parser::parse_pressure(
+        "some avg10=0.00 avg60=0.00 avg300=0.00 total=5\n"sv, pressure));
+    REQUIRE(pressure.some_total == 5);
+    REQUIRE(pressure.full_total == 0);
+
+    REQUIRE_FALSE(Gossip::Parser::parse_pressure(""sv, pressure));
+    REQUIRE_FALSE(Gossip::Parser::parse_pressure("some avg10=x"sv, pressure));
+}
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Pool.hpp>
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Pool visits every index exactly once", "[Pool]")
+{
+    int jobs = GENERATE(1, 2, 4, 7);
+    std::size_t count = GENERATE(0, 1, 5, 1000);
+
+    Gossip::Pool pool { jobs };
+
+    REQUIRE(pool.size() == jobs);
+
+    /* Run a few times, the pool is reused across ticks */
+    for (int round = 0; round < 3; round++) {
+        std::vector<std::atomic<int>> visits(count);
+        std::atomic<bool> bad_worker = false;
+
+        /* Catch2 assertions aren't thread safe, check afterwards */
+        pool.run(count, [&](int worker, std::size_t index) {
+            if (worker < 0 || worker >= jobs)
+                bad_worker = true;
+
+            visits[index]++;
+        });
+
+        REQUIRE_FALSE(bad_worker);
+
+        for (auto& visit : visits)
+            REQUIRE(visit == 1);
+    }
+}
+
+TEST_CASE("Pool workers steal from busy workers", "[Pool]")
+{
+    Gossip::Pool pool { 4 };
+    std::vector<int> owner(64, -1);
+
+    /* Everything in worker zero's slice is slow */
+    pool.run(owner.size(), [&](int worker, std::size_t index) {
+        if (index < owner.size() / 4)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        owner[index] = worker;
+    });
+
+    int stolen = 0;
+
+    for (std::size_t index = 0; index < owner.size() / 4; index++) {
+        if (owner[index] != 0)
+            stolen++;
+    }
+
+    REQUIRE(stolen > 0);
+}
+
+TEST_CASE("Pool rejects invalid job counts", "[Pool]")
+{
+    REQUIRE_THROWS_AS(Gossip::Pool { 0 }, std::invalid_argument);
+}
@@ -202,5 +202,22 @@ TEST_CASE("Invalid processes don't crash", "[Process]")
         REQUIRE_THROWS_AS(process.extract(), std::runtime_error);
     }
 
+    SECTION("kernel threads stop at `stat'")
+    {
+        const std::filesystem::path base { proc / "2" };
+        std::filesystem::create_directory(base);
+        const std::filesystem::directory_entry entry { base };
+
+        /* No cmdline or smaps_rollup at all, they must not be read */
+        std::ofstream { base / "stat" }
+            << "2 (kthreadd) S 0 0 0 0 -1 2129984 0 0 0 0 0 0 0 0 20 0 1 0 "
+               "1 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0"
+            << std::endl;
+
+        Gossip::Process process { entry };
+
+        REQUIRE_FALSE(process.extract());
+    }
+
     std::filesystem::remove_all("proc");
 }
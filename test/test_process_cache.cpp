@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Process.hpp>
+#include <ProcessCache.hpp>
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+static void write_process(const std::filesystem::path& base,
+    const std::string& name, int starttime, int utime)
+{
+    std::filesystem::create_directories(base);
+
+    std::ofstream cmdline_stream { base / "cmdline" };
+    std::ofstream smaps_stream { base / "smaps_rollup" };
+    std::ofstream stat_stream { base / "stat" };
+
+    cmdline_stream << name;
+
+    smaps_stream << "56011b60e000-7ffcff7ca000 ---p 00000000 00:00 0"
+                    "                   [rollup]\n"
+                    "Rss:                   1 kB\n"
+                    "Pss:                   2 kB\n"
+                 << std::endl;
+
+    stat_stream << "42 (" << name << ") S 1 42 42 0 -1 0 0 0 0 0 " << utime
+                << " 0 0 0 20 0 1 0 " << starttime << " 0 0" << std::endl;
+}
+
+TEST_CASE("Process cache keeps descriptors across ticks", "[ProcessCache]")
+{
+    std::filesystem::current_path(std::filesystem::temp_directory_path());
+    std::filesystem::create_directory("proc");
+
+    const std::filesystem::path proc { std::filesystem::temp_directory_path()
+        / "proc" };
+    const std::filesystem::path base { proc / "42" };
+
+    write_process(base, "first", 100, 5);
+
+    const std::filesystem::directory_entry entry { base };
+    Gossip::ProcessCache cache { proc };
+
+    auto sample = [&]() {
+        std::ostringstream output {};
+        Gossip::Process process { entry, cache };
+
+        cache.begin_tick();
+        process.extract();
+        cache.end_tick();
+
+        output << process;
+
+        return output.str();
+    };
+
+    SECTION("cached output matches uncached output")
+    {
+        std::ostringstream expected {};
+        Gossip::Process process { entry };
+
+        process.extract();
+        expected << process;
+
+        REQUIRE(sample() == expected.str());
+        REQUIRE(sample() == expected.str());
+        REQUIRE(cache.size() == 1);
+    }
+
+    SECTION("counters are resampled, comm is resolved once")
+    {
+        REQUIRE(sample() == "42,first,1,2,5,");
+
+        write_process(base, "renamed", 100, 7);
+
+        REQUIRE(sample() == "42,first,1,2,7,");
+    }
+
+    SECTION("a new starttime means a new process")
+    {
+        REQUIRE(sample() == "42,first,1,2,5,");
+
+        write_process(base, "second", 200, 1);
+
+        REQUIRE(sample() == "42,second,1,2,1,");
+    }
+
+    SECTION("processes not seen during a tick are evicted")
+    {
+        cache.begin_tick();
+        cache.acquire(42);
+        cache.end_tick();
+
+        REQUIRE(cache.size() == 1);
+
+        cache.begin_tick();
+        cache.end_tick();
+
+        REQUIRE(cache.size() == 0);
+    }
+
+    SECTION("files are read through the cache")
+    {
+        Gossip::Parser::Buffer buffer;
+
+        cache.begin_tick();
+        auto& cached = cache.acquire(42);
+
+        REQUIRE(cache.read(cached, Gossip::ProcessCache::File::cmdline, buffer)
+            == "first");
+        REQUIRE(cache.read(cached, Gossip::ProcessCache::File::stat, buffer)
+                    .starts_with("42 (first) S"));
+    }
+
+    std::filesystem::remove_all("proc");
+}
+
+TEST_CASE("Process caches share one descriptor budget", "[ProcessCache]")
+{
+    Gossip::ProcessCache processes { "/proc" };
+    Gossip::ProcessCache threads { "/proc", false };
+
+    auto available = Gossip::ProcessCache::available();
+    auto self = static_cast<int>(getpid());
+
+    processes.begin_tick();
+    processes.acquire(self);
+
+    /* stat and smaps_rollup */
+    REQUIRE(Gossip::ProcessCache::available() == available - 2);
+
+    threads.begin_tick();
+    threads.acquire(self);
+
+    REQUIRE(Gossip::ProcessCache::available() == available - 3);
+
+    processes.begin_tick();
+    processes.end_tick();
+
+    REQUIRE(Gossip::ProcessCache::available() == available - 1);
+}
@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <ProcessTable.hpp>
+#include <catch2/catch.hpp>
+#include <set>
+#include <utility>
+
+TEST_CASE("ProcessTable tells reused PIDs apart", "[ProcessTable]")
+{
+    Gossip::ProcessTable table;
+
+    table.begin_tick();
+
+    auto [state, known] = table.insert(7, 100);
+
+    REQUIRE_FALSE(known);
+    state->total_time = 42;
+
+    REQUIRE(table.insert(7, 100).second);
+    REQUIRE(table.find(7, 100)->total_time == 42);
+    REQUIRE(table.find(7, 200) == nullptr);
+    REQUIRE(table.find(8, 100) == nullptr);
+
+    /* Same PID, started later: a different process */
+    REQUIRE_FALSE(table.insert(7, 200).second);
+    REQUIRE(table.find(7, 200)->total_time == 0);
+    REQUIRE(table.size() == 2);
+}
+
+TEST_CASE("ProcessTable drops what a tick didn't see", "[ProcessTable]")
+{
+    Gossip::ProcessTable table;
+    std::set<std::pair<int, std::uint64_t>> exited;
+    auto end_tick = [&]() {
+        table.end_tick([&](int pid, std::uint64_t starttime, auto& state) {
+            REQUIRE(state.total_time == static_cast<std::uint64_t>(pid));
+            exited.emplace(pid, starttime);
+        });
+    };
+
+    /* Far more than it starts out with room for */
+    table.begin_tick();
+
+    for (int pid = 1; pid <= 5000; pid++)
+        table.insert(pid, 1).first->total_time
+            = static_cast<std::uint64_t>(pid);
+
+    end_tick();
+
+    REQUIRE(exited.empty());
+    REQUIRE(table.size() == 5000);
+
+    table.begin_tick();
+
+    for (int pid = 1; pid <= 5000; pid += 2)
+        REQUIRE(table.insert(pid, 1).second);
+
+    end_tick();
+
+    REQUIRE(exited.size() == 2500);
+    REQUIRE(exited.count({ 2, 1 }));
+    REQUIRE_FALSE(exited.count({ 1, 1 }));
+    REQUIRE(table.size() == 2500);
+    REQUIRE(table.find(2, 1) == nullptr);
+
+    for (int pid = 1; pid <= 5000; pid += 2)
+        REQUIRE(table.find(pid, 1)->total_time
+            == static_cast<std::uint64_t>(pid));
+}
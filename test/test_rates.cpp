@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include "Helpers.hpp"
+#include <Rates.hpp>
+#include <catch2/catch.hpp>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using Test::make_sample;
+
+namespace {
+/* Leaving out the timestamp each line ends with */
+auto lines(const std::string& text) -> std::vector<std::string>
+{
+    auto result = Test::lines(text);
+
+    for (auto& line : result)
+        line.erase(line.rfind(','));
+
+    return result;
+}
+};
+
+TEST_CASE("Rates join each tick with the previous one", "[Rates]")
+{
+    std::vector<std::string_view> fields { "PID", "Comm", "Rss", "Pss",
+        "Total_Process_Time", "Timestamp" };
+    std::ostringstream rates;
+    std::ostringstream events;
+    Gossip::Rates changes { fields, &rates, &events };
+
+    auto second = static_cast<std::uint64_t>(sysconf(_SC_CLK_TCK));
+    std::vector<std::vector<Gossip::Sample>> ticks {
+        { make_sample({ .pid = 7, .starttime = 100, .values = { 1000, 500 } }),
+            make_sample({ .pid = 9, .starttime = 1, .values = { 10, 5 } }) },
+        /* PID 9 was reused, and had to exit for that */
+        { make_sample({ .pid = 7,
+              .starttime = 100,
+              .values = { 3000, 1500 },
+              .total_time = second / 2 }),
+            make_sample({ .pid = 9, .starttime = 2, .values = { 20, 10 } }) },
+    };
+
+    for (std::size_t i = 0; i < ticks.size(); i++) {
+        auto start = static_cast<std::int64_t>(i) * 2000000000;
+
+        changes.write({ 1650000000, 0, start, start, 0, ticks[i] });
+    }
+
+    REQUIRE(lines(rates.str())
+        == std::vector<std::string> {
+            "# PID,Comm,Start_Time,CPU_Percent,Rss_Rate,Pss_Rate",
+            "7,process7,100,25.0,1000.0,500.0" });
+
+    REQUIRE(lines(events.str())
+        == std::vector<std::string> { "# PID,Comm,Start_Time,Event",
+            "9,process9,2,start", "9,process9,1,exit" });
+
+    SECTION("without memory among the fields")
+    {
+        std::vector<std::string_view> cpu { "PID", "Total_Process_Time" };
+        std::ostringstream output;
+        Gossip::Rates cpu_only { cpu, &output, nullptr };
+
+        for (std::size_t i = 0; i < ticks.size(); i++) {
+            auto start = static_cast<std::int64_t>(i) * 2000000000;
+
+            cpu_only.write({ 1650000000, 0, start, start, 0, ticks[i] });
+        }
+
+        REQUIRE(lines(output.str()).at(1) == "7,process7,100,25.0,,");
+    }
+}
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <SampleTable.hpp>
+#include <catch2/catch.hpp>
+#include <string>
+
+TEST_CASE("SampleTable keeps the rows it drops", "[SampleTable]")
+{
+    Gossip::SampleTable table;
+    const std::string name = "a name too long to be kept inline";
+
+    table.reset(4);
+
+    REQUIRE(table.size() == 4);
+    REQUIRE(table.rows()[3].pid == -1);
+
+    for (int i = 0; i < 4; i++) {
+        table[static_cast<std::size_t>(i)].pid = i % 2 ? i : -1;
+        table[static_cast<std::size_t>(i)].comm = name + std::to_string(i);
+    }
+
+    table.compact();
+
+    REQUIRE(table.size() == 2);
+    REQUIRE(table.rows()[0].pid == 1);
+    REQUIRE(table.rows()[0].comm == name + "1");
+    REQUIRE(table.rows()[1].pid == 3);
+
+    /* Whatever was dropped is still there, storage and all */
+    table.reset(4);
+
+    REQUIRE(table.rows()[1].pid == -1);
+    REQUIRE(table.rows()[1].comm == name + "3");
+    REQUIRE(table.rows()[3].comm.capacity() >= name.size());
+}
@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Scanner.hpp>
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+TEST_CASE("Scanner lists PIDs in order", "[Scanner]")
+{
+    const std::filesystem::path root { std::filesystem::temp_directory_path()
+        / "gossip-scanner" };
+
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+
+    for (auto name : { "300", "7", "1000", "42", "self", "1x", "-5", "0" })
+        std::filesystem::create_directory(root / name);
+
+    /* Numbers, but not directories */
+    std::ofstream { root / "99" };
+    std::ofstream { root / "stat" };
+
+    Gossip::Scanner scanner { root };
+
+    REQUIRE(scanner.scan() == std::vector<int> { 7, 42, 300, 1000 });
+    REQUIRE(scanner.previous().empty());
+
+    SECTION("the previous scan is kept around")
+    {
+        std::filesystem::remove(root / "42");
+        std::filesystem::create_directory(root / "8");
+
+        REQUIRE(scanner.scan() == std::vector<int> { 7, 8, 300, 1000 });
+        REQUIRE(scanner.previous() == std::vector<int> { 7, 42, 300, 1000 });
+    }
+
+    SECTION("directories too large for one call")
+    {
+        std::vector<int> expected { 7, 42, 300, 1000 };
+
+        for (int pid = 10000; pid < 15000; pid++) {
+            std::filesystem::create_directory(root / std::to_string(pid));
+            expected.push_back(pid);
+        }
+
+        REQUIRE(scanner.scan() == expected);
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Scanner needs a directory", "[Scanner]")
+{
+    REQUIRE_THROWS_AS(Gossip::Scanner { "/nonexistent/gossip" },
+        std::runtime_error);
+}
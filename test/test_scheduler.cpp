@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Scheduler.hpp>
+#include <array>
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Scheduler parses intervals", "[Scheduler]")
+{
+    REQUIRE(Gossip::Scheduler::parse_interval("1") == 1000ms);
+    REQUIRE(Gossip::Scheduler::parse_interval("30") == 30000ms);
+    REQUIRE(Gossip::Scheduler::parse_interval("2s") == 2000ms);
+    REQUIRE(Gossip::Scheduler::parse_interval("0.25") == 250ms);
+    REQUIRE(Gossip::Scheduler::parse_interval("250ms") == 250ms);
+    REQUIRE(Gossip::Scheduler::parse_interval("1ms") == 1ms);
+
+    REQUIRE_THROWS_AS(
+        Gossip::Scheduler::parse_interval("0"), std::invalid_argument);
+    REQUIRE_THROWS_AS(
+        Gossip::Scheduler::parse_interval("0.5ms"), std::invalid_argument);
+    REQUIRE_THROWS_AS(
+        Gossip::Scheduler::parse_interval("-1"), std::invalid_argument);
+    REQUIRE_THROWS_AS(
+        Gossip::Scheduler::parse_interval("5m"), std::invalid_argument);
+    REQUIRE_THROWS_AS(
+        Gossip::Scheduler::parse_interval("nan"), std::invalid_argument);
+    REQUIRE_THROWS_AS(
+        Gossip::Scheduler::parse_interval("fast"), std::invalid_argument);
+}
+
+TEST_CASE("Scheduler keeps ticks on a fixed grid", "[Scheduler]")
+{
+    constexpr std::int64_t period = 20000000;
+
+    Gossip::Scheduler scheduler { std::chrono::nanoseconds { period } };
+
+    REQUIRE(scheduler.wait() == 0);
+
+    auto first = Gossip::Scheduler::now();
+
+    /* Time spent in each tick doesn't push the following ones back */
+    for (int tick = 1; tick <= 5; tick++) {
+        std::this_thread::sleep_for(5ms);
+
+        REQUIRE(scheduler.wait() == 0);
+        REQUIRE(Gossip::Scheduler::now() - first >= tick * period);
+    }
+
+    REQUIRE(Gossip::Scheduler::now() - first < 6 * period);
+    REQUIRE(scheduler.overruns() == 0);
+}
+
+TEST_CASE("Scheduler skips deadlines a tick overran", "[Scheduler]")
+{
+    constexpr std::int64_t period = 40000000;
+
+    Gossip::Scheduler scheduler { std::chrono::nanoseconds { period } };
+
+    scheduler.wait();
+
+    auto first = Gossip::Scheduler::now();
+
+    std::this_thread::sleep_for(50ms);
+
+    REQUIRE(scheduler.wait() == 1);
+    REQUIRE(Gossip::Scheduler::now() - first >= 2 * period);
+    REQUIRE(scheduler.overruns() == 1);
+    REQUIRE(scheduler.skipped() == 1);
+}
+
+TEST_CASE("Scheduler wakes up early for descriptors", "[Scheduler]")
+{
+    constexpr std::int64_t period = 10000000000;
+
+    Gossip::Scheduler scheduler { std::chrono::nanoseconds { period } };
+    std::array<int, 2> pipe;
+
+    REQUIRE(::pipe(pipe.data()) == 0);
+
+    std::array<pollfd, 1> fds { { { pipe[0], POLLIN, 0 } } };
+
+    REQUIRE(scheduler.wait(fds) == 0);
+
+    auto first = Gossip::Scheduler::now();
+
+    ssize_t written = 0;
+    std::thread writer { [&] {
+        std::this_thread::sleep_for(20ms);
+        written = ::write(pipe[1], "x", 1);
+    } };
+
+    REQUIRE(scheduler.wait(fds) == 0);
+    writer.join();
+
+    REQUIRE(written == 1);
+
+    auto woken = Gossip::Scheduler::now();
+
+    REQUIRE(fds[0].revents & POLLIN);
+    REQUIRE(woken - first < period / 10);
+
+    /* The grid starts over from the wakeup, at the new period */
+    scheduler.retime(20ms);
+
+    char byte;
+
+    REQUIRE(::read(pipe[0], &byte, 1) == 1);
+    REQUIRE(scheduler.wait(fds) == 0);
+    REQUIRE(fds[0].revents == 0);
+    REQUIRE(Gossip::Scheduler::now() - woken >= 20000000);
+    REQUIRE(Gossip::Scheduler::now() - woken < period / 10);
+
+    REQUIRE_THROWS_AS(scheduler.retime(0ms), std::invalid_argument);
+
+    ::close(pipe[0]);
+    ::close(pipe[1]);
+}
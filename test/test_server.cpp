@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include "Helpers.hpp"
+#include <History.hpp>
+#include <Server.hpp>
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+auto query(const std::filesystem::path& path, std::string request)
+    -> std::string
+{
+    sockaddr_un address {};
+    std::string reply;
+    char buffer[256];
+
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    REQUIRE(fd >= 0);
+    REQUIRE(::connect(fd, reinterpret_cast<sockaddr*>(&address),
+                sizeof(address))
+        == 0);
+    REQUIRE(::write(fd, request.data(), request.size())
+        == static_cast<ssize_t>(request.size()));
+
+    for (;;) {
+        auto length = ::read(fd, buffer, sizeof(buffer));
+
+        if (length <= 0)
+            break;
+
+        reply.append(buffer, static_cast<std::size_t>(length));
+    }
+
+    ::close(fd);
+
+    return reply;
+}
+};
+
+TEST_CASE("Server answers queries about the history", "[Server]")
+{
+    const std::filesystem::path path { std::filesystem::temp_directory_path()
+        / "gossip-server.sock" };
+
+    std::vector<std::string_view> fields { "PID", "Comm", "Rss", "Timestamp" };
+    std::vector<Gossip::Sample> samples {
+        Test::make_sample({ .pid = 7, .comm = "init", .values = { 70 } }),
+        Test::make_sample({ .pid = 42, .comm = "server", .values = { 420 } }),
+    };
+
+    Gossip::History history { 10 };
+
+    history.write({ 1650000000, 0, 0, 0, 0, samples });
+    samples[1].values[0] = 500;
+    history.write({ 1650000060, 0, 0, 0, 0, samples });
+
+    Gossip::Server server { path, history, fields };
+
+    SECTION("over the socket")
+    {
+        REQUIRE(query(path, "pid 42\n")
+            == "# PID,Comm,Rss,Timestamp\n"
+               "42,server,420,2022-04-15 05:20:00 +0000\n"
+               "42,server,500,2022-04-15 05:21:00 +0000\n");
+
+        REQUIRE(query(path, "tick 0")
+            == "# PID,Comm,Rss,Timestamp\n"
+               "7,init,70,2022-04-15 05:20:00 +0000\n"
+               "42,server,420,2022-04-15 05:20:00 +0000\n");
+    }
+
+    SECTION("straight from answer()")
+    {
+        std::ostringstream reply;
+
+        server.answer("pid 42 30", reply);
+
+        REQUIRE(reply.str()
+            == "# PID,Comm,Rss,Timestamp\n"
+               "42,server,500,2022-04-15 05:21:00 +0000\n");
+
+        const char* malformed[]
+            = { "", "tick", "tick 2", "pid x", "pid 7 y", "pid 7 0.5", "what" };
+
+        for (auto request : malformed) {
+            reply.str("");
+            server.answer(request, reply);
+
+            REQUIRE(reply.str().rfind("error: ", 0) == 0);
+        }
+    }
+}
+
+TEST_CASE("Server removes its socket when done", "[Server]")
+{
+    const std::filesystem::path path { std::filesystem::temp_directory_path()
+        / "gossip-server-gone.sock" };
+
+    Gossip::History history { 1 };
+
+    {
+        Gossip::Server server { path, history, Gossip::Sample::fields };
+
+        REQUIRE(std::filesystem::is_socket(path));
+    }
+
+    REQUIRE_FALSE(std::filesystem::exists(path));
+}
+
+TEST_CASE("Server only takes over abandoned sockets", "[Server]")
+{
+    const std::filesystem::path path { std::filesystem::temp_directory_path()
+        / "gossip-server-taken.sock" };
+
+    Gossip::History history { 1 };
+    sockaddr_un address {};
+
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str());
+
+    /* Bound but closed, as after a crash */
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    std::filesystem::remove(path);
+    REQUIRE(fd >= 0);
+    REQUIRE(::bind(fd, reinterpret_cast<sockaddr*>(&address),
+                sizeof(address))
+        == 0);
+    ::close(fd);
+
+    {
+        Gossip::Server server { path, history, Gossip::Sample::fields };
+
+        /* Still running, so its clients are left alone */
+        REQUIRE_THROWS_AS(
+            (Gossip::Server { path, history, Gossip::Sample::fields }),
+            std::runtime_error);
+        REQUIRE(query(path, "ticks\n") == "# Tick,Processes,Timestamp\n");
+    }
+
+    REQUIRE_FALSE(std::filesystem::exists(path));
+}
+
+TEST_CASE("Server doesn't wait on clients that don't read", "[Server]")
+{
+    const std::filesystem::path path { std::filesystem::temp_directory_path()
+        / "gossip-server-stuck.sock" };
+
+    /* Far more than the socket buffers hold */
+    std::vector<Gossip::Sample> samples;
+    Gossip::History history { 1 };
+
+    for (int pid = 1; pid <= 50000; pid++)
+        samples.push_back(Test::make_sample({ .pid = pid }));
+
+    history.write({ 1650000000, 0, 0, 0, 0, samples });
+
+    sockaddr_un address {};
+
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    REQUIRE(fd >= 0);
+
+    auto start = std::chrono::steady_clock::now();
+
+    {
+        Gossip::Server server { path, history, Gossip::Sample::fields };
+
+        REQUIRE(::connect(fd, reinterpret_cast<sockaddr*>(&address),
+                    sizeof(address))
+            == 0);
+        REQUIRE(::write(fd, "tick 0\n", 7) == 7);
+
+        /* Let it get stuck sending */
+        std::this_thread::sleep_for(std::chrono::milliseconds { 100 });
+    }
+
+    /* Shutting down didn't wait for the client, nor for the timeout */
+    REQUIRE(std::chrono::steady_clock::now() - start
+        < std::chrono::seconds { 2 });
+
+    ::close(fd);
+}
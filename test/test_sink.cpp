@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Sink.hpp>
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+TEST_CASE("Sink writes whole ticks in order", "[Sink]")
+{
+    auto path = std::filesystem::temp_directory_path() / "sink.csv";
+    std::ostringstream expected;
+
+    {
+        Gossip::Sink sink { path, Gossip::Sink::Policy::block };
+        std::ostream output(&sink);
+
+        for (int tick = 0; tick < 100; tick++) {
+            /* Large enough for the buffer to grow now and then */
+            for (int row = 0; row < tick * 50; row++) {
+                output << tick << "," << row << '\n';
+                expected << tick << "," << row << '\n';
+            }
+
+            output.flush();
+        }
+
+        sink.close();
+
+        REQUIRE(sink.dropped() == 0);
+    }
+
+    std::ifstream input { path };
+    std::ostringstream contents;
+
+    contents << input.rdbuf();
+
+    REQUIRE(contents.str() == expected.str());
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Sink drops ticks when storage stalls", "[Sink]")
+{
+    int fds[2];
+
+    REQUIRE(pipe(fds) == 0);
+
+    /* Bigger than a pipe holds, so the writer thread gets stuck */
+    const std::string tick(256 * 1024, 'x');
+    constexpr int num_ticks = 8;
+
+    Gossip::Sink sink { fds[1], Gossip::Sink::Policy::drop, 1 };
+    std::ostream output(&sink);
+    int restarts = 0;
+
+    sink.on_drop([&restarts] { restarts++; });
+
+    for (int i = 0; i < num_ticks; i++)
+        output << tick << std::flush;
+
+    /* One being written, one queued, nothing else fits */
+    REQUIRE(sink.dropped() >= num_ticks - 2);
+    REQUIRE(restarts == static_cast<int>(sink.dropped()));
+
+    std::size_t total = 0;
+    std::thread reader([&] {
+        char buffer[65536];
+        ssize_t count;
+
+        while ((count = read(fds[0], buffer, sizeof(buffer))) > 0)
+            total += count;
+    });
+
+    sink.close();
+    reader.join();
+    close(fds[0]);
+
+    REQUIRE(total == (num_ticks - sink.dropped()) * tick.size());
+}
+
+TEST_CASE("Sink writes the last of it out even when dropping", "[Sink]")
+{
+    int fds[2];
+
+    REQUIRE(pipe(fds) == 0);
+
+    const std::string tick(256 * 1024, 'x');
+
+    Gossip::Sink sink { fds[1], Gossip::Sink::Policy::drop, 1 };
+    std::ostream output(&sink);
+
+    /* One stuck being written, one queued: the queue is full */
+    output << tick << std::flush;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    output << tick << std::flush;
+
+    auto dropped = sink.dropped();
+
+    output << "last";
+
+    std::thread closer([&sink] { sink.close(); });
+
+    /* Give close() the time to find the queue full */
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::string contents;
+    char buffer[65536];
+    ssize_t count;
+
+    while ((count = read(fds[0], buffer, sizeof(buffer))) > 0)
+        contents.append(buffer, static_cast<std::size_t>(count));
+
+    closer.join();
+    close(fds[0]);
+
+    REQUIRE(sink.dropped() == dropped);
+    REQUIRE(contents.ends_with("last"));
+}
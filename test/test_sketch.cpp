@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Sketch.hpp>
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <random>
+#include <vector>
+
+TEST_CASE("Moments match the textbook formulas", "[Sketch]")
+{
+    std::vector<double> values { 2, 4, 4, 4, 5, 5, 7, 9 };
+    Gossip::Moments moments;
+
+    for (auto value : values)
+        moments.add(value);
+
+    REQUIRE(moments.count() == 8);
+    REQUIRE(moments.min() == 2);
+    REQUIRE(moments.max() == 9);
+    REQUIRE(moments.mean() == Approx(5));
+    REQUIRE(moments.variance() == Approx(32.0 / 7));
+
+    SECTION("merged in two halves")
+    {
+        Gossip::Moments first;
+        Gossip::Moments second;
+
+        for (std::size_t i = 0; i < values.size(); i++)
+            (i < 3 ? first : second).add(values[i]);
+
+        first.merge(second);
+
+        REQUIRE(first.count() == 8);
+        REQUIRE(first.min() == 2);
+        REQUIRE(first.max() == 9);
+        REQUIRE(first.mean() == Approx(moments.mean()));
+        REQUIRE(first.variance() == Approx(moments.variance()));
+    }
+
+    SECTION("a single value has no variance")
+    {
+        Gossip::Moments one;
+
+        one.add(42);
+
+        REQUIRE(one.variance() == 0);
+    }
+}
+
+TEST_CASE("Sketch quantiles are within its accuracy", "[Sketch]")
+{
+    std::mt19937_64 random { 42 };
+    std::lognormal_distribution<double> distribution { 10, 2 };
+    std::vector<double> values;
+    Gossip::Sketch sketch;
+    Gossip::Sketch first;
+    Gossip::Sketch second;
+
+    for (int i = 0; i < 100000; i++) {
+        auto value = distribution(random);
+
+        values.push_back(value);
+        sketch.add(value);
+        (i % 2 ? first : second).add(value);
+    }
+
+    std::sort(values.begin(), values.end());
+    first.merge(second);
+
+    REQUIRE(sketch.count() == values.size());
+    REQUIRE(first.count() == values.size());
+
+    for (auto q : { 0.5, 0.9, 0.95, 0.99, 1.0 }) {
+        auto exact = values[static_cast<std::size_t>(
+            q * static_cast<double>(values.size() - 1))];
+
+        REQUIRE(std::abs(sketch.quantile(q) - exact)
+            <= exact * Gossip::Sketch::accuracy * 1.0001);
+        REQUIRE(first.quantile(q) == sketch.quantile(q));
+    }
+}
+
+TEST_CASE("Sketch memory is bounded", "[Sketch]")
+{
+    Gossip::Sketch sketch;
+
+    /* Far more buckets than it keeps, the lowest ones get folded */
+    double largest = 1;
+
+    for (double value = 1; value < 1e300; value *= 1.5) {
+        sketch.add(value);
+        largest = value;
+    }
+
+    sketch.add(0);
+    sketch.add(-5);
+
+    REQUIRE(sketch.quantile(0) == 0);
+    REQUIRE(sketch.quantile(1) == Approx(largest).epsilon(0.02));
+    REQUIRE(sketch.quantile(0.99) > 1e290);
+}
+
+TEST_CASE("Sketch of nothing", "[Sketch]")
+{
+    Gossip::Sketch sketch;
+
+    REQUIRE(sketch.count() == 0);
+    REQUIRE(sketch.quantile(0.5) == 0);
+}
@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Smaps.hpp>
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+namespace {
+const std::string smaps
+    = "556022e84000-556022e86000 r--p 00000000 fd:01 1234      "
+      "/usr/bin/cat\n"
+      "Size:                  8 kB\n"
+      "KernelPageSize:        4 kB\n"
+      "MMUPageSize:           4 kB\n"
+      "Rss:                   8 kB\n"
+      "Pss:                   4 kB\n"
+      "Private_Dirty:         0 kB\n"
+      "VmFlags: rd mr mw me sd\n"
+      "556022e86000-556022e8b000 r-xp 00002000 fd:01 1234      "
+      "/usr/bin/cat\n"
+      "Size:                 20 kB\n"
+      "Rss:                  16 kB\n"
+      "Pss:                   8 kB\n"
+      "VmFlags: rd ex mr mw me sd\n"
+      "556023a1c000-556023a3d000 rw-p 00000000 00:00 0          [heap]\n"
+      "Size:                132 kB\n"
+      "Rss:                   4 kB\n"
+      "Private_Dirty:         4 kB\n"
+      "7f0c2d400000-7f0c2d500000 rw-p 00000000 00:00 0 \n"
+      "Size:               1024 kB\n"
+      "Rss:                 512 kB\n"
+      "Anonymous:           512 kB\n"
+      "7f0c2d600000-7f0c2d700000 rw-p 00000000 00:00 0\n"
+      "Size:               1024 kB\n"
+      "Swap:                 64 kB\n";
+
+auto index(std::string_view key) -> std::size_t
+{
+    auto& keys = Gossip::Smaps::keys;
+
+    return static_cast<std::size_t>(
+        std::find(keys.begin(), keys.end(), key) - keys.begin());
+}
+
+auto read(Gossip::Smaps& parser, const std::filesystem::path& path) -> bool
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    REQUIRE(fd >= 0);
+
+    auto found = parser.read(fd);
+
+    ::close(fd);
+
+    return found;
+}
+};
+
+TEST_CASE("Smaps adds mappings up by path", "[Smaps]")
+{
+    const std::filesystem::path path { std::filesystem::temp_directory_path()
+        / "gossip-smaps" };
+
+    std::ofstream { path } << smaps;
+
+    /* Small chunks split lines, and keys, in every possible place */
+    auto chunk_size = GENERATE(as<std::size_t> {}, 80, 97, 128, 4096);
+    Gossip::Smaps parser { chunk_size };
+
+    REQUIRE(read(parser, path));
+
+    auto& mappings = parser.mappings();
+
+    REQUIRE(mappings.size() == 3);
+
+    auto& cat = mappings.at("/usr/bin/cat");
+
+    REQUIRE(cat.count == 2);
+    REQUIRE(cat.values[index("Size")] == 28);
+    REQUIRE(cat.values[index("Rss")] == 24);
+    REQUIRE(cat.values[index("Pss")] == 12);
+
+    auto& heap = mappings.at("[heap]");
+
+    REQUIRE(heap.count == 1);
+    REQUIRE(heap.values[index("Private_Dirty")] == 4);
+
+    /* With and without the trailing space after the inode */
+    auto& anon = mappings.at("[anon]");
+
+    REQUIRE(anon.count == 2);
+    REQUIRE(anon.values[index("Size")] == 2048);
+    REQUIRE(anon.values[index("Anonymous")] == 512);
+    REQUIRE(anon.values[index("Swap")] == 64);
+
+    SECTION("what the previous read found is replaced")
+    {
+        std::ofstream { path }
+            << "556023a1c000-556023a3d000 rw-p 00000000 00:00 0 [heap]\n"
+               "Rss:                   8 kB";
+
+        REQUIRE(read(parser, path));
+        REQUIRE(parser.mappings().size() == 1);
+        REQUIRE(parser.mappings().at("[heap]").values[index("Rss")] == 8);
+    }
+
+    SECTION("written one line per mapping")
+    {
+        std::ostringstream output;
+
+        parser.write(output, 42, "now");
+
+        REQUIRE(output.str()
+            == "42,/usr/bin/cat,2,28,24,12,0,0,0,0,0,0,0,0,0,now\n"
+               "42,[anon],2,2048,512,0,0,0,0,0,0,512,64,0,0,now\n"
+               "42,[heap],1,132,4,0,0,0,0,4,0,0,0,0,0,now\n");
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Smaps cuts lines longer than its buffer short", "[Smaps]")
+{
+    const std::filesystem::path path { std::filesystem::temp_directory_path()
+        / "gossip-smaps-long" };
+
+    std::ofstream { path }
+        << "7f0c2d400000-7f0c2d500000 r--p 00000000 fd:01 99 /"
+        << std::string(200, 'x') << "\n"
+        << "Rss:                   4 kB\n";
+
+    Gossip::Smaps parser { 64 };
+
+    REQUIRE(read(parser, path));
+    REQUIRE(parser.mappings().size() == 1);
+    REQUIRE(parser.mappings().begin()->first.starts_with("/xxx"));
+    REQUIRE(parser.mappings().begin()->second.values[index("Rss")] == 4);
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Smaps of nothing", "[Smaps]")
+{
+    const std::filesystem::path path { std::filesystem::temp_directory_path()
+        / "gossip-smaps-empty" };
+
+    std::ofstream { path };
+
+    Gossip::Smaps parser;
+
+    REQUIRE_FALSE(read(parser, path));
+    REQUIRE(parser.mappings().empty());
+
+    std::filesystem::remove(path);
+}
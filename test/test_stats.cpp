@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include "Helpers.hpp"
+#include <Stats.hpp>
+#include <catch2/catch.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Test::split;
+
+TEST_CASE("Stats merge what every thread recorded", "[Stats]")
+{
+    using Gossip::Stats::Counter;
+    using Gossip::Stats::Phase;
+
+    std::ostringstream output;
+    Gossip::Tick tick { 1650000000, 0, 42, 43, 0, {} };
+
+    Gossip::Stats::enable();
+
+    /* Leftovers from other tests */
+    Gossip::Stats::write(output, tick);
+    output.str("");
+
+    Gossip::Stats::write_header(output);
+
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([i] {
+            for (int j = 0; j < 100; j++) {
+                Gossip::Stats::count(Counter::visited);
+                Gossip::Stats::record(Phase::read, 1000 * (i * 100 + j + 1));
+            }
+
+            Gossip::Stats::count(Counter::vanished);
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    Gossip::Stats::write(output, tick);
+    Gossip::Stats::write(output, tick);
+
+    std::istringstream lines { output.str() };
+    std::string header, first, second;
+
+    std::getline(lines, header);
+    std::getline(lines, first);
+    std::getline(lines, second);
+
+    auto names = split(header.substr(2));
+    auto values = split(first);
+    auto empty = split(second);
+
+    REQUIRE(names.size() == values.size());
+    REQUIRE(names.size() == empty.size());
+
+    auto value = [&](const std::vector<std::string>& row, std::string name) {
+        for (std::size_t i = 0; i < names.size(); i++) {
+            if (names[i] == name)
+                return row[i];
+        }
+
+        FAIL("No column " << name);
+        return std::string {};
+    };
+
+    REQUIRE(value(values, "Tick_Start") == "42");
+    REQUIRE(value(values, "Visited") == "400");
+    REQUIRE(value(values, "Vanished") == "4");
+    REQUIRE(value(values, "Skipped") == "0");
+    REQUIRE(value(values, "Read_Count") == "400");
+    REQUIRE(value(values, "Read_Total_ns") == "80200000");
+    REQUIRE(value(values, "Read_Max_ns") == "400000");
+    REQUIRE(value(values, "Timestamp") == "2022-04-15 05:20:00 +0000");
+
+    /* Quantiles are rounded up to a power of two, but never past max */
+    REQUIRE(value(values, "Read_P50_ns") == "262143");
+    REQUIRE(value(values, "Read_P99_ns") == "400000");
+
+    SECTION("each line starts over")
+    {
+        REQUIRE(value(empty, "Visited") == "0");
+        REQUIRE(value(empty, "Read_Count") == "0");
+        REQUIRE(value(empty, "Read_Max_ns") == "0");
+    }
+}
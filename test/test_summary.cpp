@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include "Helpers.hpp"
+#include <Summary.hpp>
+#include <catch2/catch.hpp>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using Test::make_sample;
+
+TEST_CASE("Summary folds ticks into statistics", "[Summary]")
+{
+    std::vector<std::string_view> fields { "PID", "Comm", "Rss", "Pss", "Swap",
+        "Total_Process_Time", "Timestamp" };
+    std::ostringstream output;
+    Gossip::Summary summary { output, fields, 2 };
+
+    auto second = static_cast<std::uint64_t>(sysconf(_SC_CLK_TCK));
+
+    /* Rss, Pss and Swap */
+    std::vector<std::vector<Gossip::Sample>> samples {
+        { make_sample({ .pid = 7, .starttime = 100, .values = { 100, 50, 0 } }),
+            make_sample({ .pid = 9, .starttime = 1, .values = { 10, 5, 0 } }) },
+        /* PID 9 was reused, PID 8 is gone by the next tick */
+        { make_sample({ .pid = 7,
+              .starttime = 100,
+              .values = { 200, 100, 0 },
+              .total_time = second }),
+            make_sample({ .pid = 8, .starttime = 5, .values = { 50, 25, 0 } }),
+            make_sample(
+                { .pid = 9, .starttime = 2, .values = { 20, 10, 0 } }) },
+        { make_sample({ .pid = 7,
+              .starttime = 100,
+              .values = { 300, 150, 0 },
+              .total_time = second * 3 / 2 }),
+            make_sample(
+                { .pid = 9, .starttime = 2, .values = { 40, 20, 0 } }) },
+    };
+
+    for (std::size_t i = 0; i < 2; i++) {
+        auto start = static_cast<std::int64_t>(i) * 1000000000;
+
+        summary.write({ 1650000000, 0, start, start, 0, samples[i] });
+    }
+
+    auto rows = Test::rows(output.str());
+
+    REQUIRE(rows[0].size() == 13);
+
+    /* Every process seen so far: Rss, Pss and Swap each, CPU for PID 7 */
+    REQUIRE(rows.size() == 1 + 3 + 4 + 3 + 3);
+
+    REQUIRE(rows[1][0] == "7");
+    REQUIRE(rows[1][1] == "process7");
+    REQUIRE(rows[1][2] == "100");
+    REQUIRE(rows[1][3] == "Rss");
+    REQUIRE(rows[1][4] == "2");
+    REQUIRE(rows[1][5] == "100.0");
+    REQUIRE(rows[1][6] == "200.0");
+    REQUIRE(rows[1][7] == "150.0");
+    REQUIRE(std::stod(rows[1][8]) == Approx(70.7).epsilon(0.01));
+    REQUIRE(std::stod(rows[1][9]) == Approx(100).epsilon(0.01));
+    /* Ranks round down, of two values P99 is still the lower one */
+    REQUIRE(std::stod(rows[1][11]) == Approx(100).epsilon(0.01));
+
+    REQUIRE(rows[3][3] == "Swap");
+    REQUIRE(rows[3][9] == "0.0");
+
+    /* A whole second of CPU time over a second */
+    REQUIRE(rows[4][3] == "CPU");
+    REQUIRE(rows[4][4] == "1");
+    REQUIRE(std::stod(rows[4][7]) == Approx(100));
+
+    REQUIRE(rows[8][0] == "9");
+    REQUIRE(rows[8][2] == "1");
+    REQUIRE(rows[11][0] == "9");
+    REQUIRE(rows[11][2] == "2");
+
+    SECTION("processes that exited are dropped once written")
+    {
+        output.str("");
+        summary.write({ 1650000060, 0, 2000000000, 2000000000, 0,
+            samples[2] });
+        summary.finish();
+
+        rows = Test::rows(output.str());
+
+        /* PID 9 now has a CPU usage too, if an idle one */
+        REQUIRE(rows.size() == 4 + 4);
+        REQUIRE(rows[0][4] == "3");
+        REQUIRE(rows[0][12] == "2022-04-15 05:21:00 +0000");
+        REQUIRE(std::stod(rows[3][7]) == Approx(75));
+        REQUIRE(rows[4][0] == "9");
+        REQUIRE(rows[4][4] == "2");
+    }
+
+    SECTION("nothing new, nothing written")
+    {
+        output.str("");
+        summary.finish();
+
+        REQUIRE(output.str().empty());
+    }
+}
+
+TEST_CASE("Summary leaves out metrics that weren't collected", "[Summary]")
+{
+    std::vector<std::string_view> fields { "PID", "Swap", "Timestamp" };
+    std::ostringstream output;
+    Gossip::Summary summary { output, fields };
+    std::vector<Gossip::Sample> samples { make_sample(
+        { .pid = 7, .starttime = 100, .values = { 100, 50, 0 } }) };
+
+    summary.write({ 1650000000, 0, 0, 0, 0, samples });
+    summary.finish();
+
+    auto rows = Test::rows(output.str());
+
+    /* Swap is the first value collected */
+    REQUIRE(rows.size() == 2);
+    REQUIRE(rows[1][3] == "Swap");
+    REQUIRE(rows[1][5] == "100.0");
+}
+
+TEST_CASE("Summary finds Swap among every field", "[Summary]")
+{
+    std::ostringstream output;
+    Gossip::Summary summary { output };
+    std::vector<Gossip::Sample> samples { make_sample(
+        { .pid = 7, .starttime = 100, .values = { 100, 50, 0 } }) };
+
+    /* Shared_Hugetlb and Private_Hugetlb come right before Swap */
+    samples[0].num_values = 20;
+    samples[0].values.fill(1);
+    samples[0].values[17] = 42;
+
+    summary.write({ 1650000000, 0, 0, 0, 0, samples });
+    summary.finish();
+
+    auto rows = Test::rows(output.str());
+
+    REQUIRE(rows.at(3)[3] == "Swap");
+    REQUIRE(rows.at(3)[5] == "42.0");
+}
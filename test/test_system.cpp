@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <System.hpp>
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+TEST_CASE("System snapshot extracts its data", "[System]")
+{
+    std::filesystem::current_path(std::filesystem::temp_directory_path());
+    std::filesystem::create_directory("proc");
+
+    const std::filesystem::path proc { std::filesystem::temp_directory_path()
+        / "proc" };
+    const std::filesystem::directory_entry procdir { proc };
+
+    std::ofstream { proc / "cpuinfo" } << "processor\nprocessor\n" << std::endl;
+    std::ofstream { proc / "stat" }
+        << "cpu  1 2 3 4 5 6 7 8 9 10\ncpu0 1 1 1 1 1\ncpu2 2 2 2 2 2\n"
+        << std::endl;
+    std::ofstream { proc / "loadavg" } << "0.5 0.25 2 1/99 1234" << std::endl;
+    std::ofstream { proc / "meminfo" } << "MemTotal:       1000 kB\n"
+                                          "MemFree:         200 kB\n"
+                                          "MemAvailable:    300 kB\n"
+                                          "Slab:             12 kB\n"
+                                       << std::endl;
+
+    Gossip::System system { procdir };
+
+    SECTION("header follows the online CPUs")
+    {
+        std::ostringstream header {};
+
+        system.extract();
+        system.write_header(header);
+
+        REQUIRE(system.changed());
+        REQUIRE(header.str()
+            == "# Total_CPU_Time,CPU_Threads,Load_1,Load_5,Load_15,Runnable,"
+               "Threads,MemTotal,MemFree,MemAvailable,Buffers,Cached,"
+               "SwapCached,SwapTotal,SwapFree,AnonPages,Mapped,Shmem,Slab,"
+               "CPU0_Time,CPU0_Idle,CPU2_Time,CPU2_Idle,Tick_Start,Tick_End,"
+               "Skipped,Timestamp\n");
+    }
+
+    SECTION("extracting data initializes relevant fields")
+    {
+        std::ostringstream output {};
+
+        system.extract();
+        output << system;
+
+        REQUIRE(output.str()
+            == "55,2,0.5,0.25,2,1,99,1000,200,300,0,0,0,0,0,0,0,0,12,"
+               "5,2,10,4,");
+    }
+
+    SECTION("layout is stable across ticks")
+    {
+        system.extract();
+        system.extract();
+
+        REQUIRE_FALSE(system.changed());
+    }
+
+    std::filesystem::remove_all("proc");
+}
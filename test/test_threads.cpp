@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Threads.hpp>
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+auto write_thread(const std::filesystem::path& root, int pid, int tid,
+    std::string name, std::uint64_t utime) -> void
+{
+    auto base = root / std::to_string(pid) / "task" / std::to_string(tid);
+
+    std::filesystem::create_directories(base);
+
+    std::ofstream { base / "stat" }
+        << tid << " (" << name << ") S 1 1 1 0 -1 4194560 0 0 0 0 " << utime
+        << " 1 0 0 20 0 1 0 100 0 0" << std::endl;
+}
+};
+
+TEST_CASE("Threads reads every task of a process", "[Threads]")
+{
+    const std::filesystem::path root { std::filesystem::temp_directory_path()
+        / "gossip-threads" };
+
+    std::filesystem::remove_all(root);
+
+    write_thread(root, 7, 7, "server", 10);
+    write_thread(root, 7, 9, "worker 1", 20);
+    write_thread(root, 7, 8, "worker 0", 30);
+
+    Gossip::Threads threads { root, 7 };
+
+    REQUIRE(threads.scan() == 3);
+
+    for (std::size_t i = 0; i < 3; i++)
+        threads.extract(i);
+
+    threads.finish();
+
+    std::ostringstream output;
+
+    threads.write(output, "now");
+
+    REQUIRE(output.str()
+        == "7,7,server,11,now\n"
+           "7,8,worker 0,31,now\n"
+           "7,9,worker 1,21,now\n");
+
+    SECTION("threads come and go")
+    {
+        std::filesystem::remove_all(root / "7" / "task" / "8");
+        write_thread(root, 7, 10, "worker 2", 40);
+
+        REQUIRE(threads.scan() == 3);
+        REQUIRE(threads.threads()[2].tid == 10);
+    }
+
+    SECTION("a thread exiting after the scan is left out")
+    {
+        Gossip::Threads fresh { root, 7 };
+
+        REQUIRE(fresh.scan() == 3);
+
+        std::filesystem::remove_all(root / "7" / "task" / "8");
+
+        for (std::size_t i = 0; i < 3; i++)
+            fresh.extract(i);
+
+        output.str("");
+        fresh.write(output, "now");
+
+        REQUIRE(output.str()
+            == "7,7,server,11,now\n"
+               "7,9,worker 1,21,now\n");
+    }
+
+    SECTION("the process exits, and its PID is reused")
+    {
+        std::filesystem::remove_all(root / "7");
+
+        REQUIRE(threads.scan() == 0);
+
+        write_thread(root, 7, 7, "other", 1);
+
+        REQUIRE(threads.scan() == 1);
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Threads of our own process", "[Threads]")
+{
+    std::thread helper { [] { ::usleep(100000); } };
+
+    Gossip::Threads threads { "/proc", getpid() };
+
+    REQUIRE(threads.scan() >= 2);
+
+    helper.join();
+}
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include "Helpers.hpp"
+#include <Top.hpp>
+#include <catch2/catch.hpp>
+#include <stdexcept>
+#include <vector>
+
+
+TEST_CASE("Top keeps the heaviest of what it's offered", "[Top]")
+{
+    auto fields = Gossip::Fields::Selection::parse("PID,Rss,Pss");
+    Gossip::Top top { 2, "pss", fields };
+
+    /* Bounds as stat would give them, resident sets for Pss */
+    std::vector<Gossip::Top::Candidate> candidates {
+        { 5, 0, 0, 300 },
+        { 3, 0, 0, 900 },
+        { -1, 0, 0, 5000 },
+        { 4, 0, 0, 700 },
+        { 6, 0, 0, 100 },
+        { 2, 0, 0, 700 },
+    };
+
+    top.rank(candidates);
+
+    REQUIRE(candidates.size() == 5);
+    REQUIRE(candidates[0].pid == 3);
+    REQUIRE(candidates[1].pid == 2);
+    REQUIRE(candidates[2].pid == 4);
+    REQUIRE(top.missing() == 2);
+    REQUIRE(top.contends(0));
+
+    top.offer(
+        Test::make_sample({ .pid = 3, .values = { 900, 200 } }), candidates[0]);
+    top.offer(
+        Test::make_sample({ .pid = 2, .values = { 700, 600 } }), candidates[1]);
+
+    REQUIRE(top.missing() == 0);
+
+    /* Nobody resident for less than the lightest Pss so far can make it */
+    REQUIRE(top.contends(201));
+    REQUIRE_FALSE(top.contends(200));
+
+    top.offer(
+        Test::make_sample({ .pid = 4, .values = { 700, 400 } }), candidates[2]);
+
+    REQUIRE_FALSE(top.contends(400));
+    REQUIRE_FALSE(top.contends(candidates[3].bound));
+
+    Gossip::SampleTable samples;
+
+    top.take(samples);
+
+    REQUIRE(samples.size() == 2);
+    REQUIRE(samples.rows()[0].pid == 2);
+    REQUIRE(samples.rows()[1].pid == 4);
+    REQUIRE(top.missing() == 2);
+}
+
+TEST_CASE("Top only ranks by what is collected", "[Top]")
+{
+    auto fields = Gossip::Fields::Selection::parse("PID,Rss,Timestamp");
+
+    REQUIRE_NOTHROW(Gossip::Top { 1, "rss", fields });
+    REQUIRE_NOTHROW(Gossip::Top { 1, "cpu", fields });
+    REQUIRE_THROWS_AS((Gossip::Top { 1, "pss", fields }),
+        std::invalid_argument);
+    REQUIRE_THROWS_AS((Gossip::Top { 1, "vss", fields }),
+        std::invalid_argument);
+}
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include "Helpers.hpp"
+#include <Fields.hpp>
+#include <Sample.hpp>
+#include <Trigger.hpp>
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+
+TEST_CASE("Memory trigger fires on little MemAvailable", "[Trigger]")
+{
+    const std::filesystem::path root { std::filesystem::temp_directory_path()
+        / "gossip-trigger" };
+
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+
+    Gossip::MemoryTrigger trigger { root, 1000 };
+    Gossip::Tick tick;
+
+    std::ofstream { root / "meminfo" } << "MemTotal: 8000 kB\n"
+                                          "MemAvailable: 4000 kB"
+                                       << std::endl;
+
+    REQUIRE(trigger.name() == "memory");
+    REQUIRE(trigger.fd() < 0);
+    REQUIRE_FALSE(trigger.fired(tick));
+
+    std::ofstream { root / "meminfo" } << "MemTotal: 8000 kB\n"
+                                          "MemAvailable: 999 kB"
+                                       << std::endl;
+
+    REQUIRE(trigger.fired(tick));
+
+    /* Kernels too old to tell never fire */
+    std::ofstream { root / "meminfo" } << "MemTotal: 8000 kB" << std::endl;
+
+    REQUIRE_FALSE(trigger.fired(tick));
+
+    std::filesystem::remove_all(root);
+}
+
+TEST_CASE("Growth trigger fires on Rss growing in one tick", "[Trigger]")
+{
+    auto fields = Gossip::Fields::Selection::parse("PID,Comm,Rss");
+    Gossip::GrowthTrigger trigger { fields.names(), 100 };
+    std::vector<Gossip::Sample> samples { Test::make_sample(
+        { .pid = 7, .starttime = 1, .values = { 500 } }) };
+    Gossip::Tick tick;
+
+    tick.samples = samples;
+
+    REQUIRE_FALSE(trigger.fired(tick));
+
+    samples[0].values[0] = 599;
+
+    REQUIRE_FALSE(trigger.fired(tick));
+
+    samples[0].values[0] = 699;
+
+    REQUIRE(trigger.fired(tick));
+
+    /* A newcomer, or one reusing a PID, had nothing to grow from */
+    samples = {
+        Test::make_sample({ .pid = 7, .starttime = 2, .values = { 5000 } }),
+        Test::make_sample({ .pid = 8, .starttime = 1, .values = { 5000 } }),
+    };
+    tick.samples = samples;
+
+    REQUIRE_FALSE(trigger.fired(tick));
+
+    REQUIRE_THROWS_AS((Gossip::GrowthTrigger { Gossip::Fields::Selection::parse(
+                                                   "PID,Pss")
+                                                   .names(),
+                          100 }),
+        std::invalid_argument);
+}
+
+TEST_CASE("Pressure trigger needs a PSI file", "[Trigger]")
+{
+    REQUIRE_THROWS_AS((Gossip::PressureTrigger { "/nonexistent/memory",
+                          "some 150000 1000000" }),
+        std::runtime_error);
+}
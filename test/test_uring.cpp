@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-3.0
+/*
+ * Test cases
+ *
+ * Copyright (C) 2021-2022 Felipe Balbi <felipe@balbi.sh>
+ */
+#include <Uring.hpp>
+#include <array>
+#include <catch2/catch.hpp>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <unistd.h>
+
+TEST_CASE("Uring batches reads", "[Uring]")
+{
+    Gossip::Uring ring { 8 };
+
+    /* Not every kernel, or sandbox, lets us use io_uring */
+    if (!ring.available()) {
+        WARN("io_uring unavailable, skipping");
+        return;
+    }
+
+    std::filesystem::current_path(std::filesystem::temp_directory_path());
+    std::filesystem::create_directory("proc");
+
+    const std::filesystem::path proc { std::filesystem::temp_directory_path()
+        / "proc" };
+
+    std::ofstream { proc / "a" } << "first file";
+    std::ofstream { proc / "b" } << "second file";
+
+    int fds[] = { ::open((proc / "a").c_str(), O_RDONLY),
+        ::open((proc / "b").c_str(), O_RDONLY) };
+    std::array<std::array<char, 64>, 2> buffers;
+    std::array<int, 2> results { -1, -1 };
+
+    REQUIRE(ring.capacity() >= 8);
+
+    /* Read both twice from offset zero, as the collector does every tick */
+    for (int round = 0; round < 2; round++) {
+        for (std::size_t i = 0; i < 2; i++)
+            REQUIRE(ring.read(fds[i], buffers[i].data(), buffers[i].size(), 0,
+                i));
+
+        unsigned completed = 0;
+
+        while (completed < 2) {
+            REQUIRE(ring.submit(1));
+            completed += ring.reap([&](std::uint64_t user_data, int result) {
+                results[user_data] = result;
+            });
+        }
+
+        REQUIRE(std::string_view(buffers[0].data(), results[0])
+            == "first file");
+        REQUIRE(std::string_view(buffers[1].data(), results[1])
+            == "second file");
+    }
+
+    SECTION("errors are reported as negative errno")
+    {
+        REQUIRE(ring.read(-1, buffers[0].data(), buffers[0].size(), 0, 0));
+        REQUIRE(ring.submit(1));
+        ring.reap([&](std::uint64_t, int result) { results[0] = result; });
+
+        REQUIRE(results[0] == -EBADF);
+    }
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    std::filesystem::remove_all("proc");
+}